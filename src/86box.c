@@ -103,6 +103,7 @@
 #include <86box/machine_status.h>
 #include <86box/apm.h>
 #include <86box/acpi.h>
+#include <86box/snapshot.h>
 
 // Disable c99-designator to avoid the warnings about int ng
 #ifdef __clang__
@@ -142,6 +143,9 @@ char       rom_path[1024] = { '\0' };     /* (O) full path to ROMs */
 rom_path_t rom_paths      = { "", NULL }; /* (O) full paths to ROMs */
 char       log_path[1024] = { '\0' };     /* (O) full path of logfile */
 char       vm_name[1024]  = { '\0' };     /* (O) display name of the VM */
+int        batch_mode      = 0;           /* (O) run headless and unthrottled */
+uint64_t   batch_budget_ms = 0;           /* (O) emulated time budget in batch mode */
+int        batch_exit_code = 0;           /* exit code reported at the end of batch mode */
 int      do_nothing                             = 0;
 int      dump_missing                           = 0;
 int      clear_cmos                             = 0;
@@ -181,6 +185,8 @@ int      isamem_type[ISAMEM_MAX]                = { 0, 0, 0, 0 }; /* (C) enable
 int      isartc_type                            = 0;              /* (C) enable ISA RTC card */
 int      gfxcard[GFXCARD_MAX]                   = { 0, 0 };       /* (C) graphics/video card */
 int      show_second_monitors                   = 1;              /* (C) show non-primary monitors */
+int      svga_render_threads                    = 0;              /* (C) SVGA render worker threads,
+                                                                         0 = render on the CPU thread */
 int      sound_is_float                         = 1;              /* (C) sound uses FP values */
 int      voodoo_enabled                         = 0;              /* (C) video option */
 int      lba_enhancer_enabled                   = 0;              /* (C) enable Vision Systems LBA Enhancer */
@@ -190,6 +196,8 @@ uint32_t mem_size                               = 0;              /* (C) memory
                                                                          system board)*/
 uint32_t isa_mem_size                           = 0;              /* (C) memory size (ISA Memory Cards) */
 int      cpu_use_dynarec                        = 0;              /* (C) cpu uses/needs Dyna */
+int      dynarec_cache_size                     = 0;              /* (C) dynarec code cache size in MB,
+                                                                         0 = default */
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
@@ -247,6 +255,11 @@ int efscrnsz_y = SCREEN_RES_Y;
 
 static wchar_t mouse_msg[3][200];
 
+static uint64_t batch_elapsed_ms = 0;
+
+static char                snapshot_fn[1024];
+static volatile atomic_int snapshot_pending = 0; /* 1 = save, 2 = load */
+
 static volatile atomic_int do_pause_ack = 0;
 static volatile atomic_int pause_ack = 0;
 
@@ -535,6 +548,7 @@ usage:
             printf("\nUsage: 86box [options] [cfg-file]\n\n");
             printf("Valid options are:\n\n");
             printf("-? or --help            - show this information\n");
+            printf("-B or --batch ms        - run headless and unthrottled for 'ms' ms of emulated time (0 = no limit)\n");
             printf("-C or --config path     - set 'path' to be config file\n");
 #ifdef _WIN32
             printf("-D or --debug           - force debug output logging\n");
@@ -632,6 +646,12 @@ usage:
 #endif
         } else if (!strcasecmp(argv[c], "--noconfirm") || !strcasecmp(argv[c], "-N")) {
             confirm_exit_cmdl = 0;
+        } else if (!strcasecmp(argv[c], "--batch") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            batch_mode = 1;
+            sscanf(argv[++c], "%" PRIu64, &batch_budget_ms);
         } else if (!strcasecmp(argv[c], "--missing") || !strcasecmp(argv[c], "-M")) {
             dump_missing = 1;
         } else if (!strcasecmp(argv[c], "--donothing") || !strcasecmp(argv[c], "-Y")) {
@@ -1331,6 +1351,51 @@ pc_reset_hard(void)
     hard_reset_pending = 1;
 }
 
+/* Request a snapshot to be taken or restored at the next frame boundary.
+   Not offered in the UI or on the command line yet: snapshot_save() and
+   snapshot_load() refuse every machine with a device that has no state
+   hooks, which is still nearly all of them. */
+void
+pc_save_state(const char *fn)
+{
+    snprintf(snapshot_fn, sizeof(snapshot_fn), "%s", fn);
+    atomic_store(&snapshot_pending, 1);
+}
+
+void
+pc_load_state(const char *fn)
+{
+    snprintf(snapshot_fn, sizeof(snapshot_fn), "%s", fn);
+    atomic_store(&snapshot_pending, 2);
+}
+
+/* Take or restore a requested snapshot. Only called from the emulation
+   thread, between two blocks of code. */
+void
+pc_snapshot_poll(void)
+{
+    switch (atomic_exchange(&snapshot_pending, 0)) {
+        case 1:
+            if (snapshot_save(snapshot_fn))
+                pc_log("Saved snapshot %s\n", snapshot_fn);
+            break;
+        case 2:
+            if (snapshot_load(snapshot_fn))
+                pc_log("Restored snapshot %s\n", snapshot_fn);
+            break;
+        default:
+            break;
+    }
+}
+
+/* End a batch mode run, reporting 'code' as the exit code of the process. */
+void
+pc_batch_exit(int code)
+{
+    batch_exit_code = code;
+    plat_power_off();
+}
+
 void
 pc_close(UNUSED(thread_t *ptr))
 {
@@ -1349,6 +1414,10 @@ pc_close(UNUSED(thread_t *ptr))
 
     plat_mouse_capture(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_stats_log();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1421,6 +1490,9 @@ pc_run(void)
         pc_reset_hard_init();
     }
 
+    /* Take or restore a snapshot if one was requested. */
+    pc_snapshot_poll();
+
     /* Run a block of code. */
     startblit();
     cpu_exec((int32_t) cpu_s->rspeed / 100);
@@ -1436,11 +1508,23 @@ pc_run(void)
     joystick_process();
     endblit();
 
+    /* Each block is 10 ms of emulated time, stop once the batch budget is used up. */
+    if (batch_mode && batch_budget_ms && cpu_thread_run) {
+        batch_elapsed_ms += 10;
+        if (batch_elapsed_ms >= batch_budget_ms) {
+            pc_log("Batch mode time budget of %" PRIu64 " ms used up\n", batch_budget_ms);
+            pc_batch_exit(BATCH_EXIT_BUDGET);
+        }
+    }
+
     /* Done with this frame, update statistics. */
     framecount++;
     if (++framecountx >= 100) {
         framecountx = 0;
         frames      = 0;
+
+        /* Write back the hard disk caches that have gone idle. */
+        hdd_image_flush_idle();
     }
 
     if (title_update) {
@@ -1484,10 +1568,10 @@ set_screen_size_monitor(int x, int y, int monitor_index)
         x = 320;
     if (y < 200)
         y = 200;
-    if (x > 2048)
-        x = 2048;
-    if (y > 2048)
-        y = 2048;
+    if (x > VIDEO_MAX_X)
+        x = VIDEO_MAX_X;
+    if (y > VIDEO_MAX_Y)
+        y = VIDEO_MAX_Y;
 
     /* Save the new values as "real" (unscaled) resolution. */
     monitors[monitor_index].mon_unscaled_size_x = x;
@@ -1578,7 +1662,9 @@ set_screen_size_monitor(int x, int y, int monitor_index)
             break;
     }
 
-    plat_resize_request(monitors[monitor_index].mon_scrnsz_x, monitors[monitor_index].mon_scrnsz_y, monitor_index);
+    /* Batch mode has no window to fit to the new size. */
+    if (!batch_mode)
+        plat_resize_request(monitors[monitor_index].mon_scrnsz_x, monitors[monitor_index].mon_scrnsz_y, monitor_index);
 }
 
 void
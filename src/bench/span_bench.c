@@ -0,0 +1,245 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          SVGA span converter micro-benchmark.
+ *
+ *          Checks every vector span converter the host can run against
+ *          the scalar one, over every 16-bit input value and a few odd
+ *          lengths to cover the tails, then reports the time per pixel
+ *          of both. Exits with status 1 if any converter differs from
+ *          the scalar one.
+ *
+ *          Usage: span_bench [-l line pixels] [-r lines]
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/video.h>
+#include <86box/vid_svga_span.h>
+
+/* What vid_svga_span.c needs from the rest of the emulator, filled in the
+   same way video_init() does. */
+uint32_t *video_15to32 = NULL;
+uint32_t *video_16to32 = NULL;
+
+static uint32_t
+bench_calc_15to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 31)) / 31.0) * 255.0);
+    int r = (int) ((((double) ((c >> 10) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16);
+}
+
+static uint32_t
+bench_calc_16to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 63)) / 63.0) * 255.0);
+    int r = (int) ((((double) ((c >> 11) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16);
+}
+
+#define BENCH_PIXELS  65536
+#define BENCH_LENGTHS 4
+
+static const int bench_lengths[BENCH_LENGTHS] = { BENCH_PIXELS, BENCH_PIXELS - 1, 37, 5 };
+
+enum {
+    BENCH_SPAN_8 = 0,
+    BENCH_SPAN_15,
+    BENCH_SPAN_16,
+    BENCH_SPAN_24,
+    BENCH_SPAN_32,
+    BENCH_SPANS
+};
+
+static const char *bench_span_names[BENCH_SPANS] = { "8to32", "15to32", "16to32", "24to32", "32to32" };
+
+static uint8_t  *src;
+static uint32_t *a;
+static uint32_t *b;
+static uint32_t  pal[256];
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec / 1000000000.0);
+}
+
+static int
+bench_has(const svga_span_impl_t *impl, int span)
+{
+    switch (span) {
+        case BENCH_SPAN_8:
+            return impl->span_8to32 != NULL;
+        case BENCH_SPAN_15:
+            return impl->span_15to32 != NULL;
+        case BENCH_SPAN_16:
+            return impl->span_16to32 != NULL;
+        case BENCH_SPAN_24:
+            return impl->span_24to32 != NULL;
+        case BENCH_SPAN_32:
+            return impl->span_32to32 != NULL;
+
+        default:
+            return 0;
+    }
+}
+
+static void
+bench_run(const svga_span_impl_t *impl, int span, uint32_t *p, const uint8_t *s, int n)
+{
+    switch (span) {
+        case BENCH_SPAN_8:
+            impl->span_8to32(p, s, pal, 0xf7, n);
+            break;
+        case BENCH_SPAN_15:
+            impl->span_15to32(p, s, n);
+            break;
+        case BENCH_SPAN_16:
+            impl->span_16to32(p, s, n);
+            break;
+        case BENCH_SPAN_24:
+            impl->span_24to32(p, s, n);
+            break;
+        case BENCH_SPAN_32:
+            impl->span_32to32(p, s, n);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int
+bench_check(const svga_span_impl_t *ref, const svga_span_impl_t *impl, int span)
+{
+    for (int l = 0; l < BENCH_LENGTHS; l++) {
+        const int n = bench_lengths[l];
+
+        memset(a, 0x55, BENCH_PIXELS * sizeof(uint32_t));
+        memset(b, 0x55, BENCH_PIXELS * sizeof(uint32_t));
+        bench_run(ref, span, a, src, n);
+        bench_run(impl, span, b, src, n);
+        if (memcmp(a, b, BENCH_PIXELS * sizeof(uint32_t)))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* Convert the same line over and over, from a different source offset each
+   time so that the loads are not all aligned. Returns ns per pixel. */
+static double
+bench_time(const svga_span_impl_t *impl, int span, int line, int lines)
+{
+    double start;
+    double elapsed;
+
+    start = bench_now();
+    for (int r = 0; r < lines; r++)
+        bench_run(impl, span, a, &src[r & 63], line);
+    elapsed = bench_now() - start;
+
+    return (elapsed * 1000000000.0) / ((double) line * lines);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const svga_span_impl_t *impls[SVGA_SPAN_IMPLS_MAX];
+    int                     num;
+    int                     line   = 1024;
+    int                     lines  = 100000;
+    int                     failed = 0;
+    double                  ref_ns;
+    double                  ns;
+
+    for (int c = 1; c < argc; c++) {
+        if (!strcmp(argv[c], "-l") && ((c + 1) < argc))
+            line = atoi(argv[++c]);
+        else if (!strcmp(argv[c], "-r") && ((c + 1) < argc))
+            lines = atoi(argv[++c]);
+        else {
+            fprintf(stderr, "Usage: %s [-l line pixels] [-r lines]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((line <= 0) || (line > (BENCH_PIXELS - 64)) || (lines <= 0)) {
+        fprintf(stderr, "Line length must be between 1 and %i pixels\n", BENCH_PIXELS - 64);
+        return 2;
+    }
+
+    video_15to32 = (uint32_t *) malloc(65536 * sizeof(uint32_t));
+    video_16to32 = (uint32_t *) malloc(65536 * sizeof(uint32_t));
+    for (uint32_t c = 0; c < 65536; c++) {
+        video_15to32[c] = bench_calc_15to32(c & 0x7fff);
+        video_16to32[c] = bench_calc_16to32(c);
+    }
+    for (int c = 0; c < 256; c++)
+        pal[c] = (c * 0x010203) ^ 0x00a5c3e1;
+
+    /* Enough source bytes for BENCH_PIXELS 32bpp pixels. The first half
+       holds every 16-bit value, the rest is noise. */
+    src = (uint8_t *) malloc(BENCH_PIXELS * 4);
+    a   = (uint32_t *) malloc(BENCH_PIXELS * sizeof(uint32_t));
+    b   = (uint32_t *) malloc(BENCH_PIXELS * sizeof(uint32_t));
+    for (uint32_t c = 0; c < BENCH_PIXELS; c++) {
+        src[c << 1]       = c & 0xff;
+        src[(c << 1) + 1] = c >> 8;
+    }
+    for (uint32_t c = BENCH_PIXELS * 2; c < BENCH_PIXELS * 4; c++)
+        src[c] = (c * 0x9e3779b1) >> 24;
+
+    num = svga_span_get_impls(impls, SVGA_SPAN_IMPLS_MAX);
+
+    printf("%i-pixel lines, %i lines per converter\n", line, lines);
+    for (int span = 0; span < BENCH_SPANS; span++) {
+        ref_ns = bench_time(impls[0], span, line, lines);
+        printf("%-7s %-6s %7.3f ns/pixel\n", bench_span_names[span], impls[0]->name, ref_ns);
+
+        for (int c = 1; c < num; c++) {
+            if (!bench_has(impls[c], span))
+                continue;
+
+            if (!bench_check(impls[0], impls[c], span)) {
+                printf("%-7s %-6s does not match the scalar version\n", bench_span_names[span], impls[c]->name);
+                failed = 1;
+                continue;
+            }
+
+            ns = bench_time(impls[c], span, line, lines);
+            printf("%-7s %-6s %7.3f ns/pixel, %.2fx\n", bench_span_names[span], impls[c]->name, ns, ref_ns / ns);
+        }
+    }
+
+    free(b);
+    free(a);
+    free(src);
+    free(video_16to32);
+    free(video_15to32);
+
+    return failed;
+}
@@ -0,0 +1,277 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Timer queue micro-benchmark.
+ *
+ *          Replays a timer trace recorded by an emulator built with
+ *          ENABLE_TIMER_TRACE against timer.c, or, without a trace,
+ *          runs a synthetic machine with the timers of a busy Socket 7
+ *          configuration, and reports the time spent per timer
+ *          operation.
+ *
+ *          Usage: timer_bench [-r repeats] [-s seconds] [-t timers] [trace]
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/timer.h>
+
+/* What timer.c needs from the rest of the emulator. */
+uint64_t tsc;
+int      cpu_use_dynarec = 0;
+
+void
+update_tsc(void)
+{
+    /* Nothing is behind the TSC here. */
+}
+
+void
+fatal(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+
+    exit(1);
+}
+
+#define BENCH_CPU_MHZ 200
+
+/* Periods of the timers of a busy machine, in microseconds. The ones with
+   restart set are re-armed from the callbacks of other timers as well, like
+   the IDE and network callbacks are from the I/O handlers. */
+static const struct {
+    double period;
+    int    restart;
+} bench_timers[] = {
+    { 54925.0, 0 }, /* PIT channel 0 */
+    { 15.0,    0 }, /* PIT channel 1, refresh */
+    { 2.3,     0 }, /* PIT channel 2, speaker */
+    { 31.778,  0 }, /* SVGA poll, one per scanline */
+    { 20.833,  0 }, /* sound poll, 48 kHz */
+    { 22.676,  0 }, /* Sound Blaster DSP, 44.1 kHz */
+    { 12.5,    0 }, /* OPL */
+    { 976.5,   0 }, /* RTC periodic interrupt */
+    { 1000.0,  0 }, /* USB frame */
+    { 279.4,   0 }, /* ACPI timer */
+    { 86.8,    1 }, /* serial port */
+    { 104.0,   1 }, /* IDE channel 0 */
+    { 104.0,   1 }, /* IDE channel 1 */
+    { 61.0,    1 }, /* floppy */
+    { 50.0,    1 }, /* network receive */
+    { 9.0,     1 }, /* keyboard controller */
+};
+
+#define BENCH_TIMERS (sizeof(bench_timers) / sizeof(bench_timers[0]))
+
+typedef struct bench_timer_t {
+    pc_timer_t timer;
+    uint64_t   period;
+    int        restart;
+} bench_timer_t;
+
+static bench_timer_t *timers;
+static int            timers_num;
+static uint32_t       rng = 0x12345678;
+static uint64_t       ops;
+
+static uint32_t
+bench_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+
+    return rng;
+}
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec / 1000000000.0);
+}
+
+static void
+bench_callback(void *priv)
+{
+    bench_timer_t *t = (bench_timer_t *) priv;
+    bench_timer_t *other;
+
+    timer_advance_u64(&t->timer, t->period);
+    ops += 2;
+
+    /* Every so often, kick one of the I/O timers from here. */
+    if (!(bench_rand() & 7)) {
+        other = &timers[bench_rand() % timers_num];
+        if (other->restart) {
+            timer_set_delay_u64(&other->timer, (bench_rand() % other->period) + 1);
+            ops++;
+        }
+    }
+}
+
+static void
+bench_synthetic(double seconds, int extra)
+{
+    uint64_t end;
+    double   start;
+    double   elapsed;
+
+    timers_num = BENCH_TIMERS + extra;
+    timers     = (bench_timer_t *) calloc(timers_num, sizeof(bench_timer_t));
+
+    timer_init();
+    TIMER_USEC = (uint64_t) BENCH_CPU_MHZ << 32;
+
+    for (int i = 0; i < timers_num; i++) {
+        const double period = (i < (int) BENCH_TIMERS) ? bench_timers[i].period : (double) (1 + (bench_rand() % 5000));
+
+        timers[i].period  = (uint64_t) (period * (double) TIMER_USEC);
+        timers[i].restart = (i < (int) BENCH_TIMERS) ? bench_timers[i].restart : (bench_rand() & 1);
+        timer_add(&timers[i].timer, bench_callback, &timers[i], 0);
+        timer_set_delay_u64(&timers[i].timer, timers[i].period);
+    }
+
+    /* Run the CPU in blocks of a few hundred cycles, as the interpreter
+       and the dynarec do. */
+    end   = (uint64_t) (seconds * 1000000.0 * BENCH_CPU_MHZ);
+    start = bench_now();
+    while (tsc < end) {
+        tsc += 200 + (bench_rand() & 0xff);
+        if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+            timer_process();
+    }
+    elapsed = bench_now() - start;
+
+    printf("%i timers, %.1f emulated seconds: %llu timer operations in %.3f s, %.1f ns per operation\n",
+           timers_num, seconds, (unsigned long long) ops, elapsed, (elapsed * 1000000000.0) / (double) ops);
+
+    timer_close();
+    free(timers);
+}
+
+static void
+bench_replay(const char *fn, int repeats)
+{
+    FILE          *fp;
+    timer_trace_t *trace = NULL;
+    pc_timer_t    *replay;
+    long           size;
+    size_t         count;
+    uint32_t       ids = 0;
+    double         start;
+    double         elapsed;
+
+    fp = fopen(fn, "rb");
+    if (fp == NULL)
+        fatal("Unable to open %s\n", fn);
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    count = size / sizeof(timer_trace_t);
+    trace = (timer_trace_t *) malloc((count ? count : 1) * sizeof(timer_trace_t));
+    if ((trace == NULL) || (fread(trace, sizeof(timer_trace_t), count, fp) != count))
+        fatal("Unable to read %s\n", fn);
+    fclose(fp);
+
+    for (size_t i = 0; i < count; i++) {
+        if (trace[i].id >= ids)
+            ids = trace[i].id + 1;
+    }
+    replay = (pc_timer_t *) calloc(ids ? ids : 1, sizeof(pc_timer_t));
+
+    /* The recorded callbacks re-armed their timers themselves, and those
+       enables are in the trace, so nothing is called back here. */
+    start = bench_now();
+    for (int r = 0; r < repeats; r++) {
+        timer_init();
+        for (uint32_t i = 0; i < ids; i++)
+            timer_add(&replay[i], NULL, NULL, 0);
+
+        for (size_t i = 0; i < count; i++) {
+            switch (trace[i].op) {
+                case TIMER_TRACE_ENABLE:
+                    replay[trace[i].id].ts.ts64 = trace[i].ts;
+                    timer_enable(&replay[trace[i].id]);
+                    break;
+                case TIMER_TRACE_DISABLE:
+                    timer_disable(&replay[trace[i].id]);
+                    break;
+                case TIMER_TRACE_PROCESS:
+                    tsc = trace[i].ts;
+                    timer_process();
+                    break;
+                case TIMER_TRACE_NEW_TSC:
+                    timer_set_new_tsc(trace[i].ts);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        timer_close();
+    }
+    elapsed = bench_now() - start;
+
+    printf("%s: %zu records, %u timers, %i repeats in %.3f s, %.1f ns per record\n",
+           fn, count, ids, repeats, elapsed, (elapsed * 1000000000.0) / ((double) count * repeats));
+
+    free(replay);
+    free(trace);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *fn      = NULL;
+    int         repeats = 10;
+    int         extra   = 0;
+    double      seconds = 10.0;
+
+    for (int c = 1; c < argc; c++) {
+        if (!strcmp(argv[c], "-r") && ((c + 1) < argc))
+            repeats = atoi(argv[++c]);
+        else if (!strcmp(argv[c], "-s") && ((c + 1) < argc))
+            seconds = atof(argv[++c]);
+        else if (!strcmp(argv[c], "-t") && ((c + 1) < argc))
+            extra = atoi(argv[++c]);
+        else if (argv[c][0] != '-')
+            fn = argv[c];
+        else {
+            printf("Usage: %s [-r repeats] [-s seconds] [-t timers] [trace]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (fn != NULL)
+        bench_replay(fn, (repeats > 0) ? repeats : 1);
+    else
+        bench_synthetic(seconds, (extra > 0) ? extra : 0);
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Voodoo triangle throughput micro-benchmark.
+ *
+ *          Replays a synthetic stream of small Gouraud shaded, depth
+ *          tested triangles through voodoo_queue_triangle() and the
+ *          render threads, one frame at a time with a buffer swap in
+ *          between, and reports the triangles per second for each
+ *          render thread count along with the per-thread statistics.
+ *          The triangles are bunched towards the bottom of the screen,
+ *          so that the band split has something to balance.
+ *
+ *          Usage: voodoo_bench [-f frames] [-n triangles] [-s size] [-t threads]
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#ifndef _WIN32
+#    include <sys/mman.h>
+#else
+#    include <windows.h>
+#endif
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_voodoo_common.h>
+#include <86box/vid_voodoo_regs.h>
+#include <86box/vid_voodoo_render.h>
+#include <86box/vid_voodoo_texture.h>
+
+/* What vid_voodoo_render.c and thread.cpp need from the rest of the
+   emulator. Texturing is left off, so the texture cache is reduced to the
+   reference counting the render threads do. */
+rgba8_t  rgb565[0x10000];
+int      tris     = 0;
+uint64_t timer_freq = 1000000000;
+
+void
+fatal(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+
+    exit(1);
+}
+
+uint64_t
+plat_timer_read(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+void
+plat_delay_ms(uint32_t count)
+{
+    const uint64_t end = plat_timer_read() + ((uint64_t) count * 1000000);
+
+    while (plat_timer_read() < end)
+        ;
+}
+
+void
+plat_set_thread_name(void *thread, const char *name)
+{
+    /* Nothing looks at the names here. */
+}
+
+void *
+plat_mmap(size_t size, uint8_t executable)
+{
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_COMMIT, executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE);
+#else
+    void *ret = mmap(0, size, PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0), MAP_ANON | MAP_PRIVATE, -1, 0);
+
+    return (ret == MAP_FAILED) ? NULL : ret;
+#endif
+}
+
+void
+plat_munmap(void *ptr, size_t size)
+{
+#ifdef _WIN32
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+void
+voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
+{
+    params->tex_entry[tmu] = 0;
+    voodoo->texture_cache[tmu][0].refcount++;
+}
+
+#define BENCH_WIDTH  640
+#define BENCH_HEIGHT 480
+
+static voodoo_params_t *tri;
+static uint32_t         rng = 0x12345678;
+
+static uint32_t
+bench_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+
+    return rng;
+}
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec / 1000000000.0);
+}
+
+/* Set up one triangle the way the triangle setup would, with the vertices
+   sorted by Y and in 12.4 fixed point. */
+static void
+bench_make_triangle(voodoo_params_t *params, int size)
+{
+    int x = bench_rand() % (BENCH_WIDTH - size);
+    /* The square of a uniform value piles the triangles up at the bottom. */
+    int y = BENCH_HEIGHT - 1 - size - (int) (((uint64_t) (bench_rand() % (BENCH_HEIGHT - size)) * (bench_rand() % (BENCH_HEIGHT - size))) / (BENCH_HEIGHT - size));
+    int ax = (x << 4) + (bench_rand() % (size << 4));
+    int bx = (x << 4) + (bench_rand() % (size << 4));
+    int cx = (x << 4) + (bench_rand() % (size << 4));
+    int ay = y << 4;
+    int by = ay + (bench_rand() % (size << 4));
+    int cy = ay + (size << 4);
+
+    memset(params, 0, sizeof(voodoo_params_t));
+
+    params->vertexAx = ax;
+    params->vertexAy = ay;
+    params->vertexBx = bx;
+    params->vertexBy = by;
+    params->vertexCx = cx;
+    params->vertexCy = cy;
+    params->sign     = (((bx - ax) * (cy - ay)) - ((cx - ax) * (by - ay))) < 0;
+
+    params->startR = (bench_rand() & 0xff) << 12;
+    params->startG = (bench_rand() & 0xff) << 12;
+    params->startB = (bench_rand() & 0xff) << 12;
+    params->startA = 0xff << 12;
+    params->startZ = (bench_rand() & 0xffff) << 12;
+    params->dRdX   = 0x400;
+    params->dGdY   = 0x400;
+    params->dBdX   = -0x400;
+    params->dZdX   = 0x100;
+    params->dZdY   = 0x100;
+
+    params->fbzMode   = 1 | FBZ_DEPTH_ENABLE | (1 << 5) | FBZ_RGB_WMASK | FBZ_DEPTH_WMASK | FBZ_DITHER;
+    params->clipRight = BENCH_WIDTH;
+    params->clipHighY = BENCH_HEIGHT;
+
+    params->draw_offset   = 0;
+    params->aux_offset    = 2 * 1024 * 1024;
+    params->row_width     = BENCH_WIDTH * 2;
+    params->aux_row_width = BENCH_WIDTH * 2;
+}
+
+static voodoo_t *
+bench_init(int threads)
+{
+    voodoo_t *voodoo = (voodoo_t *) calloc(1, sizeof(voodoo_t));
+
+    voodoo->render_threads = threads;
+    voodoo->h_disp         = BENCH_WIDTH;
+    voodoo->v_disp         = BENCH_HEIGHT;
+    voodoo->fb_mem         = (uint8_t *) calloc(1, 4 * 1024 * 1024);
+    voodoo->fb_mask        = (4 * 1024 * 1024) - 1;
+    /* Clear the depth buffer to the far plane, or nothing passes the test. */
+    memset(&voodoo->fb_mem[2 * 1024 * 1024], 0xff, 2 * 1024 * 1024);
+    voodoo->row_width      = BENCH_WIDTH * 2;
+    voodoo->aux_row_width  = BENCH_WIDTH * 2;
+#ifndef NO_CODEGEN
+    voodoo->use_recompiler = 1;
+    voodoo_codegen_init(voodoo);
+#endif
+
+    voodoo_render_balance_init(voodoo);
+    for (int c = 0; c < threads; c++) {
+        voodoo->wake_render_thread[c]         = thread_create_event();
+        voodoo->render_not_full_event[c]      = thread_create_event();
+        voodoo->render_thread_param[c].voodoo = voodoo;
+        voodoo->render_thread_param[c].idx    = c;
+        voodoo->render_thread_run[c]          = 1;
+        voodoo->render_thread[c]              = thread_create(voodoo_render_thread, &voodoo->render_thread_param[c]);
+    }
+
+    return voodoo;
+}
+
+static void
+bench_close(voodoo_t *voodoo)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 0;
+        thread_set_event(voodoo->wake_render_thread[c]);
+    }
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        thread_wait(voodoo->render_thread[c]);
+        thread_destroy_event(voodoo->wake_render_thread[c]);
+        thread_destroy_event(voodoo->render_not_full_event[c]);
+    }
+#ifndef NO_CODEGEN
+    voodoo_codegen_close(voodoo);
+#endif
+
+    free(voodoo->fb_mem);
+    free(voodoo);
+}
+
+/* Returns triangles per second. */
+static double
+bench_run(int threads, int frames, int count, double *ref)
+{
+    voodoo_t      *voodoo = bench_init(threads);
+    voodoo_stats_t stats;
+    double         start;
+    double         elapsed;
+    double         rate;
+
+    /* One untimed frame, so that the pipelines are compiled and the bands
+       have had a first go at balancing. */
+    for (int i = 0; i < count; i++)
+        voodoo_queue_triangle(voodoo, &tri[i]);
+    voodoo_wait_for_render_thread_idle(voodoo);
+    voodoo_render_balance(voodoo);
+
+    start = bench_now();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < count; i++)
+            voodoo_queue_triangle(voodoo, &tri[i]);
+
+        /* As swapbufferCMD does. */
+        voodoo_wait_for_render_thread_idle(voodoo);
+        voodoo_render_balance(voodoo);
+    }
+    elapsed = bench_now() - start;
+    rate    = ((double) frames * count) / elapsed;
+
+    if (*ref == 0.0)
+        *ref = rate;
+    printf("%2i render threads: %.0f triangles/s, %.2fx\n", threads, rate, rate / *ref);
+
+    voodoo_get_stats(voodoo, &stats);
+    for (int c = 0; c < stats.render_threads; c++) {
+        printf("    thread %2i: lines %3i+, %8llu triangles, busy %7.1f ms\n", c, stats.band_start[c],
+               (unsigned long long) stats.triangles[c], (double) stats.busy_us[c] / 1000.0);
+    }
+#ifndef NO_CODEGEN
+    printf("    pipelines: %llu hits, %llu compiles\n", (unsigned long long) stats.codegen_hits, (unsigned long long) stats.codegen_misses);
+#endif
+
+    bench_close(voodoo);
+
+    return rate;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int    frames  = 100;
+    int    count   = 5000;
+    int    size    = 16;
+    int    threads = 4;
+    double ref     = 0.0;
+
+    for (int c = 1; c < argc; c++) {
+        if (!strcmp(argv[c], "-f") && ((c + 1) < argc))
+            frames = atoi(argv[++c]);
+        else if (!strcmp(argv[c], "-n") && ((c + 1) < argc))
+            count = atoi(argv[++c]);
+        else if (!strcmp(argv[c], "-s") && ((c + 1) < argc))
+            size = atoi(argv[++c]);
+        else if (!strcmp(argv[c], "-t") && ((c + 1) < argc))
+            threads = atoi(argv[++c]);
+        else {
+            fprintf(stderr, "Usage: %s [-f frames] [-n triangles] [-s size] [-t threads]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((frames <= 0) || (count <= 0) || (size < 1) || (size > 64) || (threads < 1) || (threads > VOODOO_MAX_RENDER_THREADS)) {
+        fprintf(stderr, "Triangle size must be between 1 and 64, threads between 1 and %i\n", VOODOO_MAX_RENDER_THREADS);
+        return 2;
+    }
+
+    for (uint32_t c = 0; c < 0x10000; c++) {
+        rgb565[c].r = (c >> 8) & 0xf8;
+        rgb565[c].g = (c >> 3) & 0xfc;
+        rgb565[c].b = (c << 3) & 0xf8;
+        rgb565[c].a = 0xff;
+    }
+
+    tri = (voodoo_params_t *) malloc(count * sizeof(voodoo_params_t));
+    for (int i = 0; i < count; i++)
+        bench_make_triangle(&tri[i], size);
+
+    printf("%i triangles of up to %ix%i pixels per frame, %i frames\n", count, size, size, frames);
+    for (int t = 1; t <= threads; t <<= 1) {
+        bench_run(t, frames, count, &ref);
+        if ((t < threads) && ((t << 1) > threads))
+            bench_run(threads, frames, count, &ref);
+    }
+
+    free(tri);
+
+    return 0;
+}
@@ -57,7 +57,8 @@ codegen_set_loop_start(ir_data_t *ir, int first_instruction)
 int has_ea;
 
 codeblock_t *codeblock;
-uint16_t    *codeblock_hash;
+uint32_t    *codeblock_hash;
+int          codeblock_nr = BLOCK_SIZE;
 
 void (*codegen_timing_start)(void);
 void (*codegen_timing_prefix)(uint8_t prefix, uint32_t fetchdat);
@@ -41,7 +41,7 @@ typedef struct codeblock_t {
 
     /*Pointers for codeblock tree, used to search for blocks when hash lookup
       fails.*/
-    uint16_t parent, left, right;
+    uint32_t parent, left, right;
 
     uint8_t *data;
 
@@ -51,8 +51,8 @@ typedef struct codeblock_t {
     /*Previous and next pointers, for the codeblock list associated with
       each physical page. Two sets of pointers, as a codeblock can be
       present in two pages.*/
-    uint16_t prev, next;
-    uint16_t prev_2, next_2;
+    uint32_t prev, next;
+    uint32_t prev_2, next_2;
 
     /*First mem_block_t used by this block. Any subsequent mem_block_ts
       will be in the list starting at head_mem_block->next.*/
@@ -60,8 +60,11 @@ typedef struct codeblock_t {
 } codeblock_t;
 
 extern codeblock_t *codeblock;
+/*Number of code blocks in the pool. BLOCK_SIZE blocks are used with the default
+  code cache size and the pool scales with it*/
+extern int codeblock_nr;
 
-extern uint16_t *codeblock_hash;
+extern uint32_t *codeblock_hash;
 
 extern uint8_t *block_write_data;
 
@@ -81,6 +84,8 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block has been executed since the eviction clock hand last passed it*/
+#define CODEBLOCK_REFERENCED 0x100
 
 #define BLOCK_PC_INVALID        0xffffffff
 
@@ -157,7 +162,7 @@ codeblock_tree_add(codeblock_t *new_block)
 static inline void
 codeblock_tree_delete(codeblock_t *block)
 {
-    uint16_t     parent_nr = block->parent;
+    uint32_t     parent_nr = block->parent;
     codeblock_t *parent;
 
     if (block->parent)
@@ -170,7 +175,7 @@ codeblock_tree_delete(codeblock_t *block)
         if (!parent)
             pages[block->phys >> 12].head = BLOCK_INVALID;
         else {
-            uint16_t block_nr = get_block_nr(block);
+            uint32_t block_nr = get_block_nr(block);
 
             if (parent->left == block_nr)
                 parent->left = BLOCK_INVALID;
@@ -184,7 +189,7 @@ codeblock_tree_delete(codeblock_t *block)
             pages[block->phys >> 12].head                   = block->right;
             codeblock[pages[block->phys >> 12].head].parent = BLOCK_INVALID;
         } else {
-            uint16_t block_nr = get_block_nr(block);
+            uint32_t block_nr = get_block_nr(block);
 
             if (parent->left == block_nr) {
                 parent->left                   = block->right;
@@ -202,7 +207,7 @@ codeblock_tree_delete(codeblock_t *block)
             pages[block->phys >> 12].head                   = block->left;
             codeblock[pages[block->phys >> 12].head].parent = BLOCK_INVALID;
         } else {
-            uint16_t block_nr = get_block_nr(block);
+            uint32_t block_nr = get_block_nr(block);
 
             if (parent->left == block_nr) {
                 parent->left                   = block->left;
@@ -219,7 +224,7 @@ codeblock_tree_delete(codeblock_t *block)
         codeblock_t *lowest = &codeblock[block->right];
         codeblock_t *highest;
         codeblock_t *old_parent;
-        uint16_t     lowest_nr;
+        uint32_t     lowest_nr;
 
         while (lowest->left)
             lowest = &codeblock[lowest->left];
@@ -231,7 +236,7 @@ codeblock_tree_delete(codeblock_t *block)
         if (!parent_nr)
             pages[block->phys >> 12].head = lowest_nr;
         else {
-            uint16_t block_nr = get_block_nr(block);
+            uint32_t block_nr = get_block_nr(block);
 
             if (parent->left == block_nr)
                 parent->left = lowest_nr;
@@ -308,9 +313,18 @@ extern void codegen_check_seg_read(codeblock_t *block, struct ir_data_t *ir, x86
 extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Evict a code block to free memory, using a clock (second chance) policy so that
+  recently executed blocks survive. This is quite expensive, and will only be called
+  when the block pool or the allocator is out of memory*/
+extern void codegen_evict_next_block(int required_mem_block);
+/*Evict a specific code block, recording it so that it can be detected if the same
+  code is recompiled later*/
+extern void codegen_evict_block(codeblock_t *block);
+
+/*Number of code blocks evicted due to cache pressure, and number of blocks that had
+  to be recompiled after being evicted*/
+extern uint32_t codegen_evicted_blocks;
+extern uint32_t codegen_evicted_recompiles;
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
@@ -21,37 +21,114 @@
 typedef struct mem_block_t {
     uint32_t offset; /*Offset into mem_block_alloc*/
     uint32_t next;
-    uint16_t code_block;
+    uint32_t code_block;
 } mem_block_t;
 
-static mem_block_t mem_blocks[MEM_BLOCK_NR];
-static uint32_t    mem_block_free_list;
-static uint8_t    *mem_block_alloc = NULL;
+static mem_block_t *mem_blocks = NULL;
+static uint32_t     mem_block_committed; /*Number of blocks backed by memory*/
+static uint32_t     mem_block_free_list;
+static uint32_t     mem_block_evict_hand = 0;
+static uint8_t     *mem_block_alloc      = NULL;
 
-int codegen_allocator_usage = 0;
+int      codegen_allocator_usage  = 0;
+uint32_t codegen_allocator_blocks = 0;
 
-void
-codegen_allocator_init(void)
+static uint8_t *
+codegen_allocator_reserve(size_t size)
 {
+    uint8_t *arena;
+
 #if defined WIN32 || defined _WIN32 || defined _WIN32
-    mem_block_alloc = VirtualAlloc(NULL, MEM_BLOCK_NR * MEM_BLOCK_SIZE, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+    arena = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_EXECUTE_READWRITE);
     /* TODO: check deployment target: older Intel-based versions of macOS don't play
        nice with MAP_JIT. */
 #elif defined(__APPLE__) && defined(MAP_JIT)
-    mem_block_alloc = mmap(0, MEM_BLOCK_NR * MEM_BLOCK_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE | MAP_JIT, -1, 0);
+    /*MAP_JIT regions can not have their protection changed later, so map the
+      whole arena up front and leave committing pages to the OS*/
+    arena = mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE | MAP_JIT, -1, 0);
+    if (arena == MAP_FAILED)
+        arena = NULL;
 #else
-    mem_block_alloc = mmap(0, MEM_BLOCK_NR * MEM_BLOCK_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, 0);
+    arena = mmap(0, size, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (arena == MAP_FAILED)
+        arena = NULL;
 #endif
 
-    for (uint32_t c = 0; c < MEM_BLOCK_NR; c++) {
-        mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
+    return arena;
+}
+
+/*Commit the next MEM_BLOCK_GROW blocks of the arena and add them to the free
+  list. Returns 0 once the arena is fully committed.*/
+static int
+codegen_allocator_grow(void)
+{
+    uint32_t start = mem_block_committed;
+    uint32_t nr    = codegen_allocator_blocks - start;
+
+    if (!nr)
+        return 0;
+    if (nr > MEM_BLOCK_GROW)
+        nr = MEM_BLOCK_GROW;
+
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+    if (!VirtualAlloc(&mem_block_alloc[start * MEM_BLOCK_SIZE], nr * MEM_BLOCK_SIZE, MEM_COMMIT, PAGE_EXECUTE_READWRITE))
+        return 0;
+#elif !(defined(__APPLE__) && defined(MAP_JIT))
+    if (mprotect(&mem_block_alloc[start * MEM_BLOCK_SIZE], nr * MEM_BLOCK_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC))
+        return 0;
+#endif
+
+    for (uint32_t c = start; c < start + nr; c++) {
         mem_blocks[c].code_block = BLOCK_INVALID;
-        if (c < MEM_BLOCK_NR - 1)
+        if (c < start + nr - 1)
             mem_blocks[c].next = c + 2;
         else
-            mem_blocks[c].next = 0;
+            mem_blocks[c].next = mem_block_free_list;
+    }
+    mem_block_free_list = start + 1;
+    mem_block_committed += nr;
+
+    return 1;
+}
+
+void
+codegen_allocator_init(void)
+{
+    uint32_t nr = MEM_BLOCK_NR_DEFAULT;
+
+    if (dynarec_cache_size > 0)
+        nr = (uint32_t) (((uint64_t) dynarec_cache_size << 20) / MEM_BLOCK_SIZE);
+    nr &= ~(MEM_BLOCK_GROW - 1);
+    if (nr < MEM_BLOCK_NR_MIN)
+        nr = MEM_BLOCK_NR_MIN;
+    if (nr > MEM_BLOCK_NR_MAX)
+        nr = MEM_BLOCK_NR_MAX;
+
+    /*Fall back to smaller arenas if the address space can not be reserved*/
+    while (!(mem_block_alloc = codegen_allocator_reserve((size_t) nr * MEM_BLOCK_SIZE))) {
+        if (nr <= MEM_BLOCK_NR_MIN)
+            fatal("codegen_allocator_init: unable to reserve code cache\n");
+        nr = (nr >> 1) & ~(MEM_BLOCK_GROW - 1);
+        if (nr < MEM_BLOCK_NR_MIN)
+            nr = MEM_BLOCK_NR_MIN;
     }
-    mem_block_free_list = 1;
+
+    mem_blocks = malloc(nr * sizeof(mem_block_t));
+    if (!mem_blocks)
+        fatal("codegen_allocator_init: out of memory\n");
+    for (uint32_t c = 0; c < nr; c++) {
+        mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
+        mem_blocks[c].code_block = BLOCK_INVALID;
+        mem_blocks[c].next       = 0;
+    }
+
+    codegen_allocator_blocks = nr;
+    mem_block_committed      = 0;
+    mem_block_free_list      = 0;
+    mem_block_evict_hand     = 0;
+
+    if (!codegen_allocator_grow())
+        fatal("codegen_allocator_init: unable to commit code cache\n");
 }
 
 mem_block_t *
@@ -61,12 +138,25 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     uint32_t     block_nr;
 
     while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
+        /*Grow the arena before evicting anything*/
+        if (codegen_allocator_grow())
+            break;
 
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
+        /*Advance the clock hand and free the owning code block of the first
+          memory block whose owner has not been executed since the last pass*/
+        block_nr = mem_block_evict_hand;
+        if (++mem_block_evict_hand >= mem_block_committed)
+            mem_block_evict_hand = 0;
+        block = &mem_blocks[block_nr];
+
+        if (block->code_block && block->code_block != code_block) {
+            codeblock_t *owner = &codeblock[block->code_block];
+
+            if (owner->flags & CODEBLOCK_REFERENCED)
+                owner->flags &= ~CODEBLOCK_REFERENCED;
+            else if (owner->pc != BLOCK_PC_INVALID)
+                codegen_evict_block(owner);
+        }
     }
 
     /*Remove from free list*/
@@ -12,15 +12,30 @@
 
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv7 is restricted to +/- 32 MB, ARMv8 to +/- 128 MB, x86 to
-  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7*/
+  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7.
+
+  The size of the arena is chosen at startup from the dynarec_cache_size setting.
+  The whole arena is reserved up front so that it stays within jump range, but it
+  is only committed MEM_BLOCK_GROW blocks at a time, as the free list runs out.*/
 #if defined __ARM_EABI__ || defined _ARM_ || defined _M_ARM
-#    define MEM_BLOCK_NR 32768
+#    define MEM_BLOCK_NR_DEFAULT 32768
+#    define MEM_BLOCK_NR_MAX     32768
+#elif defined __aarch64__ || defined _M_ARM64
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     139264
+#elif defined __i386__ || defined _M_IX86
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     262144
 #else
-#    define MEM_BLOCK_NR 131072
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     1048576
 #endif
 
-#define MEM_BLOCK_MASK (MEM_BLOCK_NR - 1)
-#define MEM_BLOCK_SIZE 0x3c0
+/*Blocks committed at a time. Keeps every step page aligned.*/
+#define MEM_BLOCK_GROW   8192
+#define MEM_BLOCK_NR_MIN MEM_BLOCK_GROW
+
+#define MEM_BLOCK_SIZE   0x3c0
 
 void codegen_allocator_init(void);
 /*Allocate a mem_block_t, and the associated backing memory.
@@ -35,5 +50,7 @@ uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
 extern int codegen_allocator_usage;
+/*Size of the reserved arena, in memory blocks*/
+extern uint32_t codegen_allocator_blocks;
 
 #endif
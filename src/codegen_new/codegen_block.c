@@ -57,18 +57,30 @@ static int      last_ssegs;
 uint32_t instr_counts[256 * 256];
 #endif
 
-static uint16_t block_free_list;
+static uint32_t block_free_list;
 static void     delete_block(codeblock_t *block);
 static void     delete_dirty_block(codeblock_t *block);
 
+/*Clock hand for code block eviction*/
+static int block_evict_hand = 1;
+
+/*Physical addresses of recently evicted blocks, used to count recompilations
+  caused by eviction*/
+#define EVICT_GHOST_SIZE 4096
+#define EVICT_GHOST_MASK (EVICT_GHOST_SIZE - 1)
+static uint32_t evict_ghost[EVICT_GHOST_SIZE];
+
+uint32_t codegen_evicted_blocks     = 0;
+uint32_t codegen_evicted_recompiles = 0;
+
 /*Temporary list of code blocks that have recently been evicted. This allows for
   some historical state to be kept when a block is the target of self-modifying
   code.
 
   The size of this list is limited to DIRTY_LIST_MAX_SIZE blocks. When this is
   exceeded the oldest entry will be moved to the free list.*/
-static uint16_t block_dirty_list_head;
-static uint16_t block_dirty_list_tail;
+static uint32_t block_dirty_list_head;
+static uint32_t block_dirty_list_tail;
 static int      dirty_list_size = 0;
 #define DIRTY_LIST_MAX_SIZE 64
 
@@ -204,7 +216,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_evict_next_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -219,23 +231,45 @@ codegen_init(void)
 {
     codegen_allocator_init();
 
+    /*Keep the ratio of code blocks to memory blocks of the default cache size*/
+    codeblock_nr = (int) (((uint64_t) BLOCK_SIZE * codegen_allocator_blocks) / MEM_BLOCK_NR_DEFAULT);
+    if (codeblock_nr < 0x1000)
+        codeblock_nr = 0x1000;
+
     codegen_backend_init();
     block_free_list = 0;
-    for (uint32_t c = 0; c < BLOCK_SIZE; c++)
+    for (int c = 0; c < codeblock_nr; c++)
         block_free_list_add(&codeblock[c]);
     block_dirty_list_head = block_dirty_list_tail = 0;
     dirty_list_size                               = 0;
+    memset(evict_ghost, 0xff, sizeof(evict_ghost));
 #ifdef DEBUG_EXTRA
     memset(instr_counts, 0, sizeof(instr_counts));
 #endif
 }
 
+/*Report what the IR optimiser and the code cache eviction did this session*/
+void
+codegen_stats_log(void)
+{
+    if (!codegen_ir_stats.uops)
+        return;
+
+    pclog("Dynarec: %" PRIu32 " uOPs generated, %" PRIu32 " folded to constants, %" PRIu32 " immediates propagated, %" PRIu32 " reduced to moves, %" PRIu32 " dead uOPs removed\n",
+          codegen_ir_stats.uops, codegen_ir_stats.consts_folded, codegen_ir_stats.imms_propagated,
+          codegen_ir_stats.moves_simplified, codegen_ir_stats.uops_removed);
+    pclog("Dynarec: %" PRIu32 " redundant loads, %" PRIu32 " redundant stores and %" PRIu32 " dead flag operands eliminated\n",
+          codegen_ir_stats.loads_eliminated, codegen_ir_stats.stores_eliminated, codegen_ir_stats.flags_eliminated);
+    pclog("Dynarec: %" PRIu32 " blocks evicted, %" PRIu32 " recompiled after eviction\n",
+          codegen_evicted_blocks, codegen_evicted_recompiles);
+}
+
 void
 codegen_reset(void)
 {
     int c;
 
-    for (c = 1; c < BLOCK_SIZE; c++) {
+    for (c = 1; c < codeblock_nr; c++) {
         codeblock_t *block = &codeblock[c];
 
         if (block->pc != BLOCK_PC_INVALID) {
@@ -245,12 +279,13 @@ codegen_reset(void)
         }
     }
 
-    memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
-    memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint16_t));
+    memset(codeblock, 0, codeblock_nr * sizeof(codeblock_t));
+    memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint32_t));
+    memset(evict_ghost, 0xff, sizeof(evict_ghost));
     mem_reset_page_blocks();
 
     block_free_list = 0;
-    for (c = 0; c < BLOCK_SIZE; c++) {
+    for (c = 0; c < codeblock_nr; c++) {
         codeblock[c].pc = BLOCK_PC_INVALID;
         block_free_list_add(&codeblock[c]);
     }
@@ -282,8 +317,8 @@ dump_block(void)
 static void
 add_to_block_list(codeblock_t *block)
 {
-    uint16_t block_prev_nr = pages[block->phys >> 12].block;
-    uint16_t block_nr      = get_block_nr(block);
+    uint32_t block_prev_nr = pages[block->phys >> 12].block;
+    uint32_t block_nr      = get_block_nr(block);
 
 #ifndef RELEASE_BUILD
     if (!block->page_mask)
@@ -432,32 +467,50 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_evict_block(codeblock_t *block)
 {
-    int block_nr = rand() & BLOCK_MASK;
+    int ghost = (block->phys >> 4) & EVICT_GHOST_MASK;
 
+    evict_ghost[ghost] = block->phys;
+    codegen_evicted_blocks++;
+
+    delete_block(block);
+}
+
+void
+codegen_evict_next_block(int required_mem_block)
+{
     while (1) {
+        int block_nr = block_evict_hand;
+        if (++block_evict_hand >= codeblock_nr)
+            block_evict_hand = 1;
+
         if (block_nr && block_nr != block_current) {
             codeblock_t *block = &codeblock[block_nr];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
-                delete_block(block);
+                /*Give recently executed blocks a second chance*/
+                if (block->flags & CODEBLOCK_REFERENCED) {
+                    block->flags &= ~CODEBLOCK_REFERENCED;
+                    continue;
+                }
+
+                codegen_evict_block(block);
                 return;
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
 void
 codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_addr))
 {
-    uint16_t block_nr               = page->block;
+    uint32_t block_nr               = page->block;
     int      remove_from_evict_list = 0;
 
     while (block_nr) {
         codeblock_t *block      = &codeblock[block_nr];
-        uint16_t     next_block = block->next;
+        uint32_t     next_block = block->next;
 
         if (*block->dirty_mask & block->page_mask) {
             invalidate_block(block);
@@ -473,7 +526,7 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
 
     while (block_nr) {
         codeblock_t *block      = &codeblock[block_nr];
-        uint16_t     next_block = block->next_2;
+        uint32_t     next_block = block->next_2;
 
         if (*block->dirty_mask2 & block->page_mask2) {
             invalidate_block(block);
@@ -518,6 +571,11 @@ codegen_block_init(uint32_t phys_addr)
     block_num                 = HASH(phys_addr);
     codeblock_hash[block_num] = block_current;
 
+    if (evict_ghost[(phys_addr >> 4) & EVICT_GHOST_MASK] == phys_addr) {
+        evict_ghost[(phys_addr >> 4) & EVICT_GHOST_MASK] = 0xffffffff;
+        codegen_evicted_recompiles++;
+    }
+
     block->ins         = 0;
     block->pc          = cs + cpu_state.pc;
     block->_cs         = cs;
@@ -527,7 +585,7 @@ codegen_block_init(uint32_t phys_addr)
     block->next = block->prev = BLOCK_INVALID;
     block->next_2 = block->prev_2 = BLOCK_INVALID;
     block->page_mask = block->page_mask2 = 0;
-    block->flags                         = CODEBLOCK_STATIC_TOP;
+    block->flags                         = CODEBLOCK_STATIC_TOP | CODEBLOCK_REFERENCED;
     block->status                        = cpu_cur_status;
 
     recomp_page = block->phys & ~0xfff;
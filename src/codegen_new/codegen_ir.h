@@ -4,3 +4,19 @@ ir_data_t *codegen_ir_init(void);
 
 void codegen_ir_set_unroll(int count, int start, int first_instruction);
 void codegen_ir_compile(ir_data_t *ir, codeblock_t *block);
+
+typedef struct codegen_ir_stats_t {
+    uint32_t uops;              /*uOPs generated*/
+    uint32_t consts_folded;     /*uOPs replaced by a constant*/
+    uint32_t imms_propagated;   /*constant register operands replaced by immediates*/
+    uint32_t moves_simplified;  /*operations reduced to a move*/
+    uint32_t loads_eliminated;  /*RAM loads replaced by a move from an earlier load*/
+    uint32_t stores_eliminated; /*constant writes of the value already held*/
+    uint32_t flags_eliminated;  /*flag operands unread under a FLAGS_ZN flags_op*/
+    uint32_t uops_removed;      /*dead uOPs optimised out*/
+} codegen_ir_stats_t;
+
+extern codegen_ir_stats_t codegen_ir_stats;
+
+/*Run the optimisation passes over the uOP list*/
+void codegen_ir_optimise(ir_data_t *ir);
@@ -0,0 +1,495 @@
+#include <stdint.h>
+#include <string.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+
+#include "x86.h"
+#include "x86_flags.h"
+#include "codegen.h"
+#include "codegen_backend.h"
+#include "codegen_ir.h"
+#include "codegen_reg.h"
+
+/*Optimisation passes run over the uOP list before it is handed to the backend.
+
+  Register versions are only single-assignment values between barriers; a
+  barrier may call a function that changes any emulated register in memory, and
+  a jump destination can be reached with a different set of values. A version is
+  therefore only treated as a known constant if the UOP_MOV_IMM that created it
+  is after the most recent barrier or jump destination.
+
+  The passes only rewrite 32-bit operations on registers with a native size of
+  32 bits, so partial register writes and their implicit dependencies on earlier
+  versions are never affected. Register versions that lose their last reader
+  are put on the dead list, so codegen_reg_process_dead_list() can remove their
+  parent uOPs.
+
+  A version on the dead list has not been flagged yet, so a pass may only add
+  readers to a version that still has readers or is required.*/
+
+codegen_ir_stats_t codegen_ir_stats;
+
+static uint8_t uop_is_jump_dest[UOP_NR_MAX];
+
+static int
+uop_is(uop_t *uop, uint32_t type)
+{
+    return (uop->type & UOP_MASK) == (type & UOP_MASK);
+}
+
+static void
+uop_set_type(uop_t *uop, uint32_t type)
+{
+    uop->type = type | (uop->type & UOP_TYPE_JUMP_DEST);
+}
+
+/*Returns non-zero if ir_reg is a version created by a UOP_MOV_IMM after uOP
+  start, and places the value in *val*/
+static int
+reg_get_const(ir_data_t *ir, ir_reg_t ir_reg, int start, uint32_t *val)
+{
+    reg_version_t *regv;
+    uop_t         *parent;
+
+    if (ir_reg_is_invalid(ir_reg) || !ir_reg.version || !codegen_reg_is_native_dword(ir_reg))
+        return 0;
+
+    regv = &reg_version[IREG_GET_REG(ir_reg.reg)][ir_reg.version];
+    if (regv->flags & REG_FLAGS_DEAD)
+        return 0;
+    if ((int) regv->parent_uop <= start)
+        return 0;
+
+    parent = &ir->uops[regv->parent_uop];
+    if (!uop_is(parent, UOP_MOV_IMM) || parent->dest_reg_a.reg != ir_reg.reg || parent->dest_reg_a.version != ir_reg.version)
+        return 0;
+
+    *val = parent->imm_data;
+    return 1;
+}
+
+/*Drop a read of ir_reg from a uOP, and queue the version for removal if that was
+  the last reader*/
+static void
+reg_drop_read(ir_data_t *ir, ir_reg_t ir_reg)
+{
+    int            reg     = IREG_GET_REG(ir_reg.reg);
+    int            version = ir_reg.version;
+    reg_version_t *regv    = &reg_version[reg][version];
+
+    regv->refcount--;
+    if (regv->refcount || (regv->flags & (REG_FLAGS_REQUIRED | REG_FLAGS_DEAD)))
+        return;
+
+    /*Same restrictions as codegen_reg_write() - guest registers with byte
+      sub-registers are never optimised out, and neither are versions that the
+      partial write of the next version depends on*/
+    if (reg <= IREG_EBX || !version)
+        return;
+    if (version < reg_last_version[reg] && !reg_is_native_size(ir->uops[reg_version[reg][version + 1].parent_uop].dest_reg_a))
+        return;
+
+    add_to_dead_list(regv, reg, version);
+}
+
+static void
+uop_make_mov_imm(ir_data_t *ir, uop_t *uop, uint32_t imm)
+{
+    if (!ir_reg_is_invalid(uop->src_reg_a))
+        reg_drop_read(ir, uop->src_reg_a);
+    if (!ir_reg_is_invalid(uop->src_reg_b))
+        reg_drop_read(ir, uop->src_reg_b);
+
+    uop_set_type(uop, UOP_MOV_IMM);
+    uop->src_reg_a = invalid_ir_reg;
+    uop->src_reg_b = invalid_ir_reg;
+    uop->imm_data  = imm;
+
+    codegen_ir_stats.consts_folded++;
+}
+
+static void
+uop_make_mov(ir_data_t *ir, uop_t *uop, ir_reg_t src)
+{
+    if (!ir_reg_is_invalid(uop->src_reg_b))
+        reg_drop_read(ir, uop->src_reg_b);
+
+    uop_set_type(uop, UOP_MOV);
+    uop->src_reg_a = src;
+    uop->src_reg_b = invalid_ir_reg;
+
+    codegen_ir_stats.moves_simplified++;
+}
+
+static int
+fold_binary(uint32_t type, uint32_t a, uint32_t b, uint32_t *res)
+{
+    switch (type & UOP_MASK) {
+        case (UOP_ADD & UOP_MASK):
+        case (UOP_ADD_IMM & UOP_MASK):
+            *res = a + b;
+            return 1;
+        case (UOP_SUB & UOP_MASK):
+        case (UOP_SUB_IMM & UOP_MASK):
+            *res = a - b;
+            return 1;
+        case (UOP_AND & UOP_MASK):
+        case (UOP_AND_IMM & UOP_MASK):
+            *res = a & b;
+            return 1;
+        case (UOP_OR & UOP_MASK):
+        case (UOP_OR_IMM & UOP_MASK):
+            *res = a | b;
+            return 1;
+        case (UOP_XOR & UOP_MASK):
+        case (UOP_XOR_IMM & UOP_MASK):
+            *res = a ^ b;
+            return 1;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/*Immediate form of a register-register operation*/
+static uint32_t
+uop_imm_form(uint32_t type)
+{
+    switch (type & UOP_MASK) {
+        case (UOP_ADD & UOP_MASK):
+            return UOP_ADD_IMM;
+        case (UOP_SUB & UOP_MASK):
+            return UOP_SUB_IMM;
+        case (UOP_AND & UOP_MASK):
+            return UOP_AND_IMM;
+        case (UOP_OR & UOP_MASK):
+            return UOP_OR_IMM;
+        case (UOP_XOR & UOP_MASK):
+            return UOP_XOR_IMM;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/*Turn an operation with an immediate that leaves its source unchanged into a
+  move, and AND with zero into a constant*/
+static void
+simplify_imm(ir_data_t *ir, uop_t *uop)
+{
+    uint32_t imm = uop->imm_data;
+
+    if (uop_is(uop, UOP_AND_IMM)) {
+        if (imm == 0xffffffff)
+            uop_make_mov(ir, uop, uop->src_reg_a);
+        else if (!imm)
+            uop_make_mov_imm(ir, uop, 0);
+    } else if (!imm)
+        uop_make_mov(ir, uop, uop->src_reg_a);
+}
+
+/*Constant propagation and folding, with algebraic simplification of the results*/
+static void
+codegen_ir_fold_constants(ir_data_t *ir)
+{
+    int      last_reset = -1;
+    uint32_t a;
+    uint32_t b;
+    uint32_t res;
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t   *uop = &ir->uops[c];
+        uint32_t imm_type;
+        int      a_const;
+        int      b_const;
+
+        if ((uop->type & UOP_TYPE_BARRIER) || uop_is_jump_dest[c]) {
+            last_reset = c;
+            continue;
+        }
+        if ((uop->type & (UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP | UOP_TYPE_PARAMS_POINTER)) || uop_is(uop, UOP_INVALID))
+            continue;
+        if (ir_reg_is_invalid(uop->dest_reg_a) || !codegen_reg_is_native_dword(uop->dest_reg_a))
+            continue;
+        if (!ir_reg_is_invalid(uop->src_reg_c))
+            continue;
+
+        if (uop_is(uop, UOP_MOV)) {
+            if (codegen_reg_is_native_dword(uop->src_reg_a) && reg_get_const(ir, uop->src_reg_a, last_reset, &a))
+                uop_make_mov_imm(ir, uop, a);
+            continue;
+        }
+
+        if (uop_is(uop, UOP_ADD_IMM) || uop_is(uop, UOP_SUB_IMM) || uop_is(uop, UOP_AND_IMM) || uop_is(uop, UOP_OR_IMM) || uop_is(uop, UOP_XOR_IMM)) {
+            if (!codegen_reg_is_native_dword(uop->src_reg_a))
+                continue;
+
+            if (reg_get_const(ir, uop->src_reg_a, last_reset, &a) && fold_binary(uop->type, a, uop->imm_data, &res))
+                uop_make_mov_imm(ir, uop, res);
+            else
+                simplify_imm(ir, uop);
+            continue;
+        }
+
+        imm_type = uop_imm_form(uop->type);
+        if (!imm_type || !codegen_reg_is_native_dword(uop->src_reg_a) || !codegen_reg_is_native_dword(uop->src_reg_b))
+            continue;
+
+        a_const = reg_get_const(ir, uop->src_reg_a, last_reset, &a);
+        b_const = reg_get_const(ir, uop->src_reg_b, last_reset, &b);
+
+        if (a_const && b_const) {
+            if (fold_binary(uop->type, a, b, &res))
+                uop_make_mov_imm(ir, uop, res);
+        } else if (b_const || (a_const && !uop_is(uop, UOP_SUB))) {
+            /*Replace the constant operand with an immediate. All of these
+              except SUB are commutative*/
+            if (a_const) {
+                reg_drop_read(ir, uop->src_reg_a);
+                uop->src_reg_a = uop->src_reg_b;
+                b              = a;
+            } else
+                reg_drop_read(ir, uop->src_reg_b);
+
+            uop_set_type(uop, imm_type);
+            uop->src_reg_b = invalid_ir_reg;
+            uop->imm_data  = b;
+            codegen_ir_stats.imms_propagated++;
+
+            simplify_imm(ir, uop);
+        }
+    }
+}
+
+/*Returns non-zero if a new reader can be added to ir_reg at uOP pos - the
+  version must not be dead or queued for removal, and must not have been
+  replaced by a newer version before pos*/
+static int
+reg_can_reuse(ir_reg_t ir_reg, int pos)
+{
+    int            reg     = IREG_GET_REG(ir_reg.reg);
+    int            version = ir_reg.version;
+    reg_version_t *regv    = &reg_version[reg][version];
+
+    if (regv->flags & REG_FLAGS_DEAD)
+        return 0;
+    if (!regv->refcount && !(regv->flags & REG_FLAGS_REQUIRED))
+        return 0;
+    if (regv->refcount >= REG_REFCOUNT_MAX)
+        return 0;
+    if (version < reg_last_version[reg] && (int) reg_version[reg][version + 1].parent_uop < pos)
+        return 0;
+
+    return 1;
+}
+
+static int
+uop_is_ptr_load(uop_t *uop)
+{
+    return uop_is(uop, UOP_MOV_REG_PTR) || uop_is(uop, UOP_MOVZX_REG_PTR_8) || uop_is(uop, UOP_MOVZX_REG_PTR_16);
+}
+
+/*Redundant load elimination. A direct RAM load from the same pointer as an
+  earlier load, with no store, barrier or jump destination in between, is
+  replaced by a move from the register the earlier load wrote. Guest memory
+  loads through UOP_MEM_LOAD_* are left alone, as they can fault or hit MMIO*/
+static void
+codegen_ir_eliminate_loads(ir_data_t *ir)
+{
+    int last_reset = -1;
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        if ((uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP)) || uop_is_jump_dest[c] || uop_is(uop, UOP_STORE_P_IMM) || uop_is(uop, UOP_STORE_P_IMM_8) || uop_is(uop, UOP_STORE_P_IMM_16)) {
+            last_reset = c;
+            continue;
+        }
+        if (!uop_is_ptr_load(uop) || !codegen_reg_is_native_dword(uop->dest_reg_a))
+            continue;
+
+        for (int d = c - 1; d > last_reset; d--) {
+            uop_t *prev = &ir->uops[d];
+
+            if (!uop_is_ptr_load(prev) || prev->p != uop->p || (prev->type & UOP_MASK) != (uop->type & UOP_MASK))
+                continue;
+            if (!codegen_reg_is_native_dword(prev->dest_reg_a) || !reg_can_reuse(prev->dest_reg_a, c))
+                break;
+
+            uop_set_type(uop, UOP_MOV);
+            uop->src_reg_a = prev->dest_reg_a;
+            reg_version[IREG_GET_REG(prev->dest_reg_a.reg)][prev->dest_reg_a.version].refcount++;
+            codegen_ir_stats.loads_eliminated++;
+            break;
+        }
+    }
+}
+
+/*Redundant store elimination. A UOP_MOV_IMM that writes the value the previous
+  version of the register already holds is removed, and its readers are moved
+  over to the previous version. This mostly catches the flags_op constant
+  written by consecutive instructions of the same kind, which survives the dead
+  list when a memory access between them requires it to be written back*/
+static void
+codegen_ir_eliminate_stores(ir_data_t *ir)
+{
+    int last_reset = -1;
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t         *uop = &ir->uops[c];
+        ir_reg_t       prev;
+        reg_version_t *regv;
+        reg_version_t *prev_regv;
+        int            reg;
+        int            end;
+        uint32_t       imm;
+
+        if ((uop->type & UOP_TYPE_BARRIER) || uop_is_jump_dest[c]) {
+            last_reset = c;
+            continue;
+        }
+        if (!uop_is(uop, UOP_MOV_IMM) || !codegen_reg_is_native_dword(uop->dest_reg_a))
+            continue;
+
+        reg = IREG_GET_REG(uop->dest_reg_a.reg);
+        if (reg <= IREG_EBX || uop->dest_reg_a.version < 2)
+            continue;
+
+        prev.reg     = uop->dest_reg_a.reg;
+        prev.version = uop->dest_reg_a.version - 1;
+        if (!reg_get_const(ir, prev, last_reset, &imm) || imm != uop->imm_data || !reg_can_reuse(prev, c))
+            continue;
+
+        regv      = &reg_version[reg][uop->dest_reg_a.version];
+        prev_regv = &reg_version[reg][prev.version];
+        if (regv->flags & REG_FLAGS_DEAD)
+            continue;
+        if ((prev_regv->refcount + regv->refcount) > REG_REFCOUNT_MAX)
+            continue;
+
+        /*Partial writes of the next version read this one implicitly*/
+        end = ir->wr_pos - 1;
+        if (uop->dest_reg_a.version < reg_last_version[reg]) {
+            end = reg_version[reg][uop->dest_reg_a.version + 1].parent_uop;
+            if (!reg_is_native_size(ir->uops[end].dest_reg_a))
+                continue;
+        }
+
+        for (int d = c + 1; d <= end; d++) {
+            uop_t *reader = &ir->uops[d];
+
+            if (IREG_GET_REG(reader->src_reg_a.reg) == reg && reader->src_reg_a.version == uop->dest_reg_a.version)
+                reader->src_reg_a.version = prev.version;
+            if (IREG_GET_REG(reader->src_reg_b.reg) == reg && reader->src_reg_b.version == uop->dest_reg_a.version)
+                reader->src_reg_b.version = prev.version;
+            if (IREG_GET_REG(reader->src_reg_c.reg) == reg && reader->src_reg_c.version == uop->dest_reg_a.version)
+                reader->src_reg_c.version = prev.version;
+        }
+
+        prev_regv->refcount += regv->refcount;
+        prev_regv->flags |= (regv->flags & REG_FLAGS_REQUIRED);
+        regv->refcount = 0;
+        regv->flags &= ~REG_FLAGS_REQUIRED;
+        add_to_dead_list(regv, reg, uop->dest_reg_a.version);
+        codegen_ir_stats.stores_eliminated++;
+    }
+}
+
+static int
+flags_op_is_zn(uint32_t op)
+{
+    return (op == FLAGS_ZN8) || (op == FLAGS_ZN16) || (op == FLAGS_ZN32);
+}
+
+/*Queue an unread flag operand version for removal*/
+static void
+flag_kill(ir_data_t *ir, int reg, int version)
+{
+    reg_version_t *regv = &reg_version[reg][version];
+
+    if (!version || regv->refcount || (regv->flags & REG_FLAGS_DEAD))
+        return;
+    if (ir->uops[regv->parent_uop].type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER))
+        return;
+
+    regv->flags &= ~REG_FLAGS_REQUIRED;
+    add_to_dead_list(regv, reg, version);
+    codegen_ir_stats.flags_eliminated++;
+}
+
+/*Dead flag elimination. Versions of flags_op1 and flags_op2 with no readers
+  are normally removed when they are overwritten, unless a barrier or the end of
+  the block required them to be written back. Flag evaluation does not look at
+  either operand while flags_op is one of the FLAGS_ZN values, so such a version
+  is dead if flags_op was a known FLAGS_ZN constant at every point that required
+  it. Full barriers call out to code that may do anything with the flags, so a
+  version that lives across one is always kept*/
+static void
+codegen_ir_eliminate_flags(ir_data_t *ir)
+{
+    static const int flag_regs[2] = { IREG_flags_op1, IREG_flags_op2 };
+    int              dead[2]      = { 0, 0 };
+    int              zn           = 0;
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        if (uop_is_jump_dest[c])
+            zn = 0;
+        if (uop->type & UOP_TYPE_BARRIER) {
+            zn      = 0;
+            dead[0] = dead[1] = 0;
+        } else if ((uop->type & (UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP)) && !zn)
+            dead[0] = dead[1] = 0;
+
+        if (ir_reg_is_invalid(uop->dest_reg_a))
+            continue;
+
+        if (IREG_GET_REG(uop->dest_reg_a.reg) == IREG_flags_op) {
+            zn = uop_is(uop, UOP_MOV_IMM) && codegen_reg_is_native_dword(uop->dest_reg_a) && flags_op_is_zn(uop->imm_data);
+            continue;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            int version = uop->dest_reg_a.version - 1;
+
+            if (IREG_GET_REG(uop->dest_reg_a.reg) != flag_regs[i])
+                continue;
+
+            /*Versions that were not required are already on the dead list*/
+            if (dead[i] && reg_is_native_size(uop->dest_reg_a) && (reg_version[flag_regs[i]][version].flags & REG_FLAGS_REQUIRED))
+                flag_kill(ir, flag_regs[i], version);
+            dead[i] = reg_is_native_size(uop->dest_reg_a);
+        }
+    }
+
+    /*The end of the block requires the last versions as well*/
+    for (int i = 0; i < 2; i++) {
+        if (dead[i] && zn)
+            flag_kill(ir, flag_regs[i], reg_last_version[flag_regs[i]]);
+    }
+}
+
+void
+codegen_ir_optimise(ir_data_t *ir)
+{
+    memset(uop_is_jump_dest, 0, ir->wr_pos);
+    for (int c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        if ((uop->type & UOP_TYPE_JUMP) && (uop->jump_dest_uop >= 0) && (uop->jump_dest_uop < ir->wr_pos))
+            uop_is_jump_dest[uop->jump_dest_uop] = 1;
+    }
+
+    codegen_ir_stats.uops += ir->wr_pos;
+
+    codegen_ir_fold_constants(ir);
+    codegen_ir_eliminate_loads(ir);
+    codegen_ir_eliminate_stores(ir);
+    codegen_ir_eliminate_flags(ir);
+}
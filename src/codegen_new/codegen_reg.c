@@ -192,6 +192,15 @@ codegen_reg_mark_as_required(void)
     }
 }
 
+int
+codegen_reg_is_native_dword(ir_reg_t ir_reg)
+{
+    if (ir_reg_is_invalid(ir_reg))
+        return 0;
+
+    return (ireg_data[IREG_GET_REG(ir_reg.reg)].native_size == REG_DWORD) && (IREG_GET_SIZE(ir_reg.reg) == IREG_SIZE_L);
+}
+
 int
 reg_is_native_size(ir_reg_t ir_reg)
 {
@@ -848,9 +857,11 @@ codegen_reg_flush_invalidate(UNUSED(ir_data_t *ir), codeblock_t *block)
 
 /*Process dead register list, and optimise out register versions and uOPs where
   possible*/
-void
+int
 codegen_reg_process_dead_list(ir_data_t *ir)
 {
+    int removed = 0;
+
     while (reg_dead_list) {
         int            version = reg_dead_list & 0xff;
         int            reg     = reg_dead_list >> 8;
@@ -881,8 +892,11 @@ codegen_reg_process_dead_list(ir_data_t *ir)
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_c.reg), uop->src_reg_c.version);
             }
             regv->flags |= REG_FLAGS_DEAD;
+            removed++;
         }
 
         reg_dead_list = regv->next;
     }
+
+    return removed;
 }
@@ -352,6 +352,8 @@ codegen_reg_read(int reg)
 }
 
 int reg_is_native_size(ir_reg_t ir_reg);
+/*True if ir_reg is a 32-bit access to a register with a native size of 32 bits*/
+int codegen_reg_is_native_dword(ir_reg_t ir_reg);
 
 static inline ir_reg_t
 codegen_reg_write(int reg, int uop_nr)
@@ -421,5 +423,6 @@ ir_host_reg_t codegen_reg_alloc_write_reg(codeblock_t *block, ir_reg_t ir_reg);
 void codegen_reg_rename(codeblock_t *block, ir_reg_t src, ir_reg_t dst);
 
 void codegen_reg_mark_as_required(void);
-void codegen_reg_process_dead_list(struct ir_data_t *ir);
+/*Returns the number of uOPs optimised out*/
+int  codegen_reg_process_dead_list(struct ir_data_t *ir);
 #endif
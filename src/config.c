@@ -152,12 +152,12 @@ load_general(void)
         sscanf(p, "%ix%i", &fixed_size_x, &fixed_size_y);
         if (fixed_size_x < 120)
             fixed_size_x = 120;
-        if (fixed_size_x > 2048)
-            fixed_size_x = 2048;
+        if (fixed_size_x > VIDEO_MAX_X)
+            fixed_size_x = VIDEO_MAX_X;
         if (fixed_size_y < 120)
             fixed_size_y = 120;
-        if (fixed_size_y > 2048)
-            fixed_size_y = 2048;
+        if (fixed_size_y > VIDEO_MAX_Y)
+            fixed_size_y = VIDEO_MAX_Y;
     } else {
         ini_section_delete_var(cat, "window_fixed_res");
 
@@ -389,6 +389,7 @@ load_machine(void)
         mem_size = machine_get_max_ram(machine);
 
     cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    dynarec_cache_size = ini_section_get_int(cat, "dynarec_cache_size", 0);
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
@@ -457,6 +458,7 @@ load_video(void)
     xga_standalone_enabled           = !!ini_section_get_int(cat, "xga", 0);
     xga_active                       = xga_standalone_enabled;
     show_second_monitors             = !!ini_section_get_int(cat, "show_second_monitors", 1);
+    svga_render_threads              = ini_section_get_int(cat, "svga_render_threads", 0);
     video_fullscreen_scale_maximized = !!ini_section_get_int(cat, "video_fullscreen_scale_maximized", 0);
 
     // TODO
@@ -1119,6 +1121,9 @@ load_hard_disks(void)
         sprintf(temp, "hdd_%02i_vhd_blocksize", c + 1);
         hdd[c].vhd_blocksize = ini_section_get_int(cat, temp, 0);
 
+        sprintf(temp, "hdd_%02i_cache_size", c + 1);
+        hdd[c].cache_size = ini_section_get_int(cat, temp, 0);
+
         sprintf(temp, "hdd_%02i_vhd_parent", c + 1);
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
@@ -1139,6 +1144,9 @@ load_hard_disks(void)
 
             sprintf(temp, "hdd_%02i_fn", c + 1);
             ini_section_delete_var(cat, temp);
+
+            sprintf(temp, "hdd_%02i_cache_size", c + 1);
+            ini_section_delete_var(cat, temp);
         }
 
         sprintf(temp, "hdd_%02i_mfm_channel", c + 1);
@@ -2019,6 +2027,10 @@ save_machine(void)
     ini_section_set_int(cat, "mem_size", mem_size);
 
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
+    if (dynarec_cache_size == 0)
+        ini_section_delete_var(cat, "dynarec_cache_size");
+    else
+        ini_section_set_int(cat, "dynarec_cache_size", dynarec_cache_size);
     ini_section_set_int(cat, "fpu_softfloat", fpu_softfloat);
 
     if (time_sync & TIME_SYNC_ENABLED)
@@ -2079,6 +2091,11 @@ save_video(void)
     else
         ini_section_set_int(cat, "video_fullscreen_scale_maximized", video_fullscreen_scale_maximized);
 
+    if (svga_render_threads == 0)
+        ini_section_delete_var(cat, "svga_render_threads");
+    else
+        ini_section_set_int(cat, "svga_render_threads", svga_render_threads);
+
     ini_delete_section_if_empty(config, cat);
 }
 
@@ -2582,6 +2599,12 @@ save_hard_disks(void)
         else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_cache_size", c + 1);
+        if (hdd_is_valid(c) && (hdd[c].cache_size > 0))
+            ini_section_set_int(cat, temp, hdd[c].cache_size);
+        else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_vhd_parent", c + 1);
         if (hdd_is_valid(c) && hdd[c].vhd_parent[0]) {
             path_normalize(hdd[c].vhd_parent);
@@ -2846,6 +2869,10 @@ save_other_removable_devices(void)
 void
 config_save(void)
 {
+    /* Batch runs must leave the configuration as they found it. */
+    if (batch_mode)
+        return;
+
     save_general();                 /* General */
     for (uint8_t i = 0; i < MONITORS_NUM; i++)
         save_monitor(i);            /* Monitors */
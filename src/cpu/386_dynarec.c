@@ -517,6 +517,8 @@ exec386_dynarec_dyn(void)
 
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
+#    else
+        block->flags |= CODEBLOCK_REFERENCED;
 #    endif
         inrecomp = 1;
         code();
@@ -144,6 +144,8 @@ dumpregs(int force)
                 AX, BX, CX, DX, DI, SI, BP, SP);
     }
     x86_log("Entries in readlookup : %i    writelookup : %i\n", readlnum, writelnum);
+    x86_log("TLB flushes : %i    CR3 loads keeping globals : %i    global entries kept : %i\n",
+            mmuflush, mmuflush_nonglobal, mmuflush_global_kept);
     x87_dumpregs();
     indump = 0;
 }
@@ -54,6 +54,7 @@
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/snapshot.h>
 
 #define DEVICE_MAX 256 /* max # of devices */
 
@@ -317,6 +318,83 @@ device_reset_all(uint32_t match_flags)
 #endif
 }
 
+static void
+device_state_tag(char *tag, int c)
+{
+    const char *name = devices[c]->internal_name;
+
+    if (name == NULL)
+        name = devices[c]->name;
+
+    snprintf(tag, SNAPSHOT_TAG_LEN, "dev.%i.%s", c, name);
+}
+
+/* Return the name of the first device that cannot save and restore its
+   state, or NULL if all of them can. A snapshot of a machine with such a
+   device would come back half reset, so it is refused altogether. */
+const char *
+device_state_missing(void)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && ((devices[c]->save_state == NULL) || (devices[c]->load_state == NULL)))
+            return devices[c]->name;
+    }
+
+    return NULL;
+}
+
+int
+device_state_count(void)
+{
+    int count = 0;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && (devices[c]->load_state != NULL))
+            count++;
+    }
+
+    return count;
+}
+
+/* Save the state of every device that has a save state hook. The
+   section tag carries the slot, so that multiple instances of the
+   same device are told apart on load. */
+void
+device_save_state_all(snapshot_t *snap)
+{
+    char tag[SNAPSHOT_TAG_LEN];
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] == NULL) || (devices[c]->save_state == NULL))
+            continue;
+
+        device_state_tag(tag, c);
+        snapshot_section_begin(snap, tag, 1);
+        devices[c]->save_state(device_priv[c], snap);
+        snapshot_section_end(snap);
+    }
+}
+
+int
+device_load_state(snapshot_t *snap, const char *tag, uint32_t version)
+{
+    char tag2[SNAPSHOT_TAG_LEN];
+    int  c;
+
+    if (sscanf(tag, "dev.%i.", &c) != 1)
+        return 0;
+
+    if ((c < 0) || (c >= DEVICE_MAX) || (devices[c] == NULL) ||
+        (devices[c]->load_state == NULL))
+        return 0;
+
+    device_state_tag(tag2, c);
+    if (strcmp(tag, tag2))
+        return 0;
+
+    return devices[c]->load_state(device_priv[c], snap, version);
+}
+
 void *
 device_find_first_priv(uint32_t match_flags)
 {
@@ -165,6 +165,41 @@ unittester_read_snap_rect_idx(uint64_t offs)
     }
 }
 
+/* CRC-32 of the rectangle as it would be read byte by byte, taken a pixel
+   at a time with a table so that scripts can verify frames often. */
+static uint32_t
+unittester_snap_rect_crc(void)
+{
+    static uint32_t table[256];
+    uint32_t        crc = 0xFFFFFFFF;
+    uint32_t        pixel;
+
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (uint32_t j = 0; j < 8; j++)
+                c = (c >> 1) ^ ((-(c & 0x1)) & 0xEDB88320);
+            table[i] = c;
+        }
+    }
+
+    for (int64_t y = unittester.read_snap_yoffs; y < (unittester.read_snap_yoffs + unittester.read_snap_height); y++) {
+        for (int64_t x = unittester.read_snap_xoffs; x < (unittester.read_snap_xoffs + unittester.read_snap_width); x++) {
+            if (x < 0 || y < 0 || x >= unittester.snap_overscan_width || y >= unittester.snap_overscan_height)
+                pixel = 0xFF000000;
+            else
+                pixel = unittester_screen_buffer->line[y][x] & 0x00FFFFFF;
+
+            for (uint32_t j = 0; j < 4; j++) {
+                crc   = (crc >> 8) ^ table[(crc ^ pixel) & 0xFF];
+                pixel >>= 8;
+            }
+        }
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
 static void
 unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
 {
@@ -303,7 +338,11 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
 
                         /* Exit somewhat quickly! */
                         unittester_log("[UT] Exit enabled, exiting with code %02X\n", unittester.exit_code);
-                        exit(unittester.exit_code);
+                        if (batch_mode) {
+                            /* Shut down cleanly and let the frontend report the code. */
+                            pc_batch_exit(unittester.exit_code);
+                        } else
+                            exit(unittester.exit_code);
 
                     } else {
                         /* No - report successful command completion and continue program execution */
@@ -336,11 +375,14 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                         unittester.snap_overscan_height = m->mon_ysize + m->mon_overscan_y;
                         unittester.snap_img_xoffs       = (m->mon_overscan_x >> 1);
                         unittester.snap_img_yoffs       = (m->mon_overscan_y >> 1);
-                        /* Take snapshot */
+                        /* Take snapshot, into a buffer as large as the target buffer */
+                        if ((unittester_screen_buffer->w < m->target_buffer->w) || (unittester_screen_buffer->h < m->target_buffer->h)) {
+                            destroy_bitmap(unittester_screen_buffer);
+                            unittester_screen_buffer = create_bitmap(m->target_buffer->w, m->target_buffer->h);
+                        }
                         for (size_t y = 0; y < unittester.snap_overscan_height; y++) {
-                            for (size_t x = 0; x < unittester.snap_overscan_width; x++) {
-                                unittester_screen_buffer->line[y][x] = m->target_buffer->line[y][x];
-                            }
+                            memcpy(unittester_screen_buffer->line[y], m->target_buffer->line[y],
+                                   unittester.snap_overscan_width * sizeof(uint32_t));
                         }
                     }
 
@@ -377,15 +419,7 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
 
                     if (unittester.cmd_id == UT_CMD_VERIFY_SCREEN_SNAPSHOT_RECTANGLE) {
                         /* Read everything and compute CRC */
-                        uint32_t crc = 0xFFFFFFFF;
-                        for (uint64_t i = 0; i < unittester.read_len; i++) {
-                            crc ^= 0xFF & (uint32_t) unittester_read_snap_rect_idx(i);
-                            /* Use some bit twiddling until we have a table-based fast CRC-32 implementation */
-                            for (uint32_t j = 0; j < 8; j++) {
-                                crc = (crc >> 1) ^ ((-(crc & 0x1)) & 0xEDB88320);
-                            }
-                        }
-                        unittester.read_snap_crc = crc ^ 0xFFFFFFFF;
+                        unittester.read_snap_crc = unittester_snap_rect_crc();
 
                         unittester_log("[UT] Screen rectangle analysis CRC = %08X\n",
                                        unittester.read_snap_crc);
@@ -594,7 +628,7 @@ unittester_init(UNUSED(const device_t *info))
     unittester_exit_enabled = !!device_get_config_int("exit_enabled");
 
     if (unittester_screen_buffer == NULL)
-        unittester_screen_buffer = create_bitmap(2048, 2048);
+        unittester_screen_buffer = create_bitmap(VIDEO_BUFFER_X, VIDEO_BUFFER_Y);
 
     io_sethandler(unittester.trigger_port, 1, NULL, NULL, NULL, unittester_trigger_write, NULL, NULL, NULL);
 
@@ -97,6 +97,8 @@ typedef struct esdi_t {
     int      reset;
     uint16_t buffer[256];
     int      irqstat;
+    int      io_pending;
+    int      io_hdd_num;
 
     pc_timer_t callback_timer;
 
@@ -267,6 +269,49 @@ next_sector(esdi_t *esdi)
     }
 }
 
+/* Start the image read or write of the current sector in the background, so
+   the host I/O overlaps the emulated seek and transfer time. */
+static void
+esdi_io_submit(esdi_t *esdi, int write)
+{
+    const drive_t *drive = &esdi->drives[esdi->drive_sel];
+    off64_t        addr;
+
+    if (!drive->present || get_sector(esdi, &addr))
+        return;
+
+    esdi->io_hdd_num = drive->hdd_num;
+    if (write)
+        esdi->io_pending = hdd_image_write_async(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+    else
+        esdi->io_pending = hdd_image_read_async(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+}
+
+/* Returns 1 and polls again later if background I/O is still in flight. */
+static int
+esdi_io_busy(esdi_t *esdi)
+{
+    if (!esdi->io_pending)
+        return 0;
+
+    if (hdd_image_async_busy(esdi->io_hdd_num)) {
+        esdi_set_callback(esdi, HDC_TIME);
+        return 1;
+    }
+
+    esdi->io_pending = 0;
+    return 0;
+}
+
+static void
+esdi_io_wait(esdi_t *esdi)
+{
+    if (esdi->io_pending) {
+        hdd_image_async_wait(esdi->io_hdd_num);
+        esdi->io_pending = 0;
+    }
+}
+
 static void
 esdi_writew(uint16_t port, uint16_t val, void *priv)
 {
@@ -288,6 +333,8 @@ esdi_writew(uint16_t port, uint16_t val, void *priv)
             double seek_time = hdd_timing_write(&hdd[esdi->drives[esdi->drive_sel].hdd_num], addr, 1);
             double xfer_time = esdi_get_xfer_time(esdi, 1);
             esdi_set_callback(esdi, seek_time + xfer_time);
+            if (esdi->command == CMD_WRITE)
+                esdi_io_submit(esdi, 1);
         }
     }
 }
@@ -338,6 +385,7 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
             return;
 
         case 0x1f7: /* command register */
+            esdi_io_wait(esdi);
             irq_lower(esdi);
             esdi->command = val;
             esdi->error   = 0;
@@ -383,6 +431,8 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
                             seek_time = hdd_timing_read(&hdd[esdi->drives[esdi->drive_sel].hdd_num], addr, 1);
                             xfer_time = esdi_get_xfer_time(esdi, 1);
                             esdi_set_callback(esdi, seek_time + xfer_time);
+                            if (esdi->command == CMD_READ)
+                                esdi_io_submit(esdi, 0);
                             ui_sb_update_icon(SB_HDD | HDD_BUS_ESDI, 1);
                             break;
 
@@ -444,6 +494,7 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
             break;
 
         case 0x3f6: /* Device control */
+            esdi_io_wait(esdi);
             if ((esdi->fdisk & 0x04) && !(val & 0x04)) {
                 esdi_set_callback(esdi, 500 * HDC_TIME);
                 esdi->reset  = 1;
@@ -494,6 +545,8 @@ esdi_readw(uint16_t port, void *priv)
                     double xfer_time = esdi_get_xfer_time(esdi, 1);
                     /* 390.625 us per sector at 10 Mbit/s = 1280 kB/s. */
                     esdi_set_callback(esdi, seek_time + xfer_time);
+                    if (esdi->command == CMD_READ)
+                        esdi_io_submit(esdi, 0);
                 } else
                     ui_sb_update_icon(SB_HDD | HDD_BUS_ESDI, 0);
             }
@@ -611,7 +664,10 @@ esdi_callback(void *priv)
                     break;
                 }
 
-                hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+                if (!esdi->io_pending)
+                    hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+                else if (esdi_io_busy(esdi))
+                    return;
                 esdi->pos    = 0;
                 esdi->status = STAT_DRQ | STAT_READY | STAT_DSC;
                 irq_raise(esdi);
@@ -634,7 +690,10 @@ esdi_callback(void *priv)
                     break;
                 }
 
-                hdd_image_write(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+                if (!esdi->io_pending)
+                    hdd_image_write(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+                else if (esdi_io_busy(esdi))
+                    return;
                 irq_raise(esdi);
                 esdi->secount = (esdi->secount - 1) & 0xff;
                 if (esdi->secount) {
@@ -128,6 +128,9 @@ typedef struct esdi_t {
     int      data_pos;
     uint16_t data[256];
 
+    int io_pending;
+    int io_hdd_num;
+
     uint16_t sector_buffer[256][256];
 
     int sector_pos;
@@ -257,6 +260,32 @@ esdi_mca_set_callback(esdi_t *dev, double callback)
     }
 }
 
+/* Returns 1 and polls again later if the background image I/O on the data
+   buffer is still in flight. */
+static int
+esdi_io_busy(esdi_t *dev, double cmd_time)
+{
+    if (!dev->io_pending)
+        return 0;
+
+    if (hdd_image_async_busy(dev->io_hdd_num)) {
+        esdi_mca_set_callback(dev, ESDI_TIME + cmd_time);
+        return 1;
+    }
+
+    dev->io_pending = 0;
+    return 0;
+}
+
+static void
+esdi_io_wait(esdi_t *dev)
+{
+    if (dev->io_pending) {
+        hdd_image_async_wait(dev->io_hdd_num);
+        dev->io_pending = 0;
+    }
+}
+
 static double
 esdi_mca_get_xfer_time(UNUSED(esdi_t *esdi), int size)
 {
@@ -411,6 +440,12 @@ esdi_callback(void *priv)
                     dev->cmd_state = 1;
                     esdi_mca_set_callback(dev, ESDI_TIME);
                     dev->data_pos = 0;
+
+                    /* Read the first sector while the host sets up the DMA transfer. */
+                    if (dev->sector_count && (dev->rba < drive->sectors)) {
+                        dev->io_hdd_num = drive->hdd_num;
+                        dev->io_pending = hdd_image_read_async(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
+                    }
                     break;
 
                 case 1:
@@ -423,7 +458,10 @@ esdi_callback(void *priv)
                         if (!dev->data_pos) {
                             if (dev->rba >= drive->sectors)
                                 fatal("Read past end of drive\n");
-                            hdd_image_read(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
+                            if (!dev->io_pending)
+                                hdd_image_read(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
+                            else if (esdi_io_busy(dev, cmd_time))
+                                return;
                             cmd_time += hdd_timing_read(&hdd[drive->hdd_num], dev->rba, 1);
                             cmd_time += esdi_mca_get_xfer_time(dev, 1);
                         }
@@ -499,6 +537,10 @@ esdi_callback(void *priv)
                     }
 
                     while (dev->sector_pos < dev->sector_count) {
+                        /* The buffer is still being written out for the previous sector. */
+                        if (!dev->data_pos && esdi_io_busy(dev, cmd_time))
+                            return;
+
                         while (dev->data_pos < 256) {
                             val = dma_channel_read(dev->dma);
 
@@ -512,7 +554,10 @@ esdi_callback(void *priv)
 
                         if (dev->rba >= drive->sectors)
                             fatal("Write past end of drive\n");
-                        hdd_image_write(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
+                        dev->io_hdd_num = drive->hdd_num;
+                        dev->io_pending = hdd_image_write_async(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
+                        if (!dev->io_pending)
+                            hdd_image_write(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data);
                         cmd_time += hdd_timing_write(&hdd[drive->hdd_num], dev->rba, 1);
                         cmd_time += esdi_mca_get_xfer_time(dev, 1);
                         dev->rba++;
@@ -526,6 +571,9 @@ esdi_callback(void *priv)
                     break;
 
                 case 2:
+                    if (esdi_io_busy(dev, 0.0))
+                        return;
+
                     complete_command_status(dev);
                     dev->status          = STATUS_IRQ | STATUS_STATUS_OUT_FULL;
                     dev->irq_status      = dev->cmd_dev | IRQ_CMD_COMPLETE_SUCCESS;
@@ -946,6 +994,7 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
 
     switch (port & 7) {
         case 2: /*Basic control register*/
+            esdi_io_wait(dev);
             if ((dev->basic_ctrl & CTRL_RESET) && !(val & CTRL_RESET)) {
                 dev->in_reset = 1;
                 esdi_mca_set_callback(dev, ESDI_TIME * 50);
@@ -981,6 +1030,7 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
                             break;
 
                         case ATTN_RESET:
+                            esdi_io_wait(dev);
                             dev->in_reset = 1;
                             esdi_mca_set_callback(dev, ESDI_TIME * 50);
                             dev->status = STATUS_BUSY;
@@ -1438,6 +1438,49 @@ ide_write_devctl(UNUSED(uint16_t addr), uint8_t val, void *priv)
         ide_irq_update(ide_boards[ide->board], 1);
 }
 
+/* Start the image I/O for a read or DMA write in the background, so the host
+   I/O overlaps the emulated seek and transfer time. */
+static void
+ide_io_submit(ide_t *ide, int write, uint32_t sec_count)
+{
+    int ret;
+
+    if (write)
+        ret = hdd_image_write_async(ide->hdd_num, ide_get_sector(ide), sec_count, ide->sector_buffer);
+    else
+        ret = hdd_image_read_async(ide->hdd_num, ide_get_sector(ide), sec_count, ide->sector_buffer);
+
+    ide->io_pending = ret;
+}
+
+/* Returns 1 and polls again later if background I/O is still in flight. */
+static int
+ide_io_busy(ide_t *ide)
+{
+    if (!ide->io_pending)
+        return 0;
+
+    if (hdd_image_async_busy(ide->hdd_num)) {
+        ide_set_callback(ide, IDE_TIME);
+        return 1;
+    }
+
+    ide->io_pending = 0;
+    return 0;
+}
+
+/* Reads the sectors of a read command into the sector buffer, unless they
+   were read in the background. Returns 1 if the callback has to wait. */
+static int
+ide_read_sectors(ide_t *ide, uint32_t sec_count)
+{
+    if (ide->io_pending)
+        return ide_io_busy(ide);
+
+    hdd_image_read(ide->hdd_num, ide_get_sector(ide), sec_count, ide->sector_buffer);
+    return 0;
+}
+
 static void
 ide_reset_registers(ide_t *ide)
 {
@@ -1452,6 +1495,11 @@ ide_reset_registers(ide_t *ide)
 
     ide->reset        = 0;
 
+    if (ide->io_pending) {
+        hdd_image_async_wait(ide->hdd_num);
+        ide->io_pending = 0;
+    }
+
     if (ide->type == IDE_ATAPI)
         ide->sc->callback       = 0.0;
 
@@ -1590,6 +1638,11 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
             if ((ide->type == IDE_NONE) || ((ide->type & IDE_SHADOW) && (val != WIN_DRIVE_DIAGNOSTICS)))
                 break;
 
+            if (ide->io_pending) {
+                hdd_image_async_wait(ide->hdd_num);
+                ide->io_pending = 0;
+            }
+
             ide_irq_lower(ide);
             ide->command = val;
 
@@ -1670,6 +1723,12 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                             wait_time        = seek_time + xfer_time;
                         }
                         ide_set_callback(ide, wait_time);
+
+                        /* Only read ahead when the callback is going to use the data. */
+                        if ((ide->tf->lba || ide->cfg_spt) && ((val != WIN_READ_MULTIPLE) || ide->blocksize) &&
+                            (((val != WIN_READ_DMA) && (val != WIN_READ_DMA_ALT)) ||
+                             (!ide_boards[ide->board]->force_ata3 && (ide_boards[ide->board]->bm != NULL))))
+                            ide_io_submit(ide, 0, ide->tf->secount ? ide->tf->secount : 256);
                     } else
                         ide_set_callback(ide, 200.0 * IDE_TIME);
                     ide->do_initial_read = 1;
@@ -2200,10 +2259,10 @@ ide_callback(void *priv)
                 err = IDNF_ERR;
             else {
                 if (ide->do_initial_read) {
+                    if (ide_read_sectors(ide, ide->tf->secount ? ide->tf->secount : 256))
+                        return;
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                   ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 }
 
                 memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos * 512], 512);
@@ -2233,7 +2292,8 @@ ide_callback(void *priv)
                     ide->sector_pos = ide->tf->secount;
                 else
                     ide->sector_pos = 256;
-                hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+                if (ide_read_sectors(ide, ide->sector_pos))
+                    return;
 
                 ide->tf->pos = 0;
 
@@ -2278,10 +2338,10 @@ ide_callback(void *priv)
                 err = IDNF_ERR;
             else {
                 if (ide->do_initial_read) {
+                    if (ide_read_sectors(ide, ide->tf->secount ? ide->tf->secount : 256))
+                        return;
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                   ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 }
 
                 memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos * 512], 512);
@@ -2332,6 +2392,15 @@ ide_callback(void *priv)
             } else if (!ide->tf->lba && (ide->cfg_spt == 0)) {
                 ide_log("IDE %i: DMA write aborted (SPECIFY failed)\n", ide->channel);
                 err = IDNF_ERR;
+            } else if (ide->io_pending) {
+                /* Waiting for the image write of a completed DMA transfer. */
+                if (ide_io_busy(ide))
+                    return;
+
+                ide->tf->atastat = DRDY_STAT | DSC_STAT;
+
+                ide_irq_raise(ide);
+                ui_sb_update_icon(SB_HDD | hdd[ide->hdd_num].bus, 0);
             } else {
                 if (!ide_boards[ide->board]->force_ata3 && bm->dma) {
                     if (ide->tf->secount)
@@ -2350,6 +2419,13 @@ ide_callback(void *priv)
                         /* DMA successful */
                         ide_log("IDE %i: DMA write successful\n", ide->channel);
 
+                        ide_io_submit(ide, 1, ide->sector_pos);
+                        if (ide->io_pending) {
+                            /* Complete the command once the image write is done. */
+                            ide_set_callback(ide, IDE_TIME);
+                            return;
+                        }
+
                         hdd_image_write(ide->hdd_num, ide_get_sector(ide),
                                         ide->sector_pos, ide->sector_buffer);
 
@@ -17,6 +17,7 @@
  *          Copyright 2017-2018 Fred N. van Kempen.
  */
 #define _GNU_SOURCE
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -26,6 +27,7 @@
 #include <time.h>
 #include <wchar.h>
 #include <errno.h>
+#include <stdatomic.h>
 #ifdef __unix__
 #include <unistd.h>
 #endif
@@ -34,6 +36,7 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
 #include <86box/hdd.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
@@ -43,6 +46,45 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+#define HDD_IO_READ   0
+#define HDD_IO_WRITE  1
+
+#define HDD_CACHE_BLOCK_SHIFT   6 /* 64 sectors or 32 KiB per cache block */
+#define HDD_CACHE_BLOCK_SECTORS (1 << HDD_CACHE_BLOCK_SHIFT)
+#define HDD_CACHE_BLOCK_SIZE    (HDD_CACHE_BLOCK_SECTORS << 9)
+#define HDD_CACHE_MIN_BLOCKS    4
+#define HDD_CACHE_NONE          -1
+
+#define HDD_CACHE_READ_AHEAD    1 /* Block was read ahead and has not been used yet. */
+
+typedef struct hdd_cache_block_t {
+    uint32_t block;
+    int      flags;
+    uint64_t valid; /* Sectors that hold image data. */
+    uint64_t dirty; /* Sectors that have not been written back yet. */
+    int      lru_prev;
+    int      lru_next;
+    int      hash_next;
+    uint8_t *data;
+} hdd_cache_block_t;
+
+typedef struct hdd_image_cache_t {
+    hdd_cache_block_t *blocks;
+    int               *hash;
+    uint64_t          *flush_order;
+    uint8_t           *data;
+    uint8_t           *fill; /* Scratch block to merge image data with dirty sectors. */
+    int                nr_blocks;
+    uint32_t           hash_mask;
+    int                lru_head; /* Most recently used. */
+    int                lru_tail;
+    int                dirty_blocks;
+    int                written; /* Written to since the last idle check. */
+    uint32_t           last_miss;
+
+    hdd_image_cache_stats_t stats;
+} hdd_image_cache_t;
+
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
@@ -51,6 +93,24 @@ typedef struct hdd_image_t {
     uint32_t  last_sector;
     uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
     uint8_t   loaded;
+
+    /* Background I/O, at most one request per image is in flight. */
+    thread_t  *io_thread;
+    event_t   *io_event;
+    event_t   *io_done_event;
+    atomic_int io_busy;
+    int        io_stop;
+    int        io_op;
+    uint32_t   io_sector;
+    uint32_t   io_count;
+    uint8_t   *io_buffer;
+
+    /* Request latency histogram, bucket n counts requests that took less
+       than 2^n microseconds. */
+    uint32_t latency[HDD_IMAGE_LATENCY_BUCKETS];
+
+    /* Sector cache, NULL if disabled. */
+    hdd_image_cache_t *cache;
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
@@ -506,6 +566,8 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     off64_t addr = sector;
     addr         = (uint64_t) sector << 9LL;
 
+    hdd_image_async_wait(id);
+
     hdd_images[id].pos = sector;
     if (hdd_images[id].type != HDD_IMAGE_VHD) {
         if (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)
@@ -513,24 +575,35 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     }
 }
 
-void
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+/* Update the position after a guest transfer of the given number of sectors.
+   VHD images point at the last sector transferred, raw images at the next one. */
+static void
+hdd_image_set_pos(uint8_t id, uint32_t sector, uint32_t transferred)
+{
+    if (hdd_images[id].type == HDD_IMAGE_VHD)
+        hdd_images[id].pos = sector + transferred - 1;
+    else
+        hdd_images[id].pos = sector + transferred;
+}
+
+/* Returns the number of sectors transferred, the position is left to the caller
+   so that cache fills and write backs do not move it. */
+static uint32_t
+hdd_image_raw_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_read;
+    int non_transferred_sectors;
 
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         non_transferred_sectors = mvhd_read_sectors(hdd_images[id].vhd, sector, count, buffer);
-        hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
-    } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Read error during seek\n", id);
-            return;
-        }
+        return count - non_transferred_sectors;
+    }
 
-        num_read           = fread(buffer, 512, count, hdd_images[id].file);
-        hdd_images[id].pos = sector + num_read;
+    if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
+        fatal("Hard disk image %i: Read error during seek\n", id);
+        return 0;
     }
+
+    return (uint32_t) fread(buffer, 512, count, hdd_images[id].file);
 }
 
 uint32_t
@@ -561,26 +634,661 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-void
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static uint32_t
+hdd_image_raw_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_write;
+    int non_transferred_sectors;
 
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         non_transferred_sectors = mvhd_write_sectors(hdd_images[id].vhd, sector, count, buffer);
-        hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
-    } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Write error during seek\n", id);
-            return;
+        return count - non_transferred_sectors;
+    }
+
+    if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
+        fatal("Hard disk image %i: Write error during seek\n", id);
+        return 0;
+    }
+
+    return (uint32_t) fwrite(buffer, 512, count, hdd_images[id].file);
+}
+
+static uint64_t
+hdd_cache_mask(int first, int count)
+{
+    uint64_t mask = (count >= HDD_CACHE_BLOCK_SECTORS) ? 0xffffffffffffffffULL : ((1ULL << count) - 1);
+
+    return mask << first;
+}
+
+static void
+hdd_cache_lru_unlink(hdd_image_cache_t *cache, int idx)
+{
+    hdd_cache_block_t *blk = &cache->blocks[idx];
+
+    if (blk->lru_prev != HDD_CACHE_NONE)
+        cache->blocks[blk->lru_prev].lru_next = blk->lru_next;
+    else
+        cache->lru_head = blk->lru_next;
+
+    if (blk->lru_next != HDD_CACHE_NONE)
+        cache->blocks[blk->lru_next].lru_prev = blk->lru_prev;
+    else
+        cache->lru_tail = blk->lru_prev;
+}
+
+static void
+hdd_cache_lru_touch(hdd_image_cache_t *cache, int idx)
+{
+    hdd_cache_block_t *blk = &cache->blocks[idx];
+
+    if (cache->lru_head == idx)
+        return;
+
+    hdd_cache_lru_unlink(cache, idx);
+
+    blk->lru_prev = HDD_CACHE_NONE;
+    blk->lru_next = cache->lru_head;
+    cache->blocks[cache->lru_head].lru_prev = idx;
+    cache->lru_head = idx;
+}
+
+static int
+hdd_cache_lookup(hdd_image_cache_t *cache, uint32_t block)
+{
+    int idx = cache->hash[block & cache->hash_mask];
+
+    while ((idx != HDD_CACHE_NONE) && (cache->blocks[idx].block != block))
+        idx = cache->blocks[idx].hash_next;
+
+    return idx;
+}
+
+static void
+hdd_cache_hash_remove(hdd_image_cache_t *cache, int idx)
+{
+    int *p = &cache->hash[cache->blocks[idx].block & cache->hash_mask];
+
+    while (*p != idx)
+        p = &cache->blocks[*p].hash_next;
+
+    *p = cache->blocks[idx].hash_next;
+}
+
+/* Write the dirty sectors of a block back to the image, merging runs of
+   adjacent sectors into single writes. */
+static void
+hdd_cache_write_back(uint8_t id, hdd_image_cache_t *cache, int idx)
+{
+    hdd_cache_block_t *blk   = &cache->blocks[idx];
+    uint32_t           base  = blk->block << HDD_CACHE_BLOCK_SHIFT;
+    int                first = 0;
+    int                last;
+
+    if (!blk->dirty)
+        return;
+
+    while (first < HDD_CACHE_BLOCK_SECTORS) {
+        if (!(blk->dirty & (1ULL << first))) {
+            first++;
+            continue;
+        }
+
+        for (last = first; (last < HDD_CACHE_BLOCK_SECTORS) && (blk->dirty & (1ULL << last)); last++)
+            ;
+
+        hdd_image_raw_write(id, base + first, last - first, &blk->data[first << 9]);
+        cache->stats.write_backs++;
+
+        first = last;
+    }
+
+    blk->dirty = 0;
+    cache->dirty_blocks--;
+}
+
+/* Take the least recently used block for a new block number. */
+static int
+hdd_cache_alloc(uint8_t id, hdd_image_cache_t *cache, uint32_t block)
+{
+    int                idx = cache->lru_tail;
+    hdd_cache_block_t *blk = &cache->blocks[idx];
+    uint32_t           hash;
+
+    if (blk->block != 0xffffffff) {
+        hdd_cache_write_back(id, cache, idx);
+        hdd_cache_hash_remove(cache, idx);
+    }
+
+    hash = block & cache->hash_mask;
+
+    blk->block     = block;
+    blk->flags     = 0;
+    blk->valid     = 0;
+    blk->dirty     = 0;
+    blk->hash_next = cache->hash[hash];
+    cache->hash[hash] = idx;
+
+    hdd_cache_lru_touch(cache, idx);
+
+    return idx;
+}
+
+/* Read the parts of a block that are not in the cache from the image. */
+static void
+hdd_cache_fill(uint8_t id, hdd_image_cache_t *cache, int idx)
+{
+    hdd_cache_block_t *blk  = &cache->blocks[idx];
+    uint32_t           base = blk->block << HDD_CACHE_BLOCK_SHIFT;
+    uint32_t           count;
+    uint64_t           mask;
+
+    if (base > hdd_images[id].last_sector)
+        return;
+
+    count = hdd_images[id].last_sector - base + 1;
+    if (count > HDD_CACHE_BLOCK_SECTORS)
+        count = HDD_CACHE_BLOCK_SECTORS;
+    mask = hdd_cache_mask(0, count);
+
+    if (!(blk->valid & mask))
+        hdd_image_raw_read(id, base, count, blk->data);
+    else if ((blk->valid & mask) != mask) {
+        hdd_image_raw_read(id, base, count, cache->fill);
+        for (uint32_t i = 0; i < count; i++) {
+            if (!(blk->valid & (1ULL << i)))
+                memcpy(&blk->data[i << 9], &cache->fill[i << 9], 512);
+        }
+    }
+
+    blk->valid |= mask;
+}
+
+static void
+hdd_cache_read_ahead(uint8_t id, hdd_image_cache_t *cache, uint32_t block)
+{
+    int idx;
+
+    if (((block << HDD_CACHE_BLOCK_SHIFT) > hdd_images[id].last_sector) ||
+        (hdd_cache_lookup(cache, block) != HDD_CACHE_NONE))
+        return;
+
+    idx = hdd_cache_alloc(id, cache, block);
+    hdd_cache_fill(id, cache, idx);
+    cache->blocks[idx].flags |= HDD_CACHE_READ_AHEAD;
+
+    cache->stats.read_ahead++;
+}
+
+static hdd_image_cache_t *
+hdd_cache_init(uint8_t id)
+{
+    hdd_image_cache_t *cache;
+    int                nr_blocks;
+    uint32_t           hash_size = 1;
+
+    nr_blocks = (int) (((uint64_t) hdd[id].cache_size << 20) / HDD_CACHE_BLOCK_SIZE);
+    if (nr_blocks < HDD_CACHE_MIN_BLOCKS)
+        nr_blocks = HDD_CACHE_MIN_BLOCKS;
+    while (hash_size < (uint32_t) nr_blocks)
+        hash_size <<= 1;
+
+    cache              = (hdd_image_cache_t *) calloc(1, sizeof(hdd_image_cache_t));
+    cache->blocks      = (hdd_cache_block_t *) calloc(nr_blocks, sizeof(hdd_cache_block_t));
+    cache->flush_order = (uint64_t *) calloc(nr_blocks, sizeof(uint64_t));
+    cache->hash        = (int *) malloc(hash_size * sizeof(int));
+    cache->data        = (uint8_t *) malloc((size_t) (nr_blocks + 1) * HDD_CACHE_BLOCK_SIZE);
+    if ((cache->blocks == NULL) || (cache->flush_order == NULL) || (cache->hash == NULL) || (cache->data == NULL))
+        fatal("Hard disk image %i: Unable to allocate a %u MB sector cache\n", id, hdd[id].cache_size);
+
+    cache->fill      = &cache->data[(size_t) nr_blocks * HDD_CACHE_BLOCK_SIZE];
+    cache->nr_blocks = nr_blocks;
+    cache->hash_mask = hash_size - 1;
+    cache->lru_head  = 0;
+    cache->lru_tail  = nr_blocks - 1;
+    cache->last_miss = 0xffffffff;
+
+    for (uint32_t i = 0; i < hash_size; i++)
+        cache->hash[i] = HDD_CACHE_NONE;
+
+    for (int i = 0; i < nr_blocks; i++) {
+        cache->blocks[i].block     = 0xffffffff;
+        cache->blocks[i].data      = &cache->data[(size_t) i * HDD_CACHE_BLOCK_SIZE];
+        cache->blocks[i].hash_next = HDD_CACHE_NONE;
+        cache->blocks[i].lru_prev  = i ? (i - 1) : HDD_CACHE_NONE;
+        cache->blocks[i].lru_next  = (i < (nr_blocks - 1)) ? (i + 1) : HDD_CACHE_NONE;
+    }
+
+    hdd_image_log("Hard disk image %i: %i block sector cache\n", id, nr_blocks);
+
+    return cache;
+}
+
+static int
+hdd_cache_order_cmp(const void *a, const void *b)
+{
+    uint64_t key_a = *(const uint64_t *) a;
+    uint64_t key_b = *(const uint64_t *) b;
+
+    return (key_a > key_b) - (key_a < key_b);
+}
+
+/* Write back all dirty blocks in image order. */
+static void
+hdd_cache_flush(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    int                count = 0;
+
+    if ((cache == NULL) || !cache->dirty_blocks)
+        return;
+
+    /* Sort by block number, with the block index in the low half. */
+    for (int i = 0; i < cache->nr_blocks; i++) {
+        if (cache->blocks[i].dirty)
+            cache->flush_order[count++] = ((uint64_t) cache->blocks[i].block << 32) | (uint32_t) i;
+    }
+
+    qsort(cache->flush_order, count, sizeof(uint64_t), hdd_cache_order_cmp);
+
+    for (int i = 0; i < count; i++)
+        hdd_cache_write_back(id, cache, (int) (cache->flush_order[i] & 0xffffffff));
+
+    if (hdd_images[id].file != NULL)
+        fflush(hdd_images[id].file);
+}
+
+static void
+hdd_cache_close(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+
+    if (cache == NULL)
+        return;
+
+    hdd_cache_flush(id);
+
+    hdd_image_log("Hard disk image %i: %" PRIu64 " sector read hits, %" PRIu64 " misses, %" PRIu64 " blocks read ahead, "
+                  "%" PRIu64 " sectors written, %" PRIu64 " write backs\n", id,
+                  cache->stats.read_hits, cache->stats.read_misses, cache->stats.read_ahead,
+                  cache->stats.write_sectors, cache->stats.write_backs);
+
+    free(cache->data);
+    free(cache->hash);
+    free(cache->flush_order);
+    free(cache->blocks);
+    free(cache);
+    hdd_images[id].cache = NULL;
+}
+
+/* Drop sectors from the cache, used when the image is changed behind its back. */
+static void
+hdd_cache_discard(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    hdd_cache_block_t *blk;
+    uint64_t           mask;
+    int                first;
+    int                n;
+    int                idx;
+
+    if (cache == NULL)
+        return;
+
+    while (count) {
+        first = sector & (HDD_CACHE_BLOCK_SECTORS - 1);
+        n     = HDD_CACHE_BLOCK_SECTORS - first;
+        if ((uint32_t) n > count)
+            n = count;
+
+        idx = hdd_cache_lookup(cache, sector >> HDD_CACHE_BLOCK_SHIFT);
+        if (idx != HDD_CACHE_NONE) {
+            blk  = &cache->blocks[idx];
+            mask = hdd_cache_mask(first, n);
+
+            blk->valid &= ~mask;
+            if (blk->dirty) {
+                blk->dirty &= ~mask;
+                if (!blk->dirty)
+                    cache->dirty_blocks--;
+            }
         }
 
-        num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
-        hdd_images[id].pos = sector + num_write;
+        sector += n;
+        count -= n;
     }
 }
 
+static void
+hdd_image_do_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    hdd_cache_block_t *blk;
+    uint32_t           start = sector;
+    uint32_t           done  = 0;
+    uint32_t           block;
+    uint64_t           mask;
+    int                first;
+    int                n;
+    int                idx;
+
+    if ((cache == NULL) && hdd[id].cache_size)
+        cache = hdd_images[id].cache = hdd_cache_init(id);
+
+    if (cache == NULL) {
+        hdd_image_set_pos(id, sector, hdd_image_raw_read(id, sector, count, buffer));
+        return;
+    }
+
+    while (count) {
+        block = sector >> HDD_CACHE_BLOCK_SHIFT;
+        first = sector & (HDD_CACHE_BLOCK_SECTORS - 1);
+        n     = HDD_CACHE_BLOCK_SECTORS - first;
+        if ((uint32_t) n > count)
+            n = count;
+        mask = hdd_cache_mask(first, n);
+
+        idx = hdd_cache_lookup(cache, block);
+        if ((idx != HDD_CACHE_NONE) && ((cache->blocks[idx].valid & mask) == mask)) {
+            cache->stats.read_hits += n;
+
+            hdd_cache_lru_touch(cache, idx);
+
+            /* Keep reading ahead as long as the guest keeps using it. */
+            if (cache->blocks[idx].flags & HDD_CACHE_READ_AHEAD) {
+                cache->blocks[idx].flags &= ~HDD_CACHE_READ_AHEAD;
+                hdd_cache_read_ahead(id, cache, block + 1);
+            }
+        } else {
+            cache->stats.read_misses += n;
+
+            if (idx == HDD_CACHE_NONE)
+                idx = hdd_cache_alloc(id, cache, block);
+            else
+                hdd_cache_lru_touch(cache, idx);
+            hdd_cache_fill(id, cache, idx);
+
+            if ((cache->blocks[idx].valid & mask) != mask) {
+                /* Past the end of the image, leave it to the image code. */
+                hdd_cache_write_back(id, cache, idx);
+                done += hdd_image_raw_read(id, sector, n, buffer);
+                goto next;
+            }
+
+            if (block == (cache->last_miss + 1))
+                hdd_cache_read_ahead(id, cache, block + 1);
+            cache->last_miss = block;
+        }
+
+        blk = &cache->blocks[idx];
+        memcpy(buffer, &blk->data[first << 9], n << 9);
+        done += n;
+
+next:
+        buffer += (n << 9);
+        sector += n;
+        count -= n;
+    }
+
+    hdd_image_set_pos(id, start, done);
+}
+
+static void
+hdd_image_do_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+    hdd_cache_block_t *blk;
+    uint32_t           start = sector;
+    uint32_t           done  = 0;
+    uint32_t           block;
+    uint64_t           mask;
+    int                first;
+    int                n;
+    int                idx;
+
+    if ((cache == NULL) && hdd[id].cache_size)
+        cache = hdd_images[id].cache = hdd_cache_init(id);
+
+    if (cache == NULL) {
+        hdd_image_set_pos(id, sector, hdd_image_raw_write(id, sector, count, buffer));
+        return;
+    }
+
+    while (count) {
+        block = sector >> HDD_CACHE_BLOCK_SHIFT;
+        first = sector & (HDD_CACHE_BLOCK_SECTORS - 1);
+        n     = HDD_CACHE_BLOCK_SECTORS - first;
+        if ((uint32_t) n > count)
+            n = count;
+
+        if ((sector + n - 1) > hdd_images[id].last_sector) {
+            /* Past the end of the image, write through. */
+            hdd_cache_discard(id, sector, n);
+            done += hdd_image_raw_write(id, sector, n, buffer);
+        } else {
+            mask = hdd_cache_mask(first, n);
+
+            idx = hdd_cache_lookup(cache, block);
+            if (idx == HDD_CACHE_NONE)
+                idx = hdd_cache_alloc(id, cache, block);
+            else
+                hdd_cache_lru_touch(cache, idx);
+
+            blk = &cache->blocks[idx];
+            memcpy(&blk->data[first << 9], buffer, n << 9);
+            if (!blk->dirty)
+                cache->dirty_blocks++;
+            blk->valid |= mask;
+            blk->dirty |= mask;
+
+            cache->stats.write_sectors += n;
+            done += n;
+        }
+
+        buffer += (n << 9);
+        sector += n;
+        count -= n;
+    }
+
+    cache->written = 1;
+    hdd_image_set_pos(id, start, done);
+
+    /* Do not let more than half of the cache hold unwritten data. */
+    if (cache->dirty_blocks > (cache->nr_blocks >> 1))
+        hdd_cache_flush(id);
+}
+
+/* Write back the caches of all images, on request or when they have not been
+   written to since the last call. Called once per emulated second. */
+static void
+hdd_image_flush_cond(int idle_only)
+{
+    hdd_image_cache_t *cache;
+
+    for (uint8_t id = 0; id < HDD_NUM; id++) {
+        cache = hdd_images[id].cache;
+        if ((cache == NULL) || !hdd_images[id].loaded)
+            continue;
+
+        if (idle_only) {
+            if (cache->written || hdd_image_async_busy(id)) {
+                cache->written = 0;
+                continue;
+            }
+        } else
+            hdd_image_async_wait(id);
+
+        hdd_cache_flush(id);
+    }
+}
+
+void
+hdd_image_flush_idle(void)
+{
+    hdd_image_flush_cond(1);
+}
+
+void
+hdd_image_flush_all(void)
+{
+    hdd_image_flush_cond(0);
+}
+
+void
+hdd_image_get_cache_stats(uint8_t id, hdd_image_cache_stats_t *stats)
+{
+    if (hdd_images[id].cache != NULL)
+        *stats = hdd_images[id].cache->stats;
+    else
+        memset(stats, 0, sizeof(hdd_image_cache_stats_t));
+}
+
+static void
+hdd_image_io_thread(void *priv)
+{
+    hdd_image_t *img = (hdd_image_t *) priv;
+    uint8_t      id  = (uint8_t) (img - hdd_images);
+    uint64_t     start;
+    uint64_t     elapsed;
+    int          bucket;
+
+    while (1) {
+        thread_wait_event(img->io_event, -1);
+        thread_reset_event(img->io_event);
+
+        if (img->io_stop)
+            break;
+
+        if (!atomic_load(&img->io_busy))
+            continue;
+
+        start = plat_get_micro_ticks();
+
+        if (img->io_op == HDD_IO_WRITE)
+            hdd_image_do_write(id, img->io_sector, img->io_count, img->io_buffer);
+        else
+            hdd_image_do_read(id, img->io_sector, img->io_count, img->io_buffer);
+
+        elapsed = plat_get_micro_ticks() - start;
+        for (bucket = 0; (bucket < (HDD_IMAGE_LATENCY_BUCKETS - 1)) && (elapsed >= (1ULL << bucket)); bucket++)
+            ;
+        img->latency[bucket]++;
+
+        atomic_store(&img->io_busy, 0);
+        thread_set_event(img->io_done_event);
+    }
+}
+
+static void
+hdd_image_io_stop(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (img->io_thread == NULL)
+        return;
+
+    hdd_image_async_wait(id);
+
+    img->io_stop = 1;
+    thread_set_event(img->io_event);
+    thread_wait(img->io_thread);
+    img->io_thread = NULL;
+
+    thread_destroy_event(img->io_event);
+    thread_destroy_event(img->io_done_event);
+    img->io_event      = NULL;
+    img->io_done_event = NULL;
+
+#ifdef ENABLE_HDD_IMAGE_LOG
+    for (int i = 0; i < HDD_IMAGE_LATENCY_BUCKETS; i++) {
+        if (img->latency[i])
+            hdd_image_log("Hard disk image %i: %u requests under %" PRIu64 " us\n", id, img->latency[i], 1ULL << i);
+    }
+#endif
+}
+
+static int
+hdd_image_submit(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (!img->loaded)
+        return 0;
+
+    hdd_image_async_wait(id);
+
+    if (img->io_thread == NULL) {
+        img->io_stop       = 0;
+        img->io_event      = thread_create_event();
+        img->io_done_event = thread_create_event();
+        img->io_thread     = thread_create(hdd_image_io_thread, img);
+    }
+
+    img->io_op     = op;
+    img->io_sector = sector;
+    img->io_count  = count;
+    img->io_buffer = buffer;
+
+    thread_reset_event(img->io_done_event);
+    atomic_store(&img->io_busy, 1);
+    thread_set_event(img->io_event);
+
+    return 1;
+}
+
+/* Queue a read or write to run on the image's I/O thread, so a slow host disk
+   does not stall the emulation. Returns 0 if the request could not be queued,
+   in which case the caller has to fall back to the synchronous functions. The
+   buffer must stay untouched until hdd_image_async_busy() returns 0. Any other
+   access to the image waits for the request to complete first. */
+int
+hdd_image_read_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    return hdd_image_submit(id, HDD_IO_READ, sector, count, buffer);
+}
+
+int
+hdd_image_write_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    return hdd_image_submit(id, HDD_IO_WRITE, sector, count, buffer);
+}
+
+int
+hdd_image_async_busy(uint8_t id)
+{
+    return atomic_load(&hdd_images[id].io_busy);
+}
+
+void
+hdd_image_async_wait(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    while (atomic_load(&img->io_busy)) {
+        thread_wait_event(img->io_done_event, -1);
+        thread_reset_event(img->io_done_event);
+    }
+}
+
+void
+hdd_image_get_latency(uint8_t id, uint32_t *buckets)
+{
+    memcpy(buckets, hdd_images[id].latency, sizeof(hdd_images[id].latency));
+}
+
+void
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_async_wait(id);
+    hdd_image_do_read(id, sector, count, buffer);
+}
+
+void
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_async_wait(id);
+    hdd_image_do_write(id, sector, count, buffer);
+}
+
 int
 hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
@@ -600,6 +1308,9 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 void
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
+    hdd_image_async_wait(id);
+    hdd_cache_discard(id, sector, count);
+
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
         hdd_images[id].pos          = sector + count - non_transferred_sectors - 1;
@@ -655,6 +1366,9 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
     if (strlen(hdd[id].fn) == 0)
         return;
 
+    hdd_image_io_stop(id);
+    hdd_cache_close(id);
+
     if (hdd_images[id].loaded) {
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
@@ -679,6 +1393,9 @@ hdd_image_close(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_image_io_stop(id);
+    hdd_cache_close(id);
+
     if (hdd_images[id].file != NULL) {
         fclose(hdd_images[id].file);
         hdd_images[id].file = NULL;
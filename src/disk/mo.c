@@ -527,7 +527,7 @@ mo_mode_sense_save(mo_t *dev)
         sprintf(fn, "scsi_mo_%02i_mode_sense_bin", dev->id);
     else
         sprintf(fn, "mo_%02i_mode_sense_bin", dev->id);
-    fp = plat_fopen(nvr_path(fn), "wb");
+    fp = nvr_fopen(fn, "wb");
     if (fp) {
         /* Nothing to write, not used by MO. */
         fclose(fp);
@@ -684,7 +684,7 @@ zip_mode_sense_save(zip_t *dev)
         sprintf(fn, "scsi_zip_%02i_mode_sense_bin", dev->id);
     else
         sprintf(fn, "zip_%02i_mode_sense_bin", dev->id);
-    fp = plat_fopen(nvr_path(fn), "wb");
+    fp = nvr_fopen(fn, "wb");
     if (fp) {
         /* Nothing to write, not used by ZIP. */
         fclose(fp);
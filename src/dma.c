@@ -33,6 +33,7 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 dma_t   dma[8];
@@ -1853,10 +1854,8 @@ dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int Tra
     n2 = TotalSize - n;
 
     /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
-    }
+    if (n)
+        mem_read_phys_span(DataRead, PhysAddress, n, TransferSize);
 
     /* Do the non-divisible block, if there is one. */
     if (n2) {
@@ -1876,10 +1875,8 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
     n2 = TotalSize - n;
 
     /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
-    }
+    if (n)
+        mem_write_phys_span(DataWrite, PhysAddress, n, TransferSize);
 
     /* Do the non-divisible block, if there is one. */
     if (n2) {
@@ -1891,3 +1888,41 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
     if (dma_at)
         mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
 }
+
+void
+dma_save_state(snapshot_t *snap)
+{
+    snapshot_write(snap, dma, sizeof(dma));
+    snapshot_write_u8(snap, dma_e);
+    snapshot_write_u8(snap, dma_m);
+    snapshot_write(snap, dmaregs, sizeof(dmaregs));
+    snapshot_write(snap, dma_wp, sizeof(dma_wp));
+    snapshot_write_u8(snap, dma_stat);
+    snapshot_write_u8(snap, dma_stat_rq);
+    snapshot_write_u8(snap, dma_stat_rq_pc);
+    snapshot_write_u8(snap, dma_stat_adv_pend);
+    snapshot_write(snap, dma_command, sizeof(dma_command));
+    snapshot_write_u8(snap, dma_req_is_soft);
+    snapshot_write_u16(snap, dma_sg_base);
+    snapshot_write(snap, &dma_ps2, sizeof(dma_ps2));
+}
+
+int
+dma_load_state(snapshot_t *snap)
+{
+    snapshot_read(snap, dma, sizeof(dma));
+    dma_e = snapshot_read_u8(snap);
+    dma_m = snapshot_read_u8(snap);
+    snapshot_read(snap, dmaregs, sizeof(dmaregs));
+    snapshot_read(snap, dma_wp, sizeof(dma_wp));
+    dma_stat          = snapshot_read_u8(snap);
+    dma_stat_rq       = snapshot_read_u8(snap);
+    dma_stat_rq_pc    = snapshot_read_u8(snap);
+    dma_stat_adv_pend = snapshot_read_u8(snap);
+    snapshot_read(snap, dma_command, sizeof(dma_command));
+    dma_req_is_soft = snapshot_read_u8(snap);
+    dma_sg_base     = snapshot_read_u16(snap);
+    snapshot_read(snap, &dma_ps2, sizeof(dma_ps2));
+
+    return !snapshot_error(snap);
+}
@@ -31,6 +31,7 @@
 #define CONFIG_FILE     "86box.cfg"
 #define NVR_PATH        "nvr"
 #define SCREENSHOT_PATH "screenshots"
+#define VIDEO_CAPTURE_PATH "videos"
 
 /* Recently used images */
 #define MAX_PREV_IMAGES    4
@@ -58,6 +59,9 @@
 #    undef ABSD
 #endif
 
+/* Exit code reported when the batch mode time budget runs out. */
+#define BATCH_EXIT_BUDGET 0xfe
+
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define ABS(x)    ((x) > 0 ? (x) : -(x))
@@ -98,6 +102,9 @@ extern uint64_t source_hwnd;
 extern char rom_path[1024]; /* (O) full path to ROMs */
 extern char log_path[1024]; /* (O) full path of logfile */
 extern char vm_name[1024];  /* (O) display name of the VM */
+extern int      batch_mode;      /* (O) run headless and unthrottled */
+extern uint64_t batch_budget_ms; /* (O) emulated time budget in batch mode, 0 = none */
+extern int      batch_exit_code; /* exit code reported at the end of batch mode */
 #ifdef USE_INSTRUMENT
 extern uint8_t  instru_enabled;
 extern uint64_t instru_run_ms;
@@ -141,6 +148,7 @@ extern uint32_t mem_size;                   /* (C) memory size (Installed on sys
 extern uint32_t isa_mem_size;               /* (C) memory size (ISA Memory Cards) */
 extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
+extern int      dynarec_cache_size;         /* (C) dynarec code cache size in MB */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
 extern int      time_sync;                  /* (C) enable time sync */
@@ -207,6 +215,10 @@ extern void pc_close(void *threadid);
 extern void pc_reset_hard_close(void);
 extern void pc_reset_hard_init(void);
 extern void pc_reset_hard(void);
+extern void pc_save_state(const char *fn);
+extern void pc_load_state(const char *fn);
+extern void pc_snapshot_poll(void);
+extern void pc_batch_exit(int code);
 extern void pc_full_speed(void);
 extern void pc_speed_changed(void);
 extern void pc_send_cad(void);
@@ -164,6 +164,8 @@ typedef struct _device_config_ {
     const device_config_bios_t      bios[32];
 } device_config_t;
 
+struct snapshot_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -184,6 +186,10 @@ typedef struct _device_ {
     void (*force_redraw)(void *priv);
 
     const device_config_t *config;
+
+    /* Optional save state hooks, see snapshot.h. */
+    void (*save_state)(void *priv, struct snapshot_t *snap);
+    int (*load_state)(void *priv, struct snapshot_t *snap, uint32_t version);
 } device_t;
 
 typedef struct device_context_t {
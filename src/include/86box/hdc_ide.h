@@ -95,6 +95,7 @@ typedef struct ide_s {
     int      reset;
     int      mdma_mode;
     int      do_initial_read;
+    int      io_pending;
     uint32_t drive;
     uint32_t cfg_spt;
     uint32_t cfg_hpc;
@@ -180,6 +180,7 @@ typedef struct hard_disk_t {
 
     uint32_t speed_preset;
     uint32_t vhd_blocksize;
+    uint32_t cache_size; /* Host sector cache in MB, 0 = disabled */
 
     double avg_rotation_lat_usec;
     double full_stroke_usec;
@@ -195,6 +196,16 @@ extern int   hdd_string_to_bus(char *str, int cdrom);
 extern char *hdd_bus_to_string(int bus, int cdrom);
 extern int   hdd_is_valid(int c);
 
+#define HDD_IMAGE_LATENCY_BUCKETS 24
+
+typedef struct hdd_image_cache_stats_t {
+    uint64_t read_hits;     /* Sectors read from the cache. */
+    uint64_t read_misses;   /* Sectors that had to be read from the image. */
+    uint64_t read_ahead;    /* Blocks read ahead of the guest. */
+    uint64_t write_sectors; /* Sectors written to the cache. */
+    uint64_t write_backs;   /* Writes issued to the image. */
+} hdd_image_cache_stats_t;
+
 extern void     hdd_image_init(void);
 extern int      hdd_image_load(int id);
 extern void     hdd_image_seek(uint8_t id, uint32_t sector);
@@ -202,6 +213,14 @@ extern void     hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint
 extern int      hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void     hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int      hdd_image_read_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int      hdd_image_write_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int      hdd_image_async_busy(uint8_t id);
+extern void     hdd_image_async_wait(uint8_t id);
+extern void     hdd_image_get_latency(uint8_t id, uint32_t *buckets);
+extern void     hdd_image_get_cache_stats(uint8_t id, hdd_image_cache_stats_t *stats);
+extern void     hdd_image_flush_idle(void);
+extern void     hdd_image_flush_all(void);
 extern void     hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count);
 extern int      hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count);
 extern uint32_t hdd_image_get_last_sector(uint8_t id);
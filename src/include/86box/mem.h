@@ -134,6 +134,12 @@
 #define MEM_GRANULARITY_PAGE   (MEM_GRANULARITY_MASK & ~0xfff)
 #define MEM_GRANULARITY_BASE   (~MEM_GRANULARITY_MASK)
 
+/* Soft TLB geometry: sets are selected by the low bits of the virtual
+   page number, each set holds MMU_TLB_WAYS entries. */
+#define MMU_TLB_SETS 256
+#define MMU_TLB_WAYS 4
+#define MMU_TLB_SIZE (MMU_TLB_SETS * MMU_TLB_WAYS)
+
 /* Compatibility #defines. */
 #define mem_set_state(smm, mode, base, size, access) \
     mem_set_access((smm ? ACCESS_SMM : ACCESS_NORMAL), mode, base, size, access)
@@ -213,10 +219,10 @@ typedef struct page_t {
 
     uint8_t *mem;
 
-    uint16_t block, block_2;
+    uint32_t block, block_2;
 
     /*Head of codeblock tree associated with this page*/
-    uint16_t head;
+    uint32_t head;
 
     uint64_t code_present_mask;
     uint64_t dirty_mask;
@@ -263,14 +269,12 @@ extern uint8_t *rom;
 extern uint32_t biosmask;
 extern uint32_t biosaddr;
 
-extern int        readlookup[256];
+extern int        readlookup[MMU_TLB_SIZE];
 extern uintptr_t *readlookup2;
 extern uintptr_t  old_rl2;
 extern uint8_t    uncached;
-extern int        readlnext;
-extern int        writelookup[256];
+extern int        writelookup[MMU_TLB_SIZE];
 extern uintptr_t *writelookup2;
-extern int        writelnext;
 extern uint32_t   ram_mapped_addr[64];
 extern uint8_t    page_ff[4096];
 
@@ -296,6 +300,9 @@ extern int shadowbios;
 extern int shadowbios_write;
 extern int readlnum;
 extern int writelnum;
+extern int mmuflush;
+extern int mmuflush_nonglobal;
+extern int mmuflush_global_kept;
 
 extern int memspeed[11];
 
@@ -417,6 +424,8 @@ extern void     mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void     mem_writew_phys(uint32_t addr, uint16_t val);
 extern void     mem_writel_phys(uint32_t addr, uint32_t val);
 extern void     mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern void     mem_read_phys_span(void *dest, uint32_t addr, uint32_t len, int transfer_size);
+extern void     mem_write_phys_span(const void *src, uint32_t addr, uint32_t len, int transfer_size);
 
 extern uint8_t  mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t mem_read_ramw(uint32_t addr, void *priv);
@@ -448,6 +457,7 @@ extern void mem_reset_page_blocks(void);
 extern void flushmmucache(void);
 extern void flushmmucache_pc(void);
 extern void flushmmucache_nopc(void);
+extern void flushmmucache_nonglobal(void);
 
 extern void mem_debug_check_addr(uint32_t addr, int write);
 
@@ -64,6 +64,9 @@ typedef struct scsi_disk_t {
     uint32_t packet_len;
 
     double callback;
+
+    /* Buffer of a write still running on the image's I/O thread. */
+    uint8_t *io_buffer;
 } scsi_disk_t;
 
 extern scsi_disk_t *scsi_disk[HDD_NUM];
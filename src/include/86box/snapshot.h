@@ -0,0 +1,139 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the machine save state (snapshot) subsystem.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#ifndef EMU_SNAPSHOT_H
+#define EMU_SNAPSHOT_H
+
+#define SNAPSHOT_MAGIC      "86BoxSNP"
+#define SNAPSHOT_VERSION    1
+
+/* Size of the uncompressed chunks the stream is cut into. */
+#define SNAPSHOT_CHUNK_SIZE 65536
+
+/* Chunk encodings. */
+#define SNAPSHOT_ENC_RAW    0
+#define SNAPSHOT_ENC_ZERO   1 /* chunk is all zeroes, no payload */
+#define SNAPSHOT_ENC_RLE    2 /* PackBits run-length encoding */
+
+#define SNAPSHOT_TAG_LEN    64
+
+typedef struct snapshot_t snapshot_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern snapshot_t *snapshot_open(const char *fn, int write);
+extern int         snapshot_close(snapshot_t *snap);
+extern int         snapshot_error(const snapshot_t *snap);
+extern void        snapshot_set_error(snapshot_t *snap);
+
+/* Sections group the state of one module or device. */
+extern void snapshot_section_begin(snapshot_t *snap, const char *tag, uint32_t version);
+extern void snapshot_section_end(snapshot_t *snap);
+extern int  snapshot_section_next(snapshot_t *snap, char *tag, uint32_t *version);
+extern void snapshot_section_skip(snapshot_t *snap);
+
+extern void snapshot_write(snapshot_t *snap, const void *data, size_t len);
+extern void snapshot_read(snapshot_t *snap, void *data, size_t len);
+
+#ifdef _TIMER_H_
+/* Timers are stored relative to the current TSC. */
+extern void snapshot_write_timer(snapshot_t *snap, const pc_timer_t *timer);
+extern void snapshot_read_timer(snapshot_t *snap, pc_timer_t *timer);
+#endif
+
+static __inline void
+snapshot_write_u8(snapshot_t *snap, uint8_t val)
+{
+    snapshot_write(snap, &val, sizeof(val));
+}
+
+static __inline void
+snapshot_write_u16(snapshot_t *snap, uint16_t val)
+{
+    snapshot_write(snap, &val, sizeof(val));
+}
+
+static __inline void
+snapshot_write_u32(snapshot_t *snap, uint32_t val)
+{
+    snapshot_write(snap, &val, sizeof(val));
+}
+
+static __inline void
+snapshot_write_u64(snapshot_t *snap, uint64_t val)
+{
+    snapshot_write(snap, &val, sizeof(val));
+}
+
+static __inline uint8_t
+snapshot_read_u8(snapshot_t *snap)
+{
+    uint8_t val = 0;
+
+    snapshot_read(snap, &val, sizeof(val));
+    return val;
+}
+
+static __inline uint16_t
+snapshot_read_u16(snapshot_t *snap)
+{
+    uint16_t val = 0;
+
+    snapshot_read(snap, &val, sizeof(val));
+    return val;
+}
+
+static __inline uint32_t
+snapshot_read_u32(snapshot_t *snap)
+{
+    uint32_t val = 0;
+
+    snapshot_read(snap, &val, sizeof(val));
+    return val;
+}
+
+static __inline uint64_t
+snapshot_read_u64(snapshot_t *snap)
+{
+    uint64_t val = 0;
+
+    snapshot_read(snap, &val, sizeof(val));
+    return val;
+}
+
+/* Whole machine save and restore, called from pc_run() only. */
+extern int snapshot_save(const char *fn);
+extern int snapshot_load(const char *fn);
+
+/* Module state handlers. */
+extern void        mem_save_state(snapshot_t *snap);
+extern int         mem_load_state(snapshot_t *snap);
+extern void        dma_save_state(snapshot_t *snap);
+extern int         dma_load_state(snapshot_t *snap);
+extern void        pic_save_state(snapshot_t *snap);
+extern int         pic_load_state(snapshot_t *snap);
+extern const char *device_state_missing(void);
+extern int         device_state_count(void);
+extern void        device_save_state_all(snapshot_t *snap);
+extern int         device_load_state(snapshot_t *snap, const char *tag, uint32_t version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SNAPSHOT_H*/
@@ -50,8 +50,8 @@ typedef struct pc_timer_t {
     void (*callback)(void *priv);
     void *priv;
 
-    struct pc_timer_t *prev;
-    struct pc_timer_t *next;
+    uint32_t heap_idx; /* Position in the timer heap while enabled. */
+    uint32_t seq;      /* Enable order, used to break ties. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -188,6 +188,20 @@ extern void timer_on_auto(pc_timer_t *timer, double period);
 /* Change TSC, taking into account the timers. */
 extern void timer_set_new_tsc(uint64_t new_tsc);
 
+/*Timer trace, written to timer_trace.bin in the user path when timer.c is
+  built with ENABLE_TIMER_TRACE, and replayed by bench/timer_bench.c. Timers
+  are numbered in order of first use.*/
+#define TIMER_TRACE_ENABLE  1 /*ts is the timestamp of the timer*/
+#define TIMER_TRACE_DISABLE 2
+#define TIMER_TRACE_PROCESS 3 /*ts is the TSC*/
+#define TIMER_TRACE_NEW_TSC 4 /*ts is the new TSC*/
+
+typedef struct timer_trace_t {
+    uint32_t op;
+    uint32_t id;
+    uint64_t ts;
+} timer_trace_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -113,6 +113,13 @@ typedef struct svga_t {
     int lastline;
     int firstline_draw;
     int lastline_draw;
+    int dirty_top;    /* first and last target buffer lines written */
+    int dirty_bottom; /* this frame, for the blit consumers */
+    int dirty_full;
+    int dirty_valid;  /* set by svga_poll() for its own blits */
+    int dirty_dpms;
+    int render_defer;  /* the renderers may queue spans on the render pool */
+    int render_queued; /* the current line was queued */
     int displine;
     int fullchange;
     int x_add;
@@ -160,6 +167,7 @@ typedef struct svga_t {
     uint32_t  banked_mask;
     uint32_t  ca;
     uint32_t  overscan_color;
+    uint32_t  dirty_overscan; /* overscan colour of the last blit */
     uint32_t *map8;
     uint32_t  pallook[512];
 
@@ -293,6 +301,13 @@ typedef struct svga_t {
     void *  ext8514;
     void *  clock_gen8514;
     void *  xga;
+
+    /* Worker threads for the span renderers, NULL if disabled. */
+    void *render_pool;
+
+    /* Resolution of the device overriding the output, if any. */
+    int override_x;
+    int override_y;
 } svga_t;
 
 extern int      vga_on;
@@ -329,6 +344,7 @@ extern int  svga_init(const device_t *info, svga_t *svga, void *priv, int memsiz
                       void (*hwcursor_draw)(struct svga_t *svga, int displine),
                       void (*overlay_draw)(struct svga_t *svga, int displine));
 extern void svga_recalctimings(svga_t *svga);
+extern uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
 extern void svga_close(svga_t *svga);
 
 uint8_t  svga_read(uint32_t addr, void *priv);
@@ -355,6 +371,7 @@ uint8_t svga_in(uint16_t addr, void *priv);
 
 svga_t *svga_get_pri(void);
 void    svga_set_override(svga_t *svga, int val);
+int     svga_set_override_size(svga_t *svga, int x, int y);
 
 void svga_set_ramdac_type(svga_t *svga, int type);
 void svga_close(svga_t *svga);
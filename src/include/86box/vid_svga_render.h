@@ -38,6 +38,15 @@ extern uint8_t egaremap2bpp[256];
 
 extern void svga_recalc_remap_func(svga_t *svga);
 
+/* Convert a span now, or queue it on the render pool from svga_do_render(). */
+extern void svga_render_span_8(svga_t *svga, uint32_t *p, uint32_t addr, int n);
+extern void svga_render_span(svga_t *svga, uint32_t *p, uint32_t addr, int n, int bpp);
+
+extern void svga_render_pool_init(svga_t *svga);
+extern void svga_render_pool_close(svga_t *svga);
+extern void svga_render_pool_wait(svga_t *svga);
+extern void svga_render_pool_fill(svga_t *svga, uint32_t *p, int n, uint32_t color);
+
 extern void svga_render_null(svga_t *svga);
 extern void svga_render_blank(svga_t *svga);
 extern void svga_render_overscan_left(svga_t *svga);
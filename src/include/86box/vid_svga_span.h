@@ -0,0 +1,47 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the SVGA span converters.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+
+#ifndef VIDEO_SVGA_SPAN_H
+#define VIDEO_SVGA_SPAN_H
+
+#define SVGA_SPAN_IMPLS_MAX 8
+
+/* One set of converters for an instruction set, NULL where the set has
+   nothing better than the sets before it. */
+typedef struct svga_span_impl_t {
+    const char *name;
+    int         cpu;
+
+    void (*span_8to32)(uint32_t *p, const uint8_t *src, const uint32_t *pal, uint8_t mask, int n);
+    void (*span_15to32)(uint32_t *p, const uint8_t *src, int n);
+    void (*span_16to32)(uint32_t *p, const uint8_t *src, int n);
+    void (*span_24to32)(uint32_t *p, const uint8_t *src, int n);
+    void (*span_32to32)(uint32_t *p, const uint8_t *src, int n);
+} svga_span_impl_t;
+
+/* Span converters, picked for the host CPU by svga_span_init(). */
+extern void (*svga_span_8to32)(uint32_t *p, const uint8_t *src, const uint32_t *pal, uint8_t mask, int n);
+extern void (*svga_span_15to32)(uint32_t *p, const uint8_t *src, int n);
+extern void (*svga_span_16to32)(uint32_t *p, const uint8_t *src, int n);
+extern void (*svga_span_24to32)(uint32_t *p, const uint8_t *src, int n);
+extern void (*svga_span_32to32)(uint32_t *p, const uint8_t *src, int n);
+
+/* The converter sets the host CPU can run, the scalar one first. */
+extern int  svga_span_get_impls(const svga_span_impl_t **impls, int max);
+extern void svga_span_init(void);
+
+#endif /*VIDEO_SVGA_SPAN_H*/
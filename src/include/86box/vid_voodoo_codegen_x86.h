@@ -14,9 +14,10 @@
 #    include <xmmintrin.h>
 #endif
 
-#define BLOCK_NUM  8
-#define BLOCK_MASK (BLOCK_NUM - 1)
-#define BLOCK_SIZE 8192
+#define BLOCK_NUM      256
+#define BLOCK_WAYS     4
+#define BLOCK_SET_MASK ((BLOCK_NUM / BLOCK_WAYS) - 1)
+#define BLOCK_SIZE     8192
 
 #define LOD_MASK   (LOD_TMIRROR_S | LOD_TMIRROR_T)
 
@@ -36,10 +37,20 @@ typedef struct voodoo_x86_data_t {
     uint32_t tLOD[2];
     uint32_t trexInit1;
     int      is_tiled;
+
+    atomic_int valid; /*Cleared while the block is being recompiled*/
+    atomic_int users; /*Render threads currently drawing with the block*/
+    atomic_int last_used;
 } voodoo_x86_data_t;
 
-static int last_block[4]          = { 0, 0 };
-static int next_block_to_write[4] = { 0, 0 };
+/*Compiled pipelines are shared by all render threads. The cache is set
+  associative : a state combination can only live in the BLOCK_WAYS blocks of
+  the set it hashes to, and a miss replaces the least recently used block of
+  that set that no thread is drawing with.*/
+typedef struct voodoo_codegen_t {
+    voodoo_x86_data_t *blocks;
+    mutex_t           *mutex; /*Serialises compiles*/
+} voodoo_codegen_t;
 
 #define addbyte(val)                   \
     do {                               \
@@ -3132,29 +3143,117 @@ voodoo_generate(uint8_t *code_block, voodoo_t *voodoo, voodoo_params_t *params,
 }
 int voodoo_recomp = 0;
 
+static __inline uint32_t
+voodoo_block_hash(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state)
+{
+    uint32_t hash = params->alphaMode ^ (params->fbzMode * 3) ^ (params->fogMode * 5) ^ (params->fbzColorPath * 7) ^ (params->textureMode[0] * 11) ^ (params->textureMode[1] * 13);
+
+    hash ^= ((params->tLOD[0] & LOD_MASK) >> 16) ^ ((params->tLOD[1] & LOD_MASK) >> 14) ^ ((voodoo->trexInit1[0] & (1 << 18)) >> 10);
+    hash ^= ((state->xdir > 0) ? 1 : 0) ^ ((params->col_tiled || params->aux_tiled) ? 2 : 0);
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+
+    return hash & BLOCK_SET_MASK;
+}
+
+static __inline int
+voodoo_block_matches(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, voodoo_x86_data_t *data)
+{
+    return state->xdir == data->xdir && params->alphaMode == data->alphaMode && params->fbzMode == data->fbzMode && params->fogMode == data->fogMode && params->fbzColorPath == data->fbzColorPath && (voodoo->trexInit1[0] & (1 << 18)) == data->trexInit1 && params->textureMode[0] == data->textureMode[0] && params->textureMode[1] == data->textureMode[1] && (params->tLOD[0] & LOD_MASK) == data->tLOD[0] && (params->tLOD[1] & LOD_MASK) == data->tLOD[1] && ((params->col_tiled || params->aux_tiled) ? 1 : 0) == data->is_tiled;
+}
+
+/*Looks for the pipeline in one set, and if found holds it for this thread
+  until voodoo_put_block(). The block must be pinned before it is checked,
+  so that a concurrent recompile either sees the pin or invalidates the
+  block before we look at it.*/
+static __inline void *
+voodoo_find_block(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int odd_even, int set)
+{
+    voodoo_codegen_t *codegen = voodoo->codegen_data;
+    int               stamp   = voodoo->params_read_idx[odd_even];
+
+    for (int c = set * BLOCK_WAYS; c < (set + 1) * BLOCK_WAYS; c++) {
+        voodoo_x86_data_t *data = &codegen->blocks[c];
+
+        data->users++;
+        if (data->valid && voodoo_block_matches(voodoo, params, state, data)) {
+            if ((stamp - atomic_load_explicit(&data->last_used, memory_order_relaxed)) > 64)
+                atomic_store_explicit(&data->last_used, stamp, memory_order_relaxed);
+            voodoo->thread_stats[odd_even].codegen_block = c;
+            return data->code_block;
+        }
+        data->users--;
+    }
+
+    return NULL;
+}
+
 static inline void *
 voodoo_get_block(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int odd_even)
 {
-    int                c;
-    int                b = last_block[odd_even];
-    voodoo_x86_data_t *data;
-    voodoo_x86_data_t *codegen_data = voodoo->codegen_data;
+    voodoo_codegen_t      *codegen = voodoo->codegen_data;
+    voodoo_thread_stats_t *stats   = &voodoo->thread_stats[odd_even];
+    int                    set     = voodoo_block_hash(voodoo, params, state);
+    int                    victim;
+    voodoo_x86_data_t     *data;
+    void                  *code_block;
+
+    code_block = voodoo_find_block(voodoo, params, state, odd_even, set);
+    if (code_block) {
+        stats->codegen_hits++;
+        return code_block;
+    }
 
-    for (c = 0; c < 8; c++) {
-        data = &codegen_data[odd_even + b * 4];
+    thread_wait_mutex(codegen->mutex);
 
-        if (state->xdir == data->xdir && params->alphaMode == data->alphaMode && params->fbzMode == data->fbzMode && params->fogMode == data->fogMode && params->fbzColorPath == data->fbzColorPath && (voodoo->trexInit1[0] & (1 << 18)) == data->trexInit1 && params->textureMode[0] == data->textureMode[0] && params->textureMode[1] == data->textureMode[1] && (params->tLOD[0] & LOD_MASK) == data->tLOD[0] && (params->tLOD[1] & LOD_MASK) == data->tLOD[1] && ((params->col_tiled || params->aux_tiled) ? 1 : 0) == data->is_tiled) {
-            last_block[odd_even] = b;
-            return data->code_block;
+    /*Another thread may have compiled it while we waited*/
+    code_block = voodoo_find_block(voodoo, params, state, odd_even, set);
+    if (code_block) {
+        thread_release_mutex(codegen->mutex);
+        stats->codegen_hits++;
+        return code_block;
+    }
+
+    for (;;) {
+        victim = -1;
+        for (int c = set * BLOCK_WAYS; c < (set + 1) * BLOCK_WAYS; c++) {
+            data = &codegen->blocks[c];
+
+            if (data->users)
+                continue;
+            if (victim == -1 || !data->valid || (data->last_used - codegen->blocks[victim].last_used) < 0)
+                victim = c;
+            if (!data->valid)
+                break;
+        }
+        if (victim != -1) {
+            data        = &codegen->blocks[victim];
+            data->valid = 0;
+            if (!data->users)
+                break;
+
+            /*Picked up by a render thread after the check above*/
+            data->valid = 1;
+            continue;
         }
 
-        b = (b + 1) & 7;
+        /*Every way is being drawn with. Let the other threads get on with
+          their triangles, one of them may even compile this pipeline, and
+          look again.*/
+        thread_release_mutex(codegen->mutex);
+        plat_delay_ms(0);
+        thread_wait_mutex(codegen->mutex);
+
+        code_block = voodoo_find_block(voodoo, params, state, odd_even, set);
+        if (code_block) {
+            thread_release_mutex(codegen->mutex);
+            stats->codegen_hits++;
+            return code_block;
+        }
     }
+
     voodoo_recomp++;
-    data = &codegen_data[odd_even + next_block_to_write[odd_even] * 4];
-#if 0
-    code_block = data->code_block;
-#endif
+    stats->codegen_misses++;
 
     voodoo_generate(data->code_block, voodoo, params, state, depth_op);
 
@@ -3169,16 +3268,33 @@ voodoo_get_block(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *stat
     data->tLOD[0]        = params->tLOD[0] & LOD_MASK;
     data->tLOD[1]        = params->tLOD[1] & LOD_MASK;
     data->is_tiled       = (params->col_tiled || params->aux_tiled) ? 1 : 0;
+    data->last_used      = voodoo->params_read_idx[odd_even];
+
+    data->users++;
+    data->valid          = 1;
+    stats->codegen_block = victim;
 
-    next_block_to_write[odd_even] = (next_block_to_write[odd_even] + 1) & 7;
+    thread_release_mutex(codegen->mutex);
 
     return data->code_block;
 }
 
+static __inline void
+voodoo_put_block(voodoo_t *voodoo, int odd_even)
+{
+    voodoo_codegen_t *codegen = voodoo->codegen_data;
+
+    codegen->blocks[voodoo->thread_stats[odd_even].codegen_block].users--;
+}
+
 void
 voodoo_codegen_init(voodoo_t *voodoo)
 {
-    voodoo->codegen_data = plat_mmap(sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4, 1);
+    voodoo_codegen_t *codegen = calloc(1, sizeof(voodoo_codegen_t));
+
+    codegen->blocks      = plat_mmap(sizeof(voodoo_x86_data_t) * BLOCK_NUM, 1);
+    codegen->mutex       = thread_create_mutex();
+    voodoo->codegen_data = codegen;
 
     for (uint16_t c = 0; c < 256; c++) {
         int d[4];
@@ -3204,7 +3320,15 @@ voodoo_codegen_init(voodoo_t *voodoo)
 void
 voodoo_codegen_close(voodoo_t *voodoo)
 {
-    plat_munmap(voodoo->codegen_data, sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4);
+    voodoo_codegen_t *codegen = voodoo->codegen_data;
+    voodoo_stats_t    stats;
+
+    voodoo_get_stats(voodoo, &stats);
+    voodoo_render_log("Pipeline cache: %" PRIu64 " hits, %" PRIu64 " compiles\n", stats.codegen_hits, stats.codegen_misses);
+
+    plat_munmap(codegen->blocks, sizeof(voodoo_x86_data_t) * BLOCK_NUM);
+    thread_close_mutex(codegen->mutex);
+    free(codegen);
 }
 
 #endif /*VIDEO_VOODOO_CODEGEN_X86_H*/
@@ -30,7 +30,10 @@
 
 #define TEX_DIRTY_SHIFT 10
 
-#define TEX_CACHE_MAX   64
+#define TEX_CACHE_MAX   128
+#define TEX_CACHE_WORDS (TEX_CACHE_MAX / 64)
+#define TEX_HASH_SIZE   256
+#define TEX_PAGES       16384
 
 #ifdef __cplusplus
 #    include <atomic>
@@ -100,9 +103,16 @@ enum {
 #define PARAM_MASK       (PARAM_SIZE - 1)
 #define PARAM_ENTRY_SIZE (1 << 31)
 
-#define PARAM_ENTRIES(x) (voodoo->params_write_idx - voodoo->params_read_idx[x])
-#define PARAM_FULL(x)    ((voodoo->params_write_idx - voodoo->params_read_idx[x]) >= PARAM_SIZE)
-#define PARAM_EMPTY(x)   (voodoo->params_read_idx[x] == voodoo->params_write_idx)
+/*Each render thread has its own queue of the params_buffer entries that
+  cover its band. A thread holds up the ring only while the oldest entry it
+  has yet to finish is still in it.*/
+#define PARAM_ENTRIES(x) (voodoo->render_queue_write[x] - voodoo->render_queue_read[x])
+#define PARAM_EMPTY(x)   (voodoo->render_queue_read[x] == voodoo->render_queue_write[x])
+#define PARAM_FULL(x)    (!PARAM_EMPTY(x) && ((voodoo->params_write_idx - voodoo->render_queue[x][voodoo->render_queue_read[x] & PARAM_MASK]) >= PARAM_SIZE))
+
+/*Upper bound on the render_threads option. Each render thread owns a band of
+  scanlines, so any count up to this works.*/
+#define VOODOO_MAX_RENDER_THREADS 16
 
 typedef struct
 {
@@ -110,6 +120,34 @@ typedef struct
     uint32_t val;
 } fifo_entry_t;
 
+/*Counters each render thread updates as it goes. Slots are two cache lines
+  apart, so that no two threads ever write to the same line.*/
+typedef union voodoo_thread_stats_t {
+    struct {
+        uint64_t busy_time;      /*plat_timer_read() ticks spent drawing*/
+        uint64_t triangles;      /*Triangles that covered the thread's band*/
+        uint64_t balance_time;   /*busy_time at the last rebalance*/
+        uint64_t codegen_hits;   /*Pipelines found in the codegen cache*/
+        uint64_t codegen_misses; /*Pipelines compiled*/
+        int      codegen_block;  /*Codegen block held until voodoo_put_block()*/
+    };
+    uint8_t pad[128];
+} voodoo_thread_stats_t;
+
+/*Snapshot of the counters, see voodoo_get_stats().*/
+typedef struct voodoo_stats_t {
+    int      render_threads;
+    uint64_t busy_us[VOODOO_MAX_RENDER_THREADS];
+    uint64_t triangles[VOODOO_MAX_RENDER_THREADS];
+    int      band_start[VOODOO_MAX_RENDER_THREADS]; /*First scanline of each thread's band*/
+
+    uint64_t texture_hits;
+    uint64_t texture_misses;
+    uint64_t texture_evictions;
+    uint64_t codegen_hits;
+    uint64_t codegen_misses;
+} voodoo_stats_t;
+
 typedef struct voodoo_params_t {
     int command;
 
@@ -234,11 +272,12 @@ typedef struct texture_t {
     uint32_t   base;
     uint32_t   tLOD;
     atomic_int refcount;
-    atomic_int refcount_r[4];
+    atomic_int refcount_r[VOODOO_MAX_RENDER_THREADS];
     int        is16;
     uint32_t   palette_checksum;
     uint32_t   addr_start[4];
     uint32_t   addr_end[4];
+    int        hash_next;
     uint32_t  *data;
 } texture_t;
 
@@ -362,25 +401,35 @@ typedef struct voodoo_t {
     int    ncc_dirty[2];
 
     thread_t *fifo_thread;
-    thread_t *render_thread[4];
+    thread_t *render_thread[VOODOO_MAX_RENDER_THREADS];
     event_t  *wake_fifo_thread;
     event_t  *wake_main_thread;
     event_t  *fifo_not_full_event;
-    event_t  *render_not_full_event[4];
-    event_t  *wake_render_thread[4];
+    event_t  *render_not_full_event[VOODOO_MAX_RENDER_THREADS];
+    event_t  *wake_render_thread[VOODOO_MAX_RENDER_THREADS];
 
     int voodoo_busy;
-    int render_voodoo_busy[4];
+    int render_voodoo_busy[VOODOO_MAX_RENDER_THREADS];
+
+    /*Set by a thread just before it blocks, so the other side of the ring
+      only pays for an event when somebody is actually waiting on it.*/
+    atomic_int render_thread_sleeping[VOODOO_MAX_RENDER_THREADS];
+    atomic_int params_producer_waiting;
+    atomic_int fifo_producer_waiting;
 
     int render_threads;
-    int odd_even_mask;
 
-    int pixel_count[4];
-    int texel_count[4];
+    struct voodoo_render_thread_t {
+        struct voodoo_t *voodoo;
+        int              idx;
+    } render_thread_param[VOODOO_MAX_RENDER_THREADS];
+
+    int pixel_count[VOODOO_MAX_RENDER_THREADS];
+    int texel_count[VOODOO_MAX_RENDER_THREADS];
     int tri_count;
     int frame_count;
-    int pixel_count_old[4];
-    int texel_count_old[4];
+    int pixel_count_old[VOODOO_MAX_RENDER_THREADS];
+    int texel_count_old[VOODOO_MAX_RENDER_THREADS];
     int wr_count;
     int rd_count;
     int tex_count;
@@ -411,9 +460,16 @@ typedef struct voodoo_t {
     atomic_int   cmd_written_fifo_2;
 
     voodoo_params_t params_buffer[PARAM_SIZE];
-    atomic_int      params_read_idx[4];
+    atomic_int      params_read_idx[VOODOO_MAX_RENDER_THREADS]; /*Entry each render thread is drawing*/
     atomic_int      params_write_idx;
 
+    int        render_queue[VOODOO_MAX_RENDER_THREADS][PARAM_SIZE];
+    atomic_int render_queue_read[VOODOO_MAX_RENDER_THREADS];
+    atomic_int render_queue_write[VOODOO_MAX_RENDER_THREADS];
+    /*Render thread c draws the scanlines from render_band[c] up to
+      render_band[c + 1]. Only changed while the threads are idle.*/
+    int render_band[VOODOO_MAX_RENDER_THREADS + 1];
+
     uint32_t   cmdfifo_base;
     uint32_t   cmdfifo_end;
     uint32_t   cmdfifo_size;
@@ -657,14 +713,20 @@ typedef struct voodoo_t {
     uint16_t purpleline[256][3];
 
     texture_t texture_cache[2][TEX_CACHE_MAX];
-    uint8_t   texture_present[2][16384];
+    int       texture_hash[2][TEX_HASH_SIZE];
+    uint64_t  texture_page_entries[2][TEX_PAGES][TEX_CACHE_WORDS]; /*Cache entries covering each TEX_DIRTY_SHIFT page*/
+    uint8_t   texture_present[2][TEX_PAGES];
     int       texture_last_removed;
+    uint64_t  texture_hits;
+    uint64_t  texture_misses;
+    uint64_t  texture_evictions;
 
     uint32_t palette_checksum[2];
     int      palette_dirty[2];
 
     uint64_t time;
-    int      render_time[4];
+
+    voodoo_thread_stats_t thread_stats[VOODOO_MAX_RENDER_THREADS];
 
     int      force_blit_count;
     int      can_blit;
@@ -676,7 +738,7 @@ typedef struct voodoo_t {
     struct voodoo_set_t *set;
 
     uint8_t fifo_thread_run;
-    uint8_t render_thread_run[4];
+    uint8_t render_thread_run[VOODOO_MAX_RENDER_THREADS];
 
     uint8_t *vram;
     uint8_t *changedvram;
@@ -79,11 +79,23 @@ typedef struct video_timings_t {
     int read_l;
 } video_timings_t;
 
+/* Target buffers start at VIDEO_BUFFER_X x VIDEO_BUFFER_Y, which the
+   renderers of the older cards rely on. Cards that size them to the mode
+   get anything from VIDEO_BUFFER_MIN_X x VIDEO_BUFFER_MIN_Y, enough for the
+   640-pixel fallback screen width with overscan, up to VIDEO_MAX_X x
+   VIDEO_MAX_Y. */
+#define VIDEO_BUFFER_X     2048
+#define VIDEO_BUFFER_Y     2048
+#define VIDEO_BUFFER_MIN_X 768
+#define VIDEO_BUFFER_MIN_Y 512
+#define VIDEO_MAX_X        4096
+#define VIDEO_MAX_Y        4096
+
 typedef struct bitmap_t {
-    int       w;
-    int       h;
-    uint32_t *dat;
-    uint32_t *line[2112];
+    int        w;
+    int        h;
+    uint32_t  *dat;
+    uint32_t **line;
 } bitmap_t;
 
 typedef struct rgb_t {
@@ -146,6 +158,7 @@ extern monitor_settings_t monitor_settings[MONITORS_NUM];
 extern atomic_bool        doresize_monitors[MONITORS_NUM];
 extern int                monitor_index_global;
 extern int                show_second_monitors;
+extern int                svga_render_threads;
 extern int                video_fullscreen_scale_maximized;
 
 typedef rgb_t PALETTE[256];
@@ -220,8 +233,17 @@ extern int    xga_active;
 /* Function handler pointers. */
 extern void (*video_recalctimings)(void);
 extern void video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index);
+extern void video_screenshot_monitor_ex(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index,
+                                        void (*done)(const char *path, int success, void *priv), void *priv);
 extern void video_screenshot(uint32_t *buf, int start_x, int start_y, int row_len);
 
+extern void video_capture_start(void);
+extern void video_capture_stop(void);
+extern void video_capture_close(void);
+extern int  video_capture_active(void);
+extern void video_capture_frame(int x, int y, int w, int h, int monitor_index);
+extern void video_capture_audio(const int32_t *buf, int samples);
+
 #ifdef _WIN32
 extern void * (__cdecl *video_copy)(void *_Dst, const void *_Src, size_t _Size);
 extern void *__cdecl video_transform_copy(void *_Dst, const void *_Src, size_t _Size);
@@ -253,9 +275,13 @@ extern void video_blit_memtoscreen_8(int x, int y, int w, int h);
 extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
+extern void video_blit_set_dirty_monitor(int x, int y, int w, int h, int monitor_index);
+extern int  video_blit_get_dirty_monitor(int monitor_index, int *x, int *y, int *w, int *h);
 extern void video_blit_complete_monitor(int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
+extern bitmap_t *video_frame_acquire_monitor(int monitor_index);
+extern void      video_frame_release_monitor(int monitor_index);
 
 extern bitmap_t *create_bitmap(int w, int h);
 extern void      destroy_bitmap(bitmap_t *b);
@@ -265,6 +291,7 @@ extern void      updatewindowsize(int x, int y);
 
 extern void    video_monitor_init(int);
 extern void    video_monitor_close(int);
+extern int     video_monitor_size_buffer(int w, int h, int monitor_index);
 extern void    video_init(void);
 extern void    video_close(void);
 extern void    video_reset_close(void);
@@ -288,6 +315,7 @@ extern uint32_t video_color_transform(uint32_t color);
 #define video_get_type()                      video_get_type_monitor(0)
 #define video_blend(x, y)                     video_blend_monitor(x, y, monitor_index_global)
 #define video_blit_memtoscreen(x, y, w, h)    video_blit_memtoscreen_monitor(x, y, w, h, monitor_index_global)
+#define video_blit_set_dirty(x, y, w, h)      video_blit_set_dirty_monitor(x, y, w, h, monitor_index_global)
 #define video_process_8(x, y)                 video_process_8_monitor(x, y, monitor_index_global)
 #define video_blit_complete()                 video_blit_complete_monitor(monitor_index_global)
 #define video_wait_for_blit()                 video_wait_for_blit_monitor(monitor_index_global)
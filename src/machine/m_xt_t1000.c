@@ -1005,7 +1005,7 @@ t1000_configsys_save(void)
     FILE *fp;
     int   size;
 
-    fp = plat_fopen(nvr_path("t1000_config.nvr"), "wb");
+    fp = nvr_fopen("t1000_config.nvr", "wb");
     if (fp != NULL) {
         size = sizeof(t1000.t1000_nvram);
         if (fwrite(t1000.t1000_nvram, 1, size, fp) != size)
@@ -1036,7 +1036,7 @@ t1200_state_save(void)
     FILE *fp;
     int   size;
 
-    fp = plat_fopen(nvr_path("t1200_state.nvr"), "wb");
+    fp = nvr_fopen("t1200_state.nvr", "wb");
     if (fp != NULL) {
         size = sizeof(t1000.t1200_nvram);
         if (fwrite(t1000.t1200_nvram, 1, size, fp) != size)
@@ -1066,7 +1066,7 @@ t1000_emsboard_save(void)
     FILE *fp;
 
     if (mem_size > 512) {
-        fp = plat_fopen(nvr_path("t1000_ems.nvr"), "wb");
+        fp = nvr_fopen("t1000_ems.nvr", "wb");
         if (fp != NULL) {
             fwrite(&ram[512 * 1024], 1024, (mem_size - 512), fp);
             fclose(fp);
@@ -38,6 +38,7 @@
 #include <86box/plat.h>
 #include <86box/rom.h>
 #include <86box/gdbstub.h>
+#include <86box/snapshot.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
 #else
@@ -83,13 +84,11 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
-int        readlnext;
-int        readlookup[256];
+int        readlookup[MMU_TLB_SIZE];
 uintptr_t *readlookup2;
 uintptr_t  old_rl2;
 uint8_t    uncached = 0;
-int        writelnext;
-int        writelookup[256];
+int        writelookup[MMU_TLB_SIZE];
 uintptr_t *writelookup2;
 
 uint32_t mem_logical_addr;
@@ -98,7 +97,6 @@ int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
 int writelnum = 0;
-int cachesize = 256;
 
 uint32_t get_phys_virt;
 uint32_t get_phys_phys;
@@ -107,8 +105,10 @@ int mem_a20_key   = 0;
 int mem_a20_alt   = 0;
 int mem_a20_state = 0;
 
-int mmuflush = 0;
-int mmu_perm = 4;
+int mmuflush             = 0;
+int mmuflush_nonglobal   = 0; /* CR3 loads that kept global entries */
+int mmuflush_global_kept = 0; /* global entries kept across those */
+int mmu_perm             = 4;
 
 #ifdef USE_NEW_DYNAREC
 uint64_t *byte_dirty_mask;
@@ -136,6 +136,11 @@ static mem_mapping_t *write_mapping_bus[MEM_MAPPINGS_NO];
 static uint8_t       _mem_wp[MEM_MAPPINGS_NO];
 static uint8_t       _mem_wp_bus[MEM_MAPPINGS_NO];
 static uint8_t        ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
+static uint8_t        readlookupg[MMU_TLB_SIZE];  /* entry maps a global page */
+static uint8_t        writelookupg[MMU_TLB_SIZE];
+static uint8_t        readlnext[MMU_TLB_SETS];    /* next way to replace, per set */
+static uint8_t        writelnext[MMU_TLB_SETS];
+static uint32_t       mmu_global_page = 0xffffffff; /* last walked page, if global */
 static mem_state_t    _mem_state[MEM_MAPPINGS_NO];
 static uint32_t       remap_start_addr;
 static uint32_t       remap_start_addr2;
@@ -173,48 +178,60 @@ mem_addr_is_ram(uint32_t addr)
            (mapping == &ram_mid_mapping2) || (mapping == &ram_remapped_mapping);
 }
 
-void
-resetreadlookup(void)
+/* Drop TLB entries; global ones are kept if keep_global is set. Returns
+   the number of entries kept. */
+static int
+mmu_tlb_flush(int keep_global)
 {
-    /* Initialize the page lookup table. */
-    memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
+    int kept = 0;
 
-    /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (uint16_t c = 0; c < 256; c++) {
-        readlookup[c]  = 0xffffffff;
-        writelookup[c] = 0xffffffff;
+    for (uint16_t c = 0; c < MMU_TLB_SIZE; c++) {
+        if (readlookup[c] != (int) 0xffffffff) {
+            if (keep_global && readlookupg[c])
+                kept++;
+            else {
+                readlookup2[readlookup[c]] = LOOKUP_INV;
+                readlookupp[readlookup[c]] = 4;
+                readlookup[c]              = 0xffffffff;
+                readlookupg[c]             = 0;
+            }
+        }
+        if (writelookup[c] != (int) 0xffffffff) {
+            if (keep_global && writelookupg[c])
+                kept++;
+            else {
+                page_lookup[writelookup[c]]  = NULL;
+                page_lookupp[writelookup[c]] = 4;
+                writelookup2[writelookup[c]] = LOOKUP_INV;
+                writelookupp[writelookup[c]] = 4;
+                writelookup[c]               = 0xffffffff;
+                writelookupg[c]              = 0;
+            }
+        }
     }
 
-    /* Initialize the tables for high (> 1024K) RAM. */
-    memset(readlookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
-    memset(readlookupp, 0x04, (1 << 20) * sizeof(uint8_t));
+    return kept;
+}
 
-    memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
-    memset(writelookupp, 0x04, (1 << 20) * sizeof(uint8_t));
+void
+resetreadlookup(void)
+{
+    /* Only the entries the TLB tracks can be valid in the 1M-entry
+       tables, so invalidating those is enough; the tables are filled
+       once in mem_init(). */
+    mmu_tlb_flush(0);
 
-    readlnext  = 0;
-    writelnext = 0;
-    pccache    = 0xffffffff;
-    high_page  = 0;
+    memset(readlnext, 0x00, sizeof(readlnext));
+    memset(writelnext, 0x00, sizeof(writelnext));
+    mmu_global_page = 0xffffffff;
+    pccache         = 0xffffffff;
+    high_page       = 0;
 }
 
 void
 flushmmucache(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookupp[readlookup[c]] = 4;
-            readlookup[c]              = 0xffffffff;
-        }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            page_lookupp[writelookup[c]] = 4;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookupp[writelookup[c]] = 4;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    mmu_tlb_flush(0);
     mmuflush++;
 
     pccache  = (uint32_t) 0xffffffff;
@@ -241,20 +258,28 @@ flushmmucache_pc(void)
 void
 flushmmucache_nopc(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookupp[readlookup[c]] = 4;
-            readlookup[c]              = 0xffffffff;
-        }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            page_lookupp[writelookup[c]] = 4;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookupp[writelookup[c]] = 4;
-            writelookup[c]               = 0xffffffff;
-        }
+    mmu_tlb_flush(0);
+}
+
+/* CR3 load: with CR4.PGE set, entries for global pages survive. */
+void
+flushmmucache_nonglobal(void)
+{
+    if (!(cr4 & CR4_PGE)) {
+        flushmmucache();
+        return;
     }
+
+    mmuflush_global_kept += mmu_tlb_flush(1);
+    mmuflush_nonglobal++;
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
 }
 
 void
@@ -265,7 +290,7 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
     uint32_t a;
 #endif
 
-    for (uint16_t c = 0; c < 256; c++) {
+    for (uint16_t c = 0; c < MMU_TLB_SIZE; c++) {
         if (writelookup[c] != (int) 0xffffffff) {
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
             uintptr_t target = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
@@ -283,6 +308,7 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
                 writelookup2[writelookup[c]] = LOOKUP_INV;
                 page_lookup[writelookup[c]]  = NULL;
                 writelookup[c]               = 0xffffffff;
+                writelookupg[c]              = 0;
             }
         }
     }
@@ -333,7 +359,8 @@ mmutranslatereal_normal(uint32_t addr, int rw)
             return 0xffffffffffffffffULL;
         }
 
-        mmu_perm = temp & 4;
+        mmu_perm        = temp & 4;
+        mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
         rammap(addr2) |= (rw ? 0x60 : 0x20);
 
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
@@ -353,7 +380,8 @@ mmutranslatereal_normal(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_perm        = temp & 4;
+    mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
     rammap(addr2) |= 0x20;
     rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw ? 0x60 : 0x20);
 
@@ -417,7 +445,8 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 
             return 0xffffffffffffffffULL;
         }
-        mmu_perm = temp & 4;
+        mmu_perm        = temp & 4;
+        mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
         rammap64(addr3) |= (rw ? 0x60 : 0x20);
 
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
@@ -438,7 +467,8 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_perm        = temp & 4;
+    mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
     rammap64(addr3) |= 0x20;
     rammap64(addr4) |= (rw ? 0x60 : 0x20);
 
@@ -581,9 +611,30 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
     return chunk_start + (addr & mask);
 }
 
+/* Pick the slot for a new entry in a set: a free way if there is one,
+   otherwise the set's round-robin victim. */
+static __inline int
+mmu_tlb_way(const int *lookup, uint8_t *next, uint32_t set)
+{
+    int base = set * MMU_TLB_WAYS;
+    int way;
+
+    for (way = 0; way < MMU_TLB_WAYS; way++) {
+        if (lookup[base + way] == (int) 0xffffffff)
+            return base + way;
+    }
+
+    way       = next[set];
+    next[set] = (way + 1) & (MMU_TLB_WAYS - 1);
+
+    return base + way;
+}
+
 void
 addreadlookup(uint32_t virt, uint32_t phys)
 {
+    uint32_t set;
+    int      c;
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
@@ -594,10 +645,13 @@ addreadlookup(uint32_t virt, uint32_t phys)
     if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
         return;
 
-    if (readlookup[readlnext] != (int) 0xffffffff) {
-        if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
+    set = (virt >> 12) & (MMU_TLB_SETS - 1);
+    c   = mmu_tlb_way(readlookup, readlnext, set);
+
+    if (readlookup[c] != (int) 0xffffffff) {
+        if ((readlookup[c] == ((es + DI) >> 12)) || (readlookup[c] == ((es + EDI) >> 12)))
             uncached = 1;
-        readlookup2[readlookup[readlnext]] = LOOKUP_INV;
+        readlookup2[readlookup[c]] = LOOKUP_INV;
     }
 
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
@@ -612,8 +666,8 @@ addreadlookup(uint32_t virt, uint32_t phys)
 #endif
     readlookupp[virt >> 12] = mmu_perm;
 
-    readlookup[readlnext++] = virt >> 12;
-    readlnext &= (cachesize - 1);
+    readlookup[c]  = virt >> 12;
+    readlookupg[c] = (mmu_global_page == (virt >> 12));
 
     cycles -= 9;
 }
@@ -621,6 +675,8 @@ addreadlookup(uint32_t virt, uint32_t phys)
 void
 addwritelookup(uint32_t virt, uint32_t phys)
 {
+    uint32_t set;
+    int      c;
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
@@ -631,9 +687,12 @@ addwritelookup(uint32_t virt, uint32_t phys)
     if (page_lookup[virt >> 12])
         return;
 
-    if (writelookup[writelnext] != -1) {
-        page_lookup[writelookup[writelnext]]  = NULL;
-        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    set = (virt >> 12) & (MMU_TLB_SETS - 1);
+    c   = mmu_tlb_way(writelookup, writelnext, set);
+
+    if (writelookup[c] != -1) {
+        page_lookup[writelookup[c]]  = NULL;
+        writelookup2[writelookup[c]] = LOOKUP_INV;
     }
 
 #ifdef USE_NEW_DYNAREC
@@ -665,8 +724,8 @@ addwritelookup(uint32_t virt, uint32_t phys)
     }
     writelookupp[virt >> 12] = mmu_perm;
 
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
+    writelookup[c]  = virt >> 12;
+    writelookupg[c] = (mmu_global_page == (virt >> 12));
 
     cycles -= 9;
 }
@@ -1823,6 +1882,117 @@ mem_write_phys(void *src, uint32_t addr, int transfer_size)
     }
 }
 
+/* Plain RAM or ROM that can be accessed through its exec pointer, with the
+   same result as going through the mapping handlers. */
+static __inline int
+mem_mapping_is_direct(const mem_mapping_t *map, int write)
+{
+    if ((map == NULL) || (map->exec == NULL))
+        return 0;
+
+    if (cpu_use_exec)
+        return 1;
+
+    if (write)
+        return (map->write_b == mem_write_ram);
+    else
+        return (map->read_b == mem_read_ram) || (map->read_b == mem_read_ram_2gb);
+}
+
+/* Returns a host pointer to the memory at physical address addr, and sets *span
+   to the number of bytes, up to len, that are contiguous in host memory from
+   there. Returns NULL if addr is not in directly accessible memory. */
+static uint8_t *
+mem_phys_span(mem_mapping_t **bus, uint32_t addr, uint32_t len, int write, uint32_t *span)
+{
+    const mem_mapping_t *map = bus[addr >> MEM_GRANULARITY_BITS];
+    const mem_mapping_t *next_map;
+    uint8_t             *host;
+    uint32_t             next_addr;
+    uint32_t             run;
+
+    if (!mem_mapping_is_direct(map, write))
+        return NULL;
+
+    host = &map->exec[(addr - map->base) & map->mask];
+    run  = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+
+    while (run < len) {
+        next_addr = addr + run;
+        if (next_addr < addr)
+            break;
+
+        next_map = bus[next_addr >> MEM_GRANULARITY_BITS];
+        if (!mem_mapping_is_direct(next_map, write) ||
+            (&next_map->exec[(next_addr - next_map->base) & next_map->mask] != (host + run)))
+            break;
+
+        run += MEM_GRANULARITY_SIZE;
+    }
+
+    *span = (run < len) ? run : len;
+
+    return host;
+}
+
+/* Bus master reads and writes of len bytes, which must be a multiple of
+   transfer_size. Ranges backed by RAM or ROM are copied in one go, anything
+   else goes through the mapping handlers one transfer at a time. */
+void
+mem_read_phys_span(void *dest, uint32_t addr, uint32_t len, int transfer_size)
+{
+    uint8_t       *p = (uint8_t *) dest;
+    const uint8_t *host;
+    uint32_t       run;
+
+    mem_logical_addr = 0xffffffff;
+
+    while (len) {
+        host = mem_phys_span(read_mapping_bus, addr, len, 0, &run);
+
+        if ((host != NULL) && (run >= (uint32_t) transfer_size)) {
+            run -= (run % transfer_size);
+            memcpy(p, host, run);
+        } else {
+            mem_read_phys(p, addr, transfer_size);
+            run = transfer_size;
+        }
+
+        p += run;
+        addr += run;
+        len -= run;
+    }
+}
+
+void
+mem_write_phys_span(const void *src, uint32_t addr, uint32_t len, int transfer_size)
+{
+    const uint8_t *p = (const uint8_t *) src;
+    uint8_t       *host;
+    uint32_t       run;
+
+    mem_logical_addr = 0xffffffff;
+
+    while (len) {
+        host = mem_phys_span(write_mapping_bus, addr, len, 1, &run);
+
+        if ((host != NULL) && (run >= (uint32_t) transfer_size)) {
+            run -= (run % transfer_size);
+            memcpy(host, p, run);
+            /* The copy bypassed the per-write dirty tracking, so make sure
+               any code compiled from this range gets flushed. */
+            mem_invalidate_range(addr, addr + run - 1);
+        } else {
+            mem_write_phys((void *) p, addr, transfer_size);
+            run = transfer_size;
+        }
+
+        p += run;
+        addr += run;
+        len -= run;
+    }
+}
+
 uint8_t
 mem_read_ram(uint32_t addr, UNUSED(void *priv))
 {
@@ -2955,13 +3125,25 @@ mem_init(void)
     ram2      = NULL;
     pages     = NULL;
 
-    /* Allocate the lookup tables. */
-    page_lookup  = (page_t **) malloc((1 << 20) * sizeof(page_t *));
-    page_lookupp = (uint8_t *) malloc((1 << 20) * sizeof(uint8_t));
+    /* Allocate the lookup tables. The page table and permission tables
+       are only read for pages with a valid entry, so they are left zeroed
+       and the host only commits the parts the guest touches. */
+    page_lookup  = (page_t **) calloc(1 << 20, sizeof(page_t *));
+    page_lookupp = (uint8_t *) calloc(1 << 20, sizeof(uint8_t));
     readlookup2  = malloc((1 << 20) * sizeof(uintptr_t));
-    readlookupp  = malloc((1 << 20) * sizeof(uint8_t));
+    readlookupp  = (uint8_t *) calloc(1 << 20, sizeof(uint8_t));
     writelookup2 = malloc((1 << 20) * sizeof(uintptr_t));
-    writelookupp = malloc((1 << 20) * sizeof(uint8_t));
+    writelookupp = (uint8_t *) calloc(1 << 20, sizeof(uint8_t));
+
+    /* The recompilers compare against LOOKUP_INV directly, so these two
+       have to be filled, but only once rather than on every reset. */
+    memset(readlookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
+    memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
+
+    for (uint16_t c = 0; c < MMU_TLB_SIZE; c++) {
+        readlookup[c]  = 0xffffffff;
+        writelookup[c] = 0xffffffff;
+    }
 }
 
 static void
@@ -3178,3 +3360,110 @@ mem_a20_recalc(void)
 
     mem_a20_state = state;
 }
+
+void
+mem_save_state(snapshot_t *snap)
+{
+    mem_mapping_t *map   = base_mapping;
+    uint32_t       count = 0;
+    uint64_t       exec;
+
+    snapshot_write_u64(snap, ram_size);
+    snapshot_write(snap, ram, ram_size);
+#if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
+    snapshot_write_u64(snap, ram2_size);
+    if (ram2_size)
+        snapshot_write(snap, ram2, ram2_size);
+#else
+    snapshot_write_u64(snap, 0);
+#endif
+
+    snapshot_write(snap, _mem_state, sizeof(_mem_state));
+    snapshot_write(snap, _mem_wp, sizeof(_mem_wp));
+    snapshot_write(snap, _mem_wp_bus, sizeof(_mem_wp_bus));
+
+    snapshot_write_u32(snap, rammask);
+    snapshot_write_u32(snap, mem_a20_key);
+    snapshot_write_u32(snap, mem_a20_alt);
+    snapshot_write_u32(snap, mem_a20_state);
+    snapshot_write_u32(snap, shadowbios);
+    snapshot_write_u32(snap, shadowbios_write);
+    snapshot_write_u32(snap, mmu_perm);
+    snapshot_write_u8(snap, high_page);
+
+    /* The mapping list is rebuilt in the same order by the hard reset
+       that precedes a restore, so only the mutable fields are stored. */
+    while (map != NULL) {
+        count++;
+        map = map->next;
+    }
+    snapshot_write_u32(snap, count);
+
+    for (map = base_mapping; map != NULL; map = map->next) {
+        exec = (uint64_t) -1;
+        if ((map->exec != NULL) && (map->exec >= ram) && (map->exec < (ram + ram_size)))
+            exec = (uint64_t) (map->exec - ram);
+
+        snapshot_write_u32(snap, map->enable);
+        snapshot_write_u32(snap, map->base);
+        snapshot_write_u32(snap, map->size);
+        snapshot_write_u32(snap, map->mask);
+        snapshot_write_u64(snap, exec);
+    }
+}
+
+int
+mem_load_state(snapshot_t *snap)
+{
+    mem_mapping_t *map   = base_mapping;
+    uint32_t       count = 0;
+    uint64_t       exec;
+
+    if (snapshot_read_u64(snap) != ram_size)
+        return 0;
+    snapshot_read(snap, ram, ram_size);
+#if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
+    if (snapshot_read_u64(snap) != ram2_size)
+        return 0;
+    if (ram2_size)
+        snapshot_read(snap, ram2, ram2_size);
+#else
+    if (snapshot_read_u64(snap) != 0)
+        return 0;
+#endif
+
+    snapshot_read(snap, _mem_state, sizeof(_mem_state));
+    snapshot_read(snap, _mem_wp, sizeof(_mem_wp));
+    snapshot_read(snap, _mem_wp_bus, sizeof(_mem_wp_bus));
+
+    rammask          = snapshot_read_u32(snap);
+    mem_a20_key      = (int) snapshot_read_u32(snap);
+    mem_a20_alt      = (int) snapshot_read_u32(snap);
+    mem_a20_state    = (int) snapshot_read_u32(snap);
+    shadowbios       = (int) snapshot_read_u32(snap);
+    shadowbios_write = (int) snapshot_read_u32(snap);
+    mmu_perm         = (int) snapshot_read_u32(snap);
+    high_page        = snapshot_read_u8(snap);
+
+    while (map != NULL) {
+        count++;
+        map = map->next;
+    }
+    if (snapshot_read_u32(snap) != count)
+        return 0;
+
+    for (map = base_mapping; map != NULL; map = map->next) {
+        map->enable = (int) snapshot_read_u32(snap);
+        map->base   = snapshot_read_u32(snap);
+        map->size   = snapshot_read_u32(snap);
+        map->mask   = snapshot_read_u32(snap);
+        exec        = snapshot_read_u64(snap);
+        if (exec < ram_size)
+            map->exec = ram + exec;
+    }
+
+    mem_mapping_recalc(0ULL, 1ULL << 32);
+    flushmmucache();
+
+    return !snapshot_error(snap);
+}
@@ -281,6 +281,12 @@ nvr_save(void)
     if (saved_nvr == NULL)
         return 0;
 
+    /* Batch runs must leave the NVR file as they found it. */
+    if (batch_mode) {
+        nvr_dosave = 0;
+        return 0;
+    }
+
     if (saved_nvr->size != 0) {
         path = nvr_path(saved_nvr->fn);
         nvr_log("NVR: saving to '%s'\n", path);
@@ -367,5 +373,9 @@ nvr_time_set(struct tm *tm)
 FILE *
 nvr_fopen(char *str, char *mode)
 {
+    /* Batch runs must leave the NVR files as they found them. */
+    if (batch_mode && (strpbrk(mode, "wa+") != NULL))
+        return NULL;
+
     return (plat_fopen(nvr_path(str), mode));
 }
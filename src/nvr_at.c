@@ -236,6 +236,7 @@
 #include <86box/rom.h>
 #include <86box/device.h>
 #include <86box/nvr.h>
+#include <86box/snapshot.h>
 
 /* RTC registers and bit definitions. */
 #define RTC_SECONDS        0
@@ -1051,6 +1052,71 @@ nvr_at_reset(void *priv)
     nvr->regs[RTC_REGC] &= ~(REGC_PF | REGC_AF | REGC_UF | REGC_IRQF);
 }
 
+static void
+nvr_at_save_state(void *priv, snapshot_t *snap)
+{
+    const nvr_t   *nvr   = (nvr_t *) priv;
+    const local_t *local = (local_t *) nvr->data;
+
+    snapshot_write(snap, nvr->regs, sizeof(nvr->regs));
+    snapshot_write_u8(snap, nvr->irq);
+    snapshot_write_u8(snap, nvr->onesec_cnt);
+    snapshot_write_timer(snap, &nvr->onesec_time);
+
+    snapshot_write_u8(snap, local->stat);
+    snapshot_write_u8(snap, local->read_addr);
+    snapshot_write_u8(snap, local->wp_0d);
+    snapshot_write_u8(snap, local->wp_32);
+    snapshot_write_u8(snap, local->irq_state);
+    snapshot_write_u8(snap, local->smi_status);
+    snapshot_write(snap, local->wp, sizeof(local->wp));
+    snapshot_write(snap, local->bank, sizeof(local->bank));
+    snapshot_write(snap, local->lock, nvr->size);
+    snapshot_write_u16(snap, local->count);
+    snapshot_write_u16(snap, local->state);
+    snapshot_write(snap, local->addr, sizeof(local->addr));
+    snapshot_write_u32(snap, local->smi_enable);
+    snapshot_write_u64(snap, local->ecount);
+    snapshot_write_u64(snap, local->rtc_time);
+    snapshot_write_timer(snap, &local->update_timer);
+    snapshot_write_timer(snap, &local->rtc_timer);
+}
+
+static int
+nvr_at_load_state(void *priv, snapshot_t *snap, uint32_t version)
+{
+    nvr_t   *nvr   = (nvr_t *) priv;
+    local_t *local = (local_t *) nvr->data;
+
+    if (version != 1)
+        return 0;
+
+    snapshot_read(snap, nvr->regs, sizeof(nvr->regs));
+    nvr->irq        = (int8_t) snapshot_read_u8(snap);
+    nvr->onesec_cnt = snapshot_read_u8(snap);
+    snapshot_read_timer(snap, &nvr->onesec_time);
+
+    local->stat       = (int8_t) snapshot_read_u8(snap);
+    local->read_addr  = snapshot_read_u8(snap);
+    local->wp_0d      = snapshot_read_u8(snap);
+    local->wp_32      = snapshot_read_u8(snap);
+    local->irq_state  = snapshot_read_u8(snap);
+    local->smi_status = snapshot_read_u8(snap);
+    snapshot_read(snap, local->wp, sizeof(local->wp));
+    snapshot_read(snap, local->bank, sizeof(local->bank));
+    snapshot_read(snap, local->lock, nvr->size);
+    local->count      = (int16_t) snapshot_read_u16(snap);
+    local->state      = (int16_t) snapshot_read_u16(snap);
+    snapshot_read(snap, local->addr, sizeof(local->addr));
+    local->smi_enable = (int32_t) snapshot_read_u32(snap);
+    local->ecount     = snapshot_read_u64(snap);
+    local->rtc_time   = snapshot_read_u64(snap);
+    snapshot_read_timer(snap, &local->update_timer);
+    snapshot_read_timer(snap, &local->rtc_timer);
+
+    return !snapshot_error(snap);
+}
+
 static void *
 nvr_at_init(const device_t *info)
 {
@@ -1227,7 +1293,9 @@ const device_t at_nvr_old_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t at_nvr_device = {
@@ -1241,7 +1309,9 @@ const device_t at_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t at_mb_nvr_device = {
@@ -1255,7 +1325,9 @@ const device_t at_mb_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ps_nvr_device = {
@@ -1269,7 +1341,9 @@ const device_t ps_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t amstrad_nvr_device = {
@@ -1283,7 +1357,9 @@ const device_t amstrad_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ibmat_nvr_device = {
@@ -1297,7 +1373,9 @@ const device_t ibmat_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t piix4_nvr_device = {
@@ -1311,7 +1389,9 @@ const device_t piix4_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ps_no_nmi_nvr_device = {
@@ -1325,7 +1405,9 @@ const device_t ps_no_nmi_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t amstrad_no_nmi_nvr_device = {
@@ -1339,7 +1421,9 @@ const device_t amstrad_no_nmi_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ami_1992_nvr_device = {
@@ -1353,7 +1437,9 @@ const device_t ami_1992_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ami_1994_nvr_device = {
@@ -1367,7 +1453,9 @@ const device_t ami_1994_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t ami_1995_nvr_device = {
@@ -1381,7 +1469,9 @@ const device_t ami_1995_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t via_nvr_device = {
@@ -1395,7 +1485,9 @@ const device_t via_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t p6rp4_nvr_device = {
@@ -1409,7 +1501,9 @@ const device_t p6rp4_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t amstrad_megapc_nvr_device = {
@@ -1423,7 +1517,9 @@ const device_t amstrad_megapc_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
 
 const device_t elt_nvr_device = {
@@ -1437,5 +1533,7 @@ const device_t elt_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = nvr_at_save_state,
+    .load_state    = nvr_at_load_state
 };
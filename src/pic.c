@@ -18,6 +18,7 @@
  *          Copyright 2016-2020 Miran Grca.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +38,7 @@
 #include <86box/apm.h>
 #include <86box/nvr.h>
 #include <86box/acpi.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 enum {
@@ -898,3 +900,40 @@ picinterrupt(void)
 
     return ret;
 }
+
+void
+pic_save_state(snapshot_t *snap)
+{
+    /* Everything up to the slave pointers, those are set up by the reset. */
+    snapshot_write(snap, &pic, offsetof(pic_t, slaves));
+    snapshot_write(snap, &pic2, offsetof(pic_t, slaves));
+    snapshot_write_timer(snap, &pic_timer);
+
+    snapshot_write_u32(snap, shadow);
+    snapshot_write_u32(snap, elcr_enabled);
+    snapshot_write_u32(snap, pic_pci);
+    snapshot_write_u32(snap, kbd_latch);
+    snapshot_write_u32(snap, mouse_latch);
+    snapshot_write_u16(snap, smi_irq_mask);
+    snapshot_write_u16(snap, smi_irq_status);
+    snapshot_write_u16(snap, latched_irqs);
+}
+
+int
+pic_load_state(snapshot_t *snap)
+{
+    snapshot_read(snap, &pic, offsetof(pic_t, slaves));
+    snapshot_read(snap, &pic2, offsetof(pic_t, slaves));
+    snapshot_read_timer(snap, &pic_timer);
+
+    shadow         = (int) snapshot_read_u32(snap);
+    elcr_enabled   = (int) snapshot_read_u32(snap);
+    pic_pci        = (int) snapshot_read_u32(snap);
+    kbd_latch      = (int) snapshot_read_u32(snap);
+    mouse_latch    = (int) snapshot_read_u32(snap);
+    smi_irq_mask   = snapshot_read_u16(snap);
+    smi_irq_status = snapshot_read_u16(snap);
+    latched_irqs   = snapshot_read_u16(snap);
+
+    return !snapshot_error(snap);
+}
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,6 +42,7 @@
 #include <86box/sound.h>
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 pit_intf_t pit_devs[2];
@@ -927,6 +929,40 @@ pit_close(void *priv)
         free(dev);
 }
 
+static void
+pit_save_state(void *priv, snapshot_t *snap)
+{
+    const pit_t *dev = (pit_t *) priv;
+
+    snapshot_write_u32(snap, dev->clock);
+    snapshot_write_u8(snap, dev->ctrl);
+    snapshot_write_u64(snap, dev->pit_const);
+    snapshot_write_timer(snap, &dev->callback_timer);
+
+    /* The counter state, without the handlers. */
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++)
+        snapshot_write(snap, &dev->counters[i], offsetof(ctr_t, load_func));
+}
+
+static int
+pit_load_state(void *priv, snapshot_t *snap, uint32_t version)
+{
+    pit_t *dev = (pit_t *) priv;
+
+    if (version != 1)
+        return 0;
+
+    dev->clock     = (int) snapshot_read_u32(snap);
+    dev->ctrl      = snapshot_read_u8(snap);
+    dev->pit_const = snapshot_read_u64(snap);
+    snapshot_read_timer(snap, &dev->callback_timer);
+
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++)
+        snapshot_read(snap, &dev->counters[i], offsetof(ctr_t, load_func));
+
+    return !snapshot_error(snap);
+}
+
 static void *
 pit_init(const device_t *info)
 {
@@ -963,7 +999,9 @@ const device_t i8253_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 const device_t i8253_ext_io_device = {
@@ -977,7 +1015,9 @@ const device_t i8253_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 const device_t i8254_device = {
@@ -991,7 +1031,9 @@ const device_t i8254_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 const device_t i8254_sec_device = {
@@ -1005,7 +1047,9 @@ const device_t i8254_sec_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 const device_t i8254_ext_io_device = {
@@ -1019,7 +1063,9 @@ const device_t i8254_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 const device_t i8254_ps2_device = {
@@ -1033,7 +1079,9 @@ const device_t i8254_ps2_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pit_save_state,
+    .load_state    = pit_load_state
 };
 
 pit_t *
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,6 +42,7 @@
 #include <86box/sound.h>
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
+#include <86box/snapshot.h>
 
 #define PIT_PS2          16  /* The PIT is the PS/2's second PIT. */
 #define PIT_EXT_IO       32  /* The PIT has externally specified port I/O. */
@@ -716,6 +718,37 @@ pitf_handler(int set, uint16_t base, int size, void *priv)
     io_handler(set, base, size, pitf_read, NULL, NULL, pitf_write, NULL, NULL, priv);
 }
 
+static void
+pitf_save_state(void *priv, snapshot_t *snap)
+{
+    const pitf_t *dev = (pitf_t *) priv;
+
+    snapshot_write_u8(snap, dev->ctrl);
+
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++) {
+        snapshot_write(snap, &dev->counters[i], offsetof(ctrf_t, timer));
+        snapshot_write_timer(snap, &dev->counters[i].timer);
+    }
+}
+
+static int
+pitf_load_state(void *priv, snapshot_t *snap, uint32_t version)
+{
+    pitf_t *dev = (pitf_t *) priv;
+
+    if (version != 1)
+        return 0;
+
+    dev->ctrl = snapshot_read_u8(snap);
+
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++) {
+        snapshot_read(snap, &dev->counters[i], offsetof(ctrf_t, timer));
+        snapshot_read_timer(snap, &dev->counters[i].timer);
+    }
+
+    return !snapshot_error(snap);
+}
+
 static void *
 pitf_init(const device_t *info)
 {
@@ -754,7 +787,9 @@ const device_t i8253_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state
 };
 
 const device_t i8254_fast_device = {
@@ -768,7 +803,9 @@ const device_t i8254_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state
 };
 
 const device_t i8254_sec_fast_device = {
@@ -782,7 +819,9 @@ const device_t i8254_sec_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state
 };
 
 const device_t i8254_ext_io_fast_device = {
@@ -796,7 +835,9 @@ const device_t i8254_ext_io_fast_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state
 };
 
 const device_t i8254_ps2_fast_device = {
@@ -810,7 +851,9 @@ const device_t i8254_ps2_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state
 };
 
 const pit_intf_t pit_fast_intf = {
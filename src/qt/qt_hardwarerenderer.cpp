@@ -33,6 +33,21 @@ extern "C" {
 #include <86box/video.h>
 }
 
+HardwareRenderer::~HardwareRenderer()
+{
+    /* A frame queued to us is dropped along with the renderer. */
+    if (frame_held)
+        video_frame_release_monitor(r_monitor_index);
+    m_context->makeCurrent(this);
+    if (m_blt)
+        m_blt->destroy();
+    m_prog->release();
+    delete m_prog;
+    m_prog = nullptr;
+    m_context->doneCurrent();
+    delete m_context;
+}
+
 void
 HardwareRenderer::resizeGL(int w, int h)
 {
@@ -48,9 +63,7 @@ HardwareRenderer::initializeGL()
 {
     m_context->makeCurrent(this);
     initializeOpenGLFunctions();
-    auto image = QImage(2048, 2048, QImage::Format_RGB32);
-    image.fill(0xff000000);
-    m_texture = new QOpenGLTexture(image);
+    createTexture(m_textureSize);
     m_blt     = new QOpenGLTextureBlitter;
     m_blt->setRedBlueSwizzle(true);
     m_blt->create();
@@ -131,11 +144,24 @@ HardwareRenderer::initializeGL()
     pclog("OpenGL version: %s\n", glGetString(GL_VERSION));
     pclog("OpenGL shader language version: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
     glClearColor(0, 0, 0, 1);
-    m_texture->setWrapMode(QOpenGLTexture::ClampToEdge);
     glClear(GL_COLOR_BUFFER_BIT);
     m_context->swapBuffers(this);
 }
 
+/* The texture only grows, as it is cheap to keep compared to recreating it
+   on every mode switch. */
+void
+HardwareRenderer::createTexture(QSize size)
+{
+    auto image = QImage(size, QImage::Format_RGB32);
+    image.fill(0xff000000);
+    delete m_texture;
+    m_texture     = new QOpenGLTexture(image);
+    m_textureSize  = size;
+    m_textureStale = true;
+    m_texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+}
+
 void
 HardwareRenderer::paintGL()
 {
@@ -150,10 +176,12 @@ HardwareRenderer::paintGL()
     verts.push_back(QVector2D((float) destination.x(), (float) destination.y() + (float) destination.height()));
     verts.push_back(QVector2D((float) destination.x() + (float) destination.width(), (float) destination.y() + (float) destination.height()));
     verts.push_back(QVector2D((float) destination.x() + (float) destination.width(), (float) destination.y()));
-    texcoords.push_back(QVector2D((float) source.x() / 2048.f, (float) (source.y()) / 2048.f));
-    texcoords.push_back(QVector2D((float) source.x() / 2048.f, (float) (source.y() + source.height()) / 2048.f));
-    texcoords.push_back(QVector2D((float) (source.x() + source.width()) / 2048.f, (float) (source.y() + source.height()) / 2048.f));
-    texcoords.push_back(QVector2D((float) (source.x() + source.width()) / 2048.f, (float) (source.y()) / 2048.f));
+    float              tex_w = (float) m_textureSize.width();
+    float              tex_h = (float) m_textureSize.height();
+    texcoords.push_back(QVector2D((float) source.x() / tex_w, (float) (source.y()) / tex_h));
+    texcoords.push_back(QVector2D((float) source.x() / tex_w, (float) (source.y() + source.height()) / tex_h));
+    texcoords.push_back(QVector2D((float) (source.x() + source.width()) / tex_w, (float) (source.y() + source.height()) / tex_h));
+    texcoords.push_back(QVector2D((float) (source.x() + source.width()) / tex_w, (float) (source.y()) / tex_h));
 
     m_vbo[PROGRAM_VERTEX_ATTRIBUTE].bind();
     m_vbo[PROGRAM_VERTEX_ATTRIBUTE].write(0, verts.data(), sizeof(QVector2D) * 4);
@@ -197,28 +225,44 @@ HardwareRenderer::setRenderType(RenderType type)
 }
 
 void
-HardwareRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
+HardwareRenderer::onBlitFrame(void *frame, QRect dirty, int x, int y, int w, int h)
 {
     auto  tval    = this;
     void *nuldata = 0;
     if (memcmp(&tval, &nuldata, sizeof(void *)) == 0)
         return;
-    auto origSource = source;
+    auto            origSource = source;
+    const bitmap_t *bm         = (const bitmap_t *) frame;
     if (!m_texture || !m_texture->isCreated()) {
-        buf_usage[buf_idx].clear();
+        /* Nothing was uploaded, so the next frame has to go out in full. */
+        m_textureStale = true;
+        frame_held     = false;
+        video_frame_release_monitor(r_monitor_index);
         source.setRect(x, y, w, h);
         return;
     }
     m_context->makeCurrent(this);
+    if (((x + w) > m_textureSize.width()) || ((y + h) > m_textureSize.height()))
+        createTexture(bufferSize(qMax(x + w, m_textureSize.width()), qMax(y + h, m_textureSize.height())));
+    if (m_textureStale) {
+        dirty          = QRect(x, y, w, h);
+        m_textureStale = false;
+    }
+
+    /* Only what changed since the last frame is uploaded, straight from the
+       emulated target buffer. */
+    const void *pixels = &bm->line[dirty.y()][dirty.x()];
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    m_texture->setData(x, y, 0, w, h, 0, QOpenGLTexture::PixelFormat::RGBA, QOpenGLTexture::PixelType::UInt8, (const void *) ((uintptr_t) imagebufs[buf_idx].get() + (uintptr_t) (2048 * 4 * y + x * 4)), &m_transferOptions);
+    m_transferOptions.setRowLength(bm->w);
+    m_texture->setData(dirty.x(), dirty.y(), 0, dirty.width(), dirty.height(), 0, QOpenGLTexture::PixelFormat::RGBA, QOpenGLTexture::PixelType::UInt8, pixels, &m_transferOptions);
 #else
     m_texture->bind();
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 2048);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, QOpenGLTexture::PixelFormat::RGBA, QOpenGLTexture::PixelType::UInt8, (const void *) ((uintptr_t) imagebufs[buf_idx].get() + (uintptr_t) (2048 * 4 * y + x * 4)));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, bm->w);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, dirty.x(), dirty.y(), dirty.width(), dirty.height(), QOpenGLTexture::PixelFormat::RGBA, QOpenGLTexture::PixelType::UInt8, pixels);
     m_texture->release();
 #endif
-    buf_usage[buf_idx].clear();
+    frame_held = false;
+    video_frame_release_monitor(r_monitor_index);
     source.setRect(x, y, w, h);
     if (origSource != source)
         onResize(this->width(), this->height());
@@ -241,14 +285,3 @@ HardwareRenderer::event(QEvent *event)
         return QOpenGLWindow::event(event);
     return res;
 }
-
-std::vector<std::tuple<uint8_t *, std::atomic_flag *>>
-HardwareRenderer::getBuffers()
-{
-    std::vector<std::tuple<uint8_t *, std::atomic_flag *>> buffers;
-
-    buffers.push_back(std::make_tuple(imagebufs[0].get(), &buf_usage[0]));
-    buffers.push_back(std::make_tuple(imagebufs[1].get(), &buf_usage[1]));
-
-    return buffers;
-}
@@ -39,6 +39,8 @@ private:
     QOpenGLBuffer               m_vbo[2];
     QOpenGLVertexArrayObject    m_vao;
     QOpenGLPixelTransferOptions m_transferOptions;
+    QSize                       m_textureSize { 640, 480 };
+    bool                        m_textureStale { true }; /* holds none of the frame yet */
 
 public:
     enum class RenderType {
@@ -54,49 +56,30 @@ public:
         onResize(size().width(), size().height());
     }
 
-    std::vector<std::tuple<uint8_t *, std::atomic_flag *>> getBuffers() override;
+    bool uploadsFrames() const override { return true; }
     HardwareRenderer(QWidget *parent = nullptr, RenderType rtype = RenderType::OpenGL)
         : QOpenGLWindow(QOpenGLWindow::NoPartialUpdate, parent->windowHandle())
         , QOpenGLFunctions()
     {
-        imagebufs[0] = std::unique_ptr<uint8_t>(new uint8_t[2048 * 2048 * 4]);
-        imagebufs[1] = std::unique_ptr<uint8_t>(new uint8_t[2048 * 2048 * 4]);
-
-        buf_usage = std::vector<std::atomic_flag>(2);
-        buf_usage[0].clear();
-        buf_usage[1].clear();
-
         setMinimumSize(QSize(16, 16));
         setFlags(Qt::FramelessWindowHint);
         parentWidget = parent;
         setRenderType(rtype);
 
-        m_transferOptions.setRowLength(2048);
-
         m_context = new QOpenGLContext();
         m_context->setFormat(format());
         m_context->create();
         update();
     }
-    ~HardwareRenderer()
-    {
-        m_context->makeCurrent(this);
-        if (m_blt)
-            m_blt->destroy();
-        m_prog->release();
-        delete m_prog;
-        m_prog = nullptr;
-        m_context->doneCurrent();
-        delete m_context;
-    }
+    ~HardwareRenderer();
 
     void setRenderType(RenderType type);
 
 public slots:
-    void onBlit(int buf_idx, int x, int y, int w, int h);
+    void onBlitFrame(void *frame, QRect dirty, int x, int y, int w, int h);
 
 protected:
-    std::array<std::unique_ptr<uint8_t>, 2> imagebufs;
+    void createTexture(QSize size);
 
     void resizeEvent(QResizeEvent *event) override;
     bool event(QEvent *event) override;
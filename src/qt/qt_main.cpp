@@ -107,6 +107,10 @@ main_thread_fn()
             drawits = 10;
         else
 #endif
+        /* Batch mode runs unthrottled, emulated time is not tied to the host clock. */
+        if (batch_mode)
+            drawits = 10;
+        else
             drawits += static_cast<int>(new_time - old_time);
         old_time = new_time;
         if (drawits > 0 && !dopause) {
@@ -146,6 +150,9 @@ main_thread_fn()
                 pc_reset_hard_init();
             }
 
+            /* Take or restore a snapshot requested while paused. */
+            pc_snapshot_poll();
+
             if (dopause)
                 ack_pause();
 
@@ -410,5 +417,5 @@ main(int argc, char *argv[])
     endblit();
 
     socket.close();
-    return ret;
+    return batch_mode ? batch_exit_code : ret;
 }
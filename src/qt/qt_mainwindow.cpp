@@ -613,12 +613,14 @@ MainWindow::MainWindow(QWidget *parent)
         video_setblit(qt_blit);
 
     if (start_in_fullscreen) {
-        connect(ui->stackedWidget, &RendererStack::blitToRenderer, this, [this] () {
+        auto enterFullscreen = [this] () {
             if (start_in_fullscreen) {
                 QTimer::singleShot(100, ui->actionFullscreen, &QAction::trigger);
                 start_in_fullscreen = 0;
             }
-        });
+        };
+        connect(ui->stackedWidget, &RendererStack::blitToRenderer, this, enterFullscreen);
+        connect(ui->stackedWidget, &RendererStack::blitFrameToRenderer, this, enterFullscreen);
     }
 
 #ifdef MTR_ENABLED
@@ -800,8 +802,8 @@ MainWindow::initRendererMonitorSlot(int monitor_index)
             if (window_remember) {
                 secondaryRenderer->setGeometry(monitor_settings[monitor_index].mon_window_x < 120 ? 120 : monitor_settings[monitor_index].mon_window_x,
                                                monitor_settings[monitor_index].mon_window_y < 120 ? 120 : monitor_settings[monitor_index].mon_window_y,
-                                               monitor_settings[monitor_index].mon_window_w > 2048 ? 2048 : monitor_settings[monitor_index].mon_window_w,
-                                               monitor_settings[monitor_index].mon_window_h > 2048 ? 2048 : monitor_settings[monitor_index].mon_window_h);
+                                               monitor_settings[monitor_index].mon_window_w > VIDEO_MAX_X ? VIDEO_MAX_X : monitor_settings[monitor_index].mon_window_w,
+                                               monitor_settings[monitor_index].mon_window_h > VIDEO_MAX_Y ? VIDEO_MAX_Y : monitor_settings[monitor_index].mon_window_h);
             }
             if (monitor_settings[monitor_index].mon_window_maximized)
                 secondaryRenderer->showMaximized();
@@ -1329,6 +1331,8 @@ MainWindow::blitToWidget(int x, int y, int w, int h, int monitor_index)
     if (monitor_index >= 1) {
         if (renderers[monitor_index] && renderers[monitor_index]->isVisible())
             renderers[monitor_index]->blit(x, y, w, h);
+        else if (renderers[monitor_index])
+            renderers[monitor_index]->skipBlit();
         else
             video_blit_complete_monitor(monitor_index);
     } else
@@ -1880,6 +1884,19 @@ MainWindow::on_actionTake_screenshot_triggered()
     device_force_redraw();
 }
 
+void
+MainWindow::on_actionRecord_video_triggered(bool checked)
+{
+    startblit();
+    if (checked)
+        video_capture_start();
+    else
+        video_capture_stop();
+    endblit();
+    if (checked)
+        device_force_redraw();
+}
+
 void
 MainWindow::on_actionSound_gain_triggered()
 {
@@ -1992,8 +2009,8 @@ MainWindow::on_actionShow_non_primary_monitors_triggered()
             if (window_remember) {
                 secondaryRenderer->setGeometry(monitor_settings[monitor_index].mon_window_x < 120 ? 120 : monitor_settings[monitor_index].mon_window_x,
                                                monitor_settings[monitor_index].mon_window_y < 120 ? 120 : monitor_settings[monitor_index].mon_window_y,
-                                               monitor_settings[monitor_index].mon_window_w > 2048 ? 2048 : monitor_settings[monitor_index].mon_window_w,
-                                               monitor_settings[monitor_index].mon_window_h > 2048 ? 2048 : monitor_settings[monitor_index].mon_window_h);
+                                               monitor_settings[monitor_index].mon_window_w > VIDEO_MAX_X ? VIDEO_MAX_X : monitor_settings[monitor_index].mon_window_w,
+                                               monitor_settings[monitor_index].mon_window_h > VIDEO_MAX_Y ? VIDEO_MAX_Y : monitor_settings[monitor_index].mon_window_h);
             }
             secondaryRenderer->switchRenderer(static_cast<RendererStack::Renderer>(vid_api));
             ui->stackedWidget->switchRenderer(static_cast<RendererStack::Renderer>(vid_api));
@@ -426,9 +426,34 @@ OpenGLRenderer::getBuffers()
     return buffers;
 }
 
+uint32_t
+OpenGLRenderer::getBytesPerRow(int buf_idx)
+{
+    return rowLength[buf_idx] * sizeof(uint32_t);
+}
+
+uint8_t *
+OpenGLRenderer::resizeBuffer(int buf_idx, uint8_t *current, int w, int h)
+{
+    int row = rowLength[buf_idx];
+
+    /* The buffers are fixed in size, only the rows are laid out anew. */
+    if ((w > row) || (((qint64) row * h * sizeof(uint32_t)) > BUFFERBYTES)) {
+        row = bufferSize(w, h).width();
+        if (((qint64) row * h * sizeof(uint32_t)) > BUFFERBYTES)
+            return nullptr;
+
+        rowLength[buf_idx] = row;
+    }
+
+    return current;
+}
+
 void
-OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
+OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h, int stride)
 {
+    const int row = stride / sizeof(uint32_t);
+
     if (notReady())
         return;
 
@@ -452,10 +477,10 @@ OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
     }
 
     if (!hasBufferStorage)
-        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, BUFFERBYTES * buf_idx, h * ROW_LENGTH * sizeof(uint32_t) + (y * ROW_LENGTH * sizeof(uint32_t)), (uint8_t *) unpackBuffer + BUFFERBYTES * buf_idx);
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, BUFFERBYTES * buf_idx, (y + h) * stride, (uint8_t *) unpackBuffer + BUFFERBYTES * buf_idx);
 
-    glPixelStorei(GL_UNPACK_SKIP_PIXELS, BUFFERPIXELS * buf_idx + y * ROW_LENGTH + x);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, ROW_LENGTH);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, BUFFERPIXELS * buf_idx + y * row + x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row);
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
 
     /* TODO: check if fence sync is implementable here and still has any benefit. */
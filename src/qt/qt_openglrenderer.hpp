@@ -52,6 +52,8 @@ public:
     ~OpenGLRenderer();
 
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> getBuffers() override;
+    uint32_t                                               getBytesPerRow(int buf_idx) override;
+    uint8_t                                               *resizeBuffer(int buf_idx, uint8_t *current, int w, int h) override;
 
     void     finalize() override final;
     bool     hasOptions() const override { return true; }
@@ -63,7 +65,7 @@ signals:
     void errorInitializing();
 
 public slots:
-    void onBlit(int buf_idx, int x, int y, int w, int h);
+    void onBlit(int buf_idx, int x, int y, int w, int h, int stride);
 
 protected:
     void exposeEvent(QExposeEvent *event) override;
@@ -73,7 +75,7 @@ protected:
 private:
     static constexpr int INIT_WIDTH   = 640;
     static constexpr int INIT_HEIGHT  = 400;
-    static constexpr int ROW_LENGTH   = 2048;
+    static constexpr int ROW_LENGTH   = 2048;     /* Initial row length of the buffers, in pixels. */
     static constexpr int BUFFERPIXELS = 4194304;
     static constexpr int BUFFERBYTES  = 16777216; /* Pixel is 4 bytes. */
     static constexpr int BUFFERCOUNT  = 3;        /* How many buffers to use for pixel transfer (2-3 is commonly recommended). */
@@ -96,6 +98,10 @@ private:
 
     void *unpackBuffer = nullptr;
 
+    /* Row length of each buffer in pixels, picked by the blitter thread to
+       fit the frame; onBlit() gets it as the stride. */
+    int rowLength[BUFFERCOUNT] = { ROW_LENGTH, ROW_LENGTH, ROW_LENGTH };
+
     void initialize();
     void initializeExtensions();
     void initializeBuffers();
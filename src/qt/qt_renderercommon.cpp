@@ -33,6 +33,21 @@ extern "C" {
 
 RendererCommon::RendererCommon() = default;
 
+/* A buffer is kept while it holds the frame and is not more than four times
+   its size, so that a mode switch back to a lower resolution gives the
+   memory back. */
+bool
+RendererCommon::bufferFits(int buf_w, int buf_h, int w, int h) const
+{
+    return (w <= buf_w) && (h <= buf_h) && ((qint64) buf_w * buf_h <= (qint64) w * h * 4);
+}
+
+QSize
+RendererCommon::bufferSize(int w, int h) const
+{
+    return QSize((w + 63) & ~63, (h + 63) & ~63);
+}
+
 extern MainWindow *main_window;
 
 static void
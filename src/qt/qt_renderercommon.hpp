@@ -20,7 +20,15 @@ public:
     void         onResize(int width, int height);
     virtual void finalize() { }
 
-    virtual uint32_t getBytesPerRow() { return 2048 * 4; }
+    virtual uint32_t getBytesPerRow(int buf_idx) { return 2048 * 4; }
+
+    /* Called from the blitter thread while it owns buffer buf_idx, to make it
+       hold a w x h frame. Returns the buffer, which may have moved, or nullptr
+       if the renderer cannot take a frame that large. */
+    virtual uint8_t *resizeBuffer(int buf_idx, uint8_t *current, int w, int h)
+    {
+        return ((w > 2048) || (h > 2048)) ? nullptr : current;
+    }
 
     virtual std::vector<std::tuple<uint8_t *, std::atomic_flag *>> getBuffers()
     {
@@ -28,6 +36,10 @@ public:
         return buffers;
     }
 
+    /* Does renderer upload straight out of the held frame of a blit (see
+       video_frame_acquire_monitor()) instead of using getBuffers() */
+    virtual bool uploadsFrames() const { return false; }
+
     /* Does renderer implement options dialog */
     virtual bool hasOptions() const { return false; }
     /* Returns options dialog for renderer */
@@ -36,9 +48,13 @@ public:
     virtual void reloadOptions() { }
 
     int      r_monitor_index = 0;
+    /* Set while a frame is on its way to or held by the renderer. */
+    std::atomic_bool frame_held { false };
 
 protected:
     bool     eventDelegate(QEvent *event, bool &result);
+    bool     bufferFits(int buf_w, int buf_h, int w, int h) const;
+    QSize    bufferSize(int w, int h) const;
     void      drawStatusBarIcons(QPainter* painter);
 
     QRect    source { 0, 0, 0, 0 };
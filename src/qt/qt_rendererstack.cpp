@@ -38,6 +38,7 @@
 
 #include <QScreen>
 #include <QMessageBox>
+#include <QTimer>
 
 #ifdef __APPLE__
 #    include <CoreGraphics/CoreGraphics.h>
@@ -49,6 +50,7 @@ extern "C" {
 #include <86box/plat.h>
 #include <86box/video.h>
 #include <86box/mouse.h>
+#include <86box/ui.h>
 }
 
 struct mouseinputdata {
@@ -59,6 +61,21 @@ struct mouseinputdata {
 static mouseinputdata mousedata;
 
 extern MainWindow *main_window;
+
+/* Called from the screenshot thread once the PNG file is written, or not. */
+static void
+screenshotDone(const char *path, int success, void *)
+{
+    const QString msg = success ? QCoreApplication::translate("RendererStack", "Screenshot saved to %1").arg(QString::fromUtf8(path))
+                                : QCoreApplication::translate("RendererStack", "Unable to save screenshot to %1").arg(QString::fromUtf8(path));
+
+    QMetaObject::invokeMethod(main_window, [msg]() {
+        emit main_window->statusBarMessage(msg);
+        /* Put the usual status bar text back after a while. */
+        QTimer::singleShot(5000, main_window, []() { ui_sb_update_text(); });
+    }, Qt::QueuedConnection);
+}
+
 RendererStack::RendererStack(QWidget *parent, int monitor_index)
     : QStackedWidget(parent)
     , ui(new Ui::RendererStack)
@@ -288,6 +305,7 @@ RendererStack::switchRenderer(Renderer renderer)
         rendererWindow->finalize();
         removeWidget(current.get());
         disconnect(this, &RendererStack::blitToRenderer, nullptr, nullptr);
+        disconnect(this, &RendererStack::blitFrameToRenderer, nullptr, nullptr);
 
         /* Create new renderer only after previous is destroyed! */
         connect(current.get(), &QObject::destroyed, [this, renderer](QObject *) { createRenderer(renderer); });
@@ -320,7 +338,7 @@ RendererStack::createRenderer(Renderer renderer)
                 this->createWinId();
                 auto hw        = new HardwareRenderer(this);
                 rendererWindow = hw;
-                connect(this, &RendererStack::blitToRenderer, hw, &HardwareRenderer::onBlit, Qt::QueuedConnection);
+                connect(this, &RendererStack::blitFrameToRenderer, hw, &HardwareRenderer::onBlitFrame, Qt::QueuedConnection);
                 current.reset(this->createWindowContainer(hw, this));
                 break;
             }
@@ -329,7 +347,7 @@ RendererStack::createRenderer(Renderer renderer)
                 this->createWinId();
                 auto hw        = new HardwareRenderer(this, HardwareRenderer::RenderType::OpenGLES);
                 rendererWindow = hw;
-                connect(this, &RendererStack::blitToRenderer, hw, &HardwareRenderer::onBlit, Qt::QueuedConnection);
+                connect(this, &RendererStack::blitFrameToRenderer, hw, &HardwareRenderer::onBlitFrame, Qt::QueuedConnection);
                 current.reset(this->createWindowContainer(hw, this));
                 break;
             }
@@ -342,6 +360,7 @@ RendererStack::createRenderer(Renderer renderer)
                 connect(hw, &OpenGLRenderer::initialized, [=]() {
                     /* Buffers are available only after initialization. */
                     imagebufs = rendererWindow->getBuffers();
+                    imagebufsDirty.clear();
                     endblit();
                     emit rendererChanged();
                 });
@@ -374,6 +393,7 @@ RendererStack::createRenderer(Renderer renderer)
                 connect(hw, &VulkanWindowRenderer::rendererInitialized, [=]() {
                     /* Buffers are available only after initialization. */
                     imagebufs = rendererWindow->getBuffers();
+                    imagebufsDirty.clear();
                     endblit();
                     emit rendererChanged();
                 });
@@ -401,9 +421,12 @@ RendererStack::createRenderer(Renderer renderer)
     this->setStyleSheet("background-color: black");
 
     currentBuf = 0;
+    frameDirty = QRect(0, 0, VIDEO_MAX_X, VIDEO_MAX_Y);
 
+    rendererWindow->r_monitor_index = m_monitor_index;
     if (renderer != Renderer::OpenGL3 && renderer != Renderer::Vulkan) {
         imagebufs = rendererWindow->getBuffers();
+        imagebufsDirty.clear();
         endblit();
         emit rendererChanged();
     }
@@ -414,30 +437,126 @@ void
 RendererStack::blit(int x, int y, int w, int h)
 {
     if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) ||
-        (w > 2048) || (h > 2048) ||
-        (monitors[m_monitor_index].target_buffer == NULL) || imagebufs.empty() ||
-        std::get<std::atomic_flag *>(imagebufs[currentBuf])->test_and_set()) {
+        (monitors[m_monitor_index].target_buffer == NULL) || (imagebufs.empty() && !rendererWindow->uploadsFrames())) {
+        video_blit_complete_monitor(m_monitor_index);
+        return;
+    }
+
+    /* Frames that get dropped below still have to reach every buffer, so
+       the changed area is accumulated per buffer before anything else. */
+    QRect frame(x, y, w, h);
+    QRect dirty;
+    int   dx, dy, dw, dh;
+    if (video_blit_get_dirty_monitor(m_monitor_index, &dx, &dy, &dw, &dh))
+        dirty.setRect(dx, dy, dw, dh);
+    if (rendererWindow->uploadsFrames()) {
+        blitFrame(frame, dirty);
+        return;
+    }
+    if ((imagebufsDirty.size() != imagebufs.size()) || (frame != QRect(sx, sy, sw, sh)))
+        imagebufsDirty.assign(imagebufs.size(), frame);
+    else {
+        for (auto &bufDirty : imagebufsDirty)
+            bufDirty |= dirty;
+    }
+
+    if (std::get<std::atomic_flag *>(imagebufs[currentBuf])->test_and_set()) {
+        video_blit_complete_monitor(m_monitor_index);
+        return;
+    }
+
+    /* The buffer is ours until the renderer is done with it, so it can be
+       sized to the frame here; a moved or restrided buffer has to be filled
+       in full. */
+    uint8_t *imagebits = rendererWindow->resizeBuffer(currentBuf, std::get<uint8_t *>(imagebufs[currentBuf]), x + w, y + h);
+    if (imagebits == nullptr) {
+        std::get<std::atomic_flag *>(imagebufs[currentBuf])->clear();
         video_blit_complete_monitor(m_monitor_index);
         return;
     }
+    uint32_t pitch = rendererWindow->getBytesPerRow(currentBuf);
+    if (imagebufsPitch.size() != imagebufs.size())
+        imagebufsPitch.assign(imagebufs.size(), 0);
+    if ((imagebits != std::get<uint8_t *>(imagebufs[currentBuf])) || (pitch != imagebufsPitch[currentBuf])) {
+        std::get<uint8_t *>(imagebufs[currentBuf]) = imagebits;
+        imagebufsPitch[currentBuf]                 = pitch;
+        imagebufsDirty[currentBuf]                 = frame;
+    }
+
     sx = x;
     sy = y;
     sw = this->w = w;
-    sh = this->h       = h;
-    uint8_t *imagebits = std::get<uint8_t *>(imagebufs[currentBuf]);
-    for (int y1 = y; y1 < (y + h); y1++) {
-        auto scanline = imagebits + (y1 * rendererWindow->getBytesPerRow()) + (x * 4);
-        video_copy(scanline, &(monitors[m_monitor_index].target_buffer->line[y1][x]), w * 4);
+    sh = this->h = h;
+    QRect copy = imagebufsDirty[currentBuf] & frame;
+    imagebufsDirty[currentBuf] = QRect();
+    for (int y1 = copy.top(); y1 <= copy.bottom(); y1++) {
+        auto scanline = imagebits + (y1 * pitch) + (copy.left() * 4);
+        video_copy(scanline, &(monitors[m_monitor_index].target_buffer->line[y1][copy.left()]), copy.width() * 4);
     }
 
     if (monitors[m_monitor_index].mon_screenshots) {
-        video_screenshot_monitor((uint32_t *) imagebits, x, y, 2048, m_monitor_index);
+        video_screenshot_monitor_ex((uint32_t *) imagebits, x, y, pitch / 4, m_monitor_index, screenshotDone, nullptr);
     }
     video_blit_complete_monitor(m_monitor_index);
-    emit blitToRenderer(currentBuf, sx, sy, sw, sh);
+
+    if (copy.isEmpty()) {
+        /* Nothing changed since the renderer got its last buffer. */
+        std::get<std::atomic_flag *>(imagebufs[currentBuf])->clear();
+        return;
+    }
+
+    emit blitToRenderer(currentBuf, sx, sy, sw, sh, pitch);
     currentBuf = (currentBuf + 1) % imagebufs.size();
 }
 
+// called from blitter thread, for renderers reading the frame in place
+void
+RendererStack::blitFrame(const QRect &frame, const QRect &dirty)
+{
+    const bitmap_t *target = monitors[m_monitor_index].target_buffer;
+    bitmap_t       *held   = nullptr;
+
+    /* Changes made while the renderer still holds a frame go out with the
+       next one it gets. */
+    if (frame != QRect(sx, sy, sw, sh))
+        frameDirty = frame;
+    else
+        frameDirty |= dirty;
+
+    if (monitors[m_monitor_index].mon_screenshots) {
+        video_screenshot_monitor_ex(target->dat, frame.x(), frame.y(), target->w, m_monitor_index, screenshotDone, nullptr);
+    }
+
+    if ((frameDirty & frame).isEmpty() || rendererWindow->frame_held.exchange(true)) {
+        video_blit_complete_monitor(m_monitor_index);
+        return;
+    }
+
+    held = video_frame_acquire_monitor(m_monitor_index);
+    video_blit_complete_monitor(m_monitor_index);
+    if (held == nullptr) {
+        rendererWindow->frame_held = false;
+        return;
+    }
+
+    sx = frame.x();
+    sy = frame.y();
+    sw = this->w = frame.width();
+    sh = this->h = frame.height();
+    emit blitFrameToRenderer(held, frameDirty & frame, sx, sy, sw, sh);
+    frameDirty = QRect();
+}
+
+// called from blitter thread while hidden
+void
+RendererStack::skipBlit()
+{
+    /* The frame is lost, so the buffers have to be refilled once shown again. */
+    imagebufsDirty.clear();
+    frameDirty = QRect(0, 0, VIDEO_MAX_X, VIDEO_MAX_Y);
+    video_blit_complete_monitor(m_monitor_index);
+}
+
 void
 RendererStack::closeEvent(QCloseEvent *event)
 {
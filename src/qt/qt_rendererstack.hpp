@@ -7,6 +7,7 @@
 #include <QStackedWidget>
 #include <QWidget>
 #include <QCursor>
+#include <QRect>
 
 #include <atomic>
 #include <memory>
@@ -79,14 +80,18 @@ public:
     void (*mouse_exit_func)()                   = nullptr;
 
 signals:
-    void blitToRenderer(int buf_idx, int x, int y, int w, int h);
+    /* stride is the distance between the rows of buffer buf_idx in bytes. */
+    void blitToRenderer(int buf_idx, int x, int y, int w, int h, int stride);
+    void blitFrameToRenderer(void *frame, QRect dirty, int x, int y, int w, int h);
     void rendererChanged();
 
 public slots:
     void blit(int x, int y, int w, int h);
+    void skipBlit();
 
 private:
     void createRenderer(Renderer renderer);
+    void blitFrame(const QRect &frame, const QRect &dirty);
 
     Ui::RendererStack *ui;
 
@@ -94,16 +99,22 @@ private:
     int y;
     int w;
     int h;
-    int sx;
-    int sy;
-    int sw;
-    int sh;
+    int sx = 0;
+    int sy = 0;
+    int sw = 0;
+    int sh = 0;
 
     int currentBuf      = 0;
     int isMouseDown     = 0;
     int m_monitor_index = 0;
 
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> imagebufs;
+    /* Area of the target buffer changed since each image buffer was last filled. */
+    std::vector<QRect> imagebufsDirty;
+    /* Row stride each image buffer was last filled with. */
+    std::vector<uint32_t> imagebufsPitch;
+    /* Area of the target buffer changed since the renderer last got a frame. */
+    QRect frameDirty;
 
     RendererCommon          *rendererWindow { nullptr };
     std::unique_ptr<QWidget> current;
@@ -36,8 +36,8 @@ SoftwareRenderer::SoftwareRenderer(QWidget *parent)
 {
     RendererCommon::parentWidget = parent;
 
-    images[0] = std::make_unique<QImage>(QSize(2048, 2048), QImage::Format_RGB32);
-    images[1] = std::make_unique<QImage>(QSize(2048, 2048), QImage::Format_RGB32);
+    images[0] = std::make_unique<QImage>(QSize(640, 480), QImage::Format_RGB32);
+    images[1] = std::make_unique<QImage>(QSize(640, 480), QImage::Format_RGB32);
 
     buf_usage = std::vector<std::atomic_flag>(2);
     buf_usage[0].clear();
@@ -55,7 +55,7 @@ SoftwareRenderer::paintEvent(QPaintEvent *event)
 }
 
 void
-SoftwareRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
+SoftwareRenderer::onBlit(int buf_idx, int x, int y, int w, int h, int stride)
 {
     /* TODO: should look into deleteLater() */
     auto  tval    = this;
@@ -112,9 +112,28 @@ SoftwareRenderer::onPaint(QPaintDevice *device)
     painter.fillRect(0, 0, device->width(), device->height(), Qt::black);
 #endif
     painter.setCompositionMode(QPainter::CompositionMode_Plus);
+
+    std::lock_guard<std::mutex> lock(images_mutex);
     painter.drawImage(destination, *images[cur_image], source);
 }
 
+uint32_t
+SoftwareRenderer::getBytesPerRow(int buf_idx)
+{
+    return images[buf_idx]->bytesPerLine();
+}
+
+uint8_t *
+SoftwareRenderer::resizeBuffer(int buf_idx, uint8_t *current, int w, int h)
+{
+    if (bufferFits(images[buf_idx]->width(), images[buf_idx]->height(), w, h))
+        return current;
+
+    std::lock_guard<std::mutex> lock(images_mutex);
+    images[buf_idx] = std::make_unique<QImage>(bufferSize(w, h), QImage::Format_RGB32);
+    return images[buf_idx]->bits();
+}
+
 std::vector<std::tuple<uint8_t *, std::atomic_flag *>>
 SoftwareRenderer::getBuffers()
 {
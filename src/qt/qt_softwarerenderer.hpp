@@ -6,6 +6,7 @@
 #include <QPaintDevice>
 #include <array>
 #include <atomic>
+#include <mutex>
 #include "qt_renderercommon.hpp"
 
 class SoftwareRenderer :
@@ -22,13 +23,16 @@ public:
     void paintEvent(QPaintEvent *event) override;
 
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> getBuffers() override;
+    uint32_t getBytesPerRow(int buf_idx) override;
+    uint8_t *resizeBuffer(int buf_idx, uint8_t *current, int w, int h) override;
 
 public slots:
-    void onBlit(int buf_idx, int x, int y, int w, int h);
+    void onBlit(int buf_idx, int x, int y, int w, int h, int stride);
 
 protected:
     std::array<std::unique_ptr<QImage>, 2> images;
     int                                    cur_image = -1;
+    std::mutex                             images_mutex;
 
     void onPaint(QPaintDevice *device);
     void resizeEvent(QResizeEvent *event) override;
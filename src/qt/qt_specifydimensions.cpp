@@ -42,9 +42,9 @@ SpecifyDimensions::SpecifyDimensions(QWidget *parent)
 {
     ui->setupUi(this);
     ui->checkBox->setChecked(vid_resize == 2);
-    ui->spinBoxWidth->setRange(16, 2048);
+    ui->spinBoxWidth->setRange(16, VIDEO_MAX_X);
     ui->spinBoxWidth->setValue(main_window->getRenderWidgetSize().width());
-    ui->spinBoxHeight->setRange(16, 2048);
+    ui->spinBoxHeight->setRange(16, VIDEO_MAX_Y);
     ui->spinBoxHeight->setValue(main_window->getRenderWidgetSize().height());
 
     if (dpi_scale == 0) {
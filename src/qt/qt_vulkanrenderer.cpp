@@ -95,9 +95,9 @@ VulkanRenderer2::createShader(const QString &name)
 }
 
 bool
-VulkanRenderer2::createTexture()
+VulkanRenderer2::createTexture(const QSize &size)
 {
-    QImage img(2048, 2048, QImage::Format_RGBA8888_Premultiplied);
+    QImage img(size, QImage::Format_RGBA8888_Premultiplied);
     img.fill(QColor(0, 0, 0));
 
     QVulkanFunctions *f   = m_window->vulkanInstance()->functions();
@@ -310,7 +310,7 @@ VulkanRenderer2::ensureTexture()
         }
         imagePitch = layout.rowPitch;
 
-        if (qobject_cast<VulkanWindowRenderer *>(m_window)) {
+        if (qobject_cast<VulkanWindowRenderer *>(m_window) && !m_texResizing) {
             emit qobject_cast<VulkanWindowRenderer *>(m_window)->rendererInitialized();
         }
     } else {
@@ -356,7 +356,7 @@ VulkanRenderer2::ensureTexture()
             }
             imagePitch = layout.rowPitch;
 
-            if (qobject_cast<VulkanWindowRenderer *>(m_window)) {
+            if (qobject_cast<VulkanWindowRenderer *>(m_window) && !m_texResizing) {
                 emit qobject_cast<VulkanWindowRenderer *>(m_window)->rendererInitialized();
             }
 
@@ -388,6 +388,35 @@ VulkanRenderer2::ensureTexture()
     }
 }
 
+void
+VulkanRenderer2::writeDescriptors(VkSampler sampler)
+{
+    VkDescriptorImageInfo descImageInfo = {
+        sampler,
+        m_texView,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    };
+
+    for (int i = 0; i < m_window->concurrentFrameCount(); i++) {
+        VkWriteDescriptorSet descWrite[2];
+        memset(descWrite, 0, sizeof(descWrite));
+        descWrite[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descWrite[0].dstSet          = m_descSet[i];
+        descWrite[0].dstBinding      = 0;
+        descWrite[0].descriptorCount = 1;
+        descWrite[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descWrite[0].pBufferInfo     = &m_uniformBufInfo[i];
+
+        descWrite[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descWrite[1].dstSet          = m_descSet[i];
+        descWrite[1].dstBinding      = 1;
+        descWrite[1].descriptorCount = 1;
+        descWrite[1].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descWrite[1].pImageInfo      = &descImageInfo;
+        m_devFuncs->vkUpdateDescriptorSets(m_window->device(), 2, descWrite, 0, nullptr);
+    }
+}
+
 void
 VulkanRenderer2::updateSamplers()
 {
@@ -397,31 +426,43 @@ VulkanRenderer2::updateSamplers()
         cur_video_filter_method = video_filter_method;
         m_devFuncs->vkDeviceWaitIdle(m_window->device());
 
-        VkDescriptorImageInfo descImageInfo = {
-            cur_video_filter_method == 1 ? m_linearSampler : m_sampler,
-            m_texView,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
+        writeDescriptors(cur_video_filter_method == 1 ? m_linearSampler : m_sampler);
+    }
+}
 
-        for (int i = 0; i < m_window->concurrentFrameCount(); i++) {
-            VkWriteDescriptorSet descWrite[2];
-            memset(descWrite, 0, sizeof(descWrite));
-            descWrite[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descWrite[0].dstSet          = m_descSet[i];
-            descWrite[0].dstBinding      = 0;
-            descWrite[0].descriptorCount = 1;
-            descWrite[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descWrite[0].pBufferInfo     = &m_uniformBufInfo[i];
-
-            descWrite[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descWrite[1].dstSet          = m_descSet[i];
-            descWrite[1].dstBinding      = 1;
-            descWrite[1].descriptorCount = 1;
-            descWrite[1].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descWrite[1].pImageInfo      = &descImageInfo;
-            m_devFuncs->vkUpdateDescriptorSets(m_window->device(), 2, descWrite, 0, nullptr);
-        }
+// Replaces the texture with the size the blitter thread asked for, once it
+// is not filling the old one. The texture is mapped again before the blitter
+// gets it back, and starts out black for it to refill in full.
+void
+VulkanRenderer2::applyTextureSize()
+{
+    auto *window = qobject_cast<VulkanWindowRenderer *>(m_window);
+
+    if (!m_texRequest.load() || window->buf_usage[0].test_and_set())
+        return;
+
+    const uint32_t request = m_texRequest.exchange(0);
+    const QSize    size(request >> 16, request & 0xffff);
+
+    m_devFuncs->vkDeviceWaitIdle(m_window->device());
+    releaseTexture();
+    mappedPtr                  = nullptr;
+    m_texLayoutPending         = false;
+    m_texStagingPending        = false;
+    m_texStagingTransferLayout = false;
+
+    if (!createTexture(size)) {
+        qWarning("Failed to resize texture to %dx%d", size.width(), size.height());
+        return emit window->errorInitializing();
     }
+
+    writeDescriptors(video_filter_method == 1 ? m_linearSampler : m_sampler);
+
+    m_texResizing = true;
+    ensureTexture();
+    m_texResizing = false;
+
+    window->buf_usage[0].clear();
 }
 
 void
@@ -548,7 +589,7 @@ VulkanRenderer2::initResources()
     }
 
     // Texture.
-    if (!createTexture()) {
+    if (!createTexture(m_texSize.isEmpty() ? QSize(INIT_WIDTH, INIT_HEIGHT) : m_texSize)) {
         qWarning("Failed to create texture");
         return emit qobject_cast<VulkanWindowRenderer *>(m_window)->errorInitializing();
     }
@@ -823,22 +864,10 @@ VulkanRenderer2::releaseSwapChainResources()
 }
 
 void
-VulkanRenderer2::releaseResources()
+VulkanRenderer2::releaseTexture()
 {
-    qDebug("releaseResources");
-
     VkDevice dev = m_window->device();
 
-    if (m_sampler) {
-        m_devFuncs->vkDestroySampler(dev, m_sampler, nullptr);
-        m_sampler = VK_NULL_HANDLE;
-    }
-
-    if (m_linearSampler) {
-        m_devFuncs->vkDestroySampler(dev, m_linearSampler, nullptr);
-        m_linearSampler = VK_NULL_HANDLE;
-    }
-
     if (m_texStaging) {
         m_devFuncs->vkDestroyImage(dev, m_texStaging, nullptr);
         m_texStaging = VK_NULL_HANDLE;
@@ -863,6 +892,26 @@ VulkanRenderer2::releaseResources()
         m_devFuncs->vkFreeMemory(dev, m_texMem, nullptr);
         m_texMem = VK_NULL_HANDLE;
     }
+}
+
+void
+VulkanRenderer2::releaseResources()
+{
+    qDebug("releaseResources");
+
+    VkDevice dev = m_window->device();
+
+    if (m_sampler) {
+        m_devFuncs->vkDestroySampler(dev, m_sampler, nullptr);
+        m_sampler = VK_NULL_HANDLE;
+    }
+
+    if (m_linearSampler) {
+        m_devFuncs->vkDestroySampler(dev, m_linearSampler, nullptr);
+        m_linearSampler = VK_NULL_HANDLE;
+    }
+
+    releaseTexture();
 
     if (m_pipeline) {
         m_devFuncs->vkDestroyPipeline(dev, m_pipeline, nullptr);
@@ -908,6 +957,7 @@ VulkanRenderer2::startNextFrame()
     const QSize     sz  = m_window->swapChainImageSize();
 
     updateSamplers();
+    applyTextureSize();
     // Add the necessary barriers and do the host-linear -> device-optimal copy, if not yet done.
     ensureTexture();
 
@@ -951,14 +1001,16 @@ VulkanRenderer2::startNextFrame()
     float *floatData   = (float *) p;
     auto   source      = qobject_cast<VulkanWindowRenderer *>(m_window)->source;
     auto   destination = qobject_cast<VulkanWindowRenderer *>(m_window)->destination;
-    floatData[3]       = (float) source.x() / 2048.f;
-    floatData[9]       = (float) (source.y()) / 2048.f;
-    floatData[8]       = (float) source.x() / 2048.f;
-    floatData[4]       = (float) (source.y() + source.height()) / 2048.f;
-    floatData[13]      = (float) (source.x() + source.width()) / 2048.f;
-    floatData[19]      = (float) (source.y()) / 2048.f;
-    floatData[18]      = (float) (source.x() + source.width()) / 2048.f;
-    floatData[14]      = (float) (source.y() + source.height()) / 2048.f;
+    const float texW   = (float) m_texSize.width();
+    const float texH   = (float) m_texSize.height();
+    floatData[3]       = (float) source.x() / texW;
+    floatData[9]       = (float) (source.y()) / texH;
+    floatData[8]       = (float) source.x() / texW;
+    floatData[4]       = (float) (source.y() + source.height()) / texH;
+    floatData[13]      = (float) (source.x() + source.width()) / texW;
+    floatData[19]      = (float) (source.y()) / texH;
+    floatData[18]      = (float) (source.x() + source.width()) / texW;
+    floatData[14]      = (float) (source.y() + source.height()) / texH;
 
     m_devFuncs->vkUnmapMemory(dev, m_bufMem);
 
@@ -35,15 +35,22 @@
 #include <QVulkanWindow>
 #include <QImage>
 
+#include <atomic>
+
 #if QT_CONFIG(vulkan)
 #    include "qt_vulkanwindowrenderer.hpp"
 
 class VulkanRenderer2 : public QVulkanWindowRenderer {
 public:
     void  *mappedPtr  = nullptr;
-    size_t imagePitch = 2048 * 4;
+    size_t imagePitch = INIT_WIDTH * 4;
     VulkanRenderer2(QVulkanWindow *w);
 
+    /* Only valid on the blitter thread while it owns the texture. */
+    QSize textureSize() const { return m_texSize; }
+    /* Replaces the texture with one of the given size on the next frame. */
+    void requestTextureSize(const QSize &size) { m_texRequest = (size.width() << 16) | size.height(); }
+
     void initResources() override;
     void initSwapChainResources() override;
     void releaseSwapChainResources() override;
@@ -52,8 +59,14 @@ public:
     void startNextFrame() override;
 
 private:
+    static constexpr int INIT_WIDTH  = 768;
+    static constexpr int INIT_HEIGHT = 512;
+
     VkShaderModule createShader(const QString &name);
-    bool           createTexture();
+    bool           createTexture(const QSize &size);
+    void           releaseTexture();
+    void           applyTextureSize();
+    void           writeDescriptors(VkSampler sampler);
     bool           createTextureImage(const QSize &size, VkImage *image, VkDeviceMemory *mem,
                                       VkImageTiling tiling, VkImageUsageFlags usage, uint32_t memIndex);
     bool           writeLinearImage(const QImage &img, VkImage image, VkDeviceMemory memory);
@@ -87,6 +100,9 @@ private:
     bool           m_texStagingTransferLayout = false;
     QSize          m_texSize;
     VkFormat       m_texFormat;
+    /* Texture size asked for by the blitter thread, width << 16 | height. */
+    std::atomic<uint32_t> m_texRequest { 0 };
+    bool                  m_texResizing = false;
 
     QMatrix4x4 m_proj;
 };
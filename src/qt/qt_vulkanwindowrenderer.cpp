@@ -829,7 +829,7 @@ VulkanWindowRenderer::event(QEvent *event)
 }
 
 void
-VulkanWindowRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
+VulkanWindowRenderer::onBlit(int buf_idx, int x, int y, int w, int h, int stride)
 {
     auto origSource = source;
     source.setRect(x, y, w, h);
@@ -841,11 +841,25 @@ VulkanWindowRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
 }
 
 uint32_t
-VulkanWindowRenderer::getBytesPerRow()
+VulkanWindowRenderer::getBytesPerRow(int buf_idx)
 {
     return renderer->imagePitch;
 }
 
+uint8_t *
+VulkanWindowRenderer::resizeBuffer(int buf_idx, uint8_t *current, int w, int h)
+{
+    const QSize size = renderer->textureSize();
+
+    if ((w <= size.width()) && (h <= size.height()))
+        return (uint8_t *) renderer->mappedPtr;
+
+    /* The texture only grows, as replacing it waits for the device to go
+       idle; the frames dropped until then keep their changes pending. */
+    renderer->requestTextureSize(bufferSize(w, h).expandedTo(size));
+    return nullptr;
+}
+
 std::vector<std::tuple<uint8_t *, std::atomic_flag *>>
 VulkanWindowRenderer::getBuffers()
 {
@@ -14,7 +14,7 @@ class VulkanWindowRenderer : public QVulkanWindow, public RendererCommon {
 public:
     VulkanWindowRenderer(QWidget *parent);
 public slots:
-    void onBlit(int buf_idx, int x, int y, int w, int h);
+    void onBlit(int buf_idx, int x, int y, int w, int h, int stride);
 signals:
     void rendererInitialized();
     void errorInitializing();
@@ -23,7 +23,8 @@ protected:
     virtual std::vector<std::tuple<uint8_t *, std::atomic_flag *>> getBuffers() override;
     void                                                           resizeEvent(QResizeEvent *) override;
     bool                                                           event(QEvent *) override;
-    uint32_t                                                       getBytesPerRow() override;
+    uint32_t                                                       getBytesPerRow(int buf_idx) override;
+    uint8_t                                                       *resizeBuffer(int buf_idx, uint8_t *current, int w, int h) override;
 
 private:
     QVulkanInstance instance;
@@ -227,7 +227,7 @@ scsi_disk_mode_sense_save(scsi_disk_t *dev)
 
     memset(file_name, 0, 512);
     sprintf(file_name, "scsi_disk_%02i_mode_sense.bin", dev->id);
-    fp = plat_fopen(nvr_path(file_name), "wb");
+    fp = nvr_fopen(file_name, "wb");
     if (fp) {
         fwrite(dev->ms_pages_saved.pages[0x30], 1, 0x18, fp);
         fclose(fp);
@@ -637,6 +637,17 @@ scsi_disk_buf_free(scsi_disk_t *dev)
     }
 }
 
+/* Wait for a background write to finish and release its buffer. */
+static void
+scsi_disk_io_wait(scsi_disk_t *dev)
+{
+    if (dev->io_buffer) {
+        hdd_image_async_wait(dev->id);
+        free(dev->io_buffer);
+        dev->io_buffer = NULL;
+    }
+}
+
 static void
 scsi_disk_bus_master_error(scsi_common_t *sc)
 {
@@ -726,11 +737,18 @@ scsi_disk_blocks(scsi_disk_t *dev, int32_t *len, UNUSED(int first_batch), int ou
 
     *len = dev->requested_blocks << 9;
 
-    for (int i = 0; i < dev->requested_blocks; i++) {
-        if (out)
-            hdd_image_write(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
-        else
-            hdd_image_read(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
+    scsi_disk_io_wait(dev);
+    if (out && hdd_image_write_async(dev->id, dev->sector_pos, dev->requested_blocks, dev->temp_buffer)) {
+        /* The buffer now belongs to the write, the next command allocates a new one. */
+        dev->io_buffer   = dev->temp_buffer;
+        dev->temp_buffer = NULL;
+    } else {
+        for (int i = 0; i < dev->requested_blocks; i++) {
+            if (out)
+                hdd_image_write(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
+            else
+                hdd_image_read(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
+        }
     }
 
     scsi_disk_log("%s %i bytes of blocks...\n", out ? "Written" : "Read", *len);
@@ -790,6 +808,7 @@ scsi_disk_reset(scsi_common_t *sc)
 {
     scsi_disk_t *dev = (scsi_disk_t *) sc;
 
+    scsi_disk_io_wait(dev);
     scsi_disk_rezero(dev);
     dev->tf->status         = 0;
     dev->callback           = 0.0;
@@ -876,6 +895,8 @@ scsi_disk_command(scsi_common_t *sc, uint8_t *cdb)
         dev->tf->error   = 0;
     }
 
+    scsi_disk_io_wait(dev);
+
     last_sector = hdd_image_get_last_sector(dev->id);
 
     dev->packet_len = 0;
@@ -1794,10 +1815,13 @@ scsi_disk_close(void)
                 memset(&scsi_devices[scsi_bus][scsi_id], 0x00, sizeof(scsi_device_t));
             }
 
-            hdd_image_close(c);
-
             dev = hdd[c].priv;
 
+            if (dev)
+                scsi_disk_io_wait(dev);
+
+            hdd_image_close(c);
+
             if (dev) {
                 if (dev->tf)
                     free(dev->tf);
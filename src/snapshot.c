@@ -0,0 +1,785 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of the machine save state (snapshot) subsystem.
+ *
+ *          A snapshot is a sequential stream, it is never seeked, so it
+ *          can be piped through external tools as well. The layout is:
+ *
+ *              magic[8], version (u32)
+ *              { 0x01, tag length (u8), tag, version (u32), chunks... }
+ *              0x00
+ *
+ *          Each section's data is cut into chunks of at most 64 kB:
+ *
+ *              raw length (u32), stored length (u32), encoding (u8), data
+ *
+ *          and is terminated by a chunk with a raw length of 0. Chunks that
+ *          are all zeroes are stored without a payload, everything else is
+ *          PackBits-encoded if that makes it smaller, which keeps mostly
+ *          empty guest RAM cheap on disk.
+ *
+ *          Restoring requires the same configuration the snapshot was
+ *          taken with: the machine is hard reset first, which recreates
+ *          all the devices, mappings and timers, and the saved state is
+ *          then loaded on top. A machine that has any device without save
+ *          state hooks can be neither saved nor restored, and a restore
+ *          that fails part way resets the machine again rather than leave
+ *          it half restored.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include "x86.h"
+#include "x87_sf.h"
+#include <86box/timer.h>
+#include <86box/device.h>
+#include <86box/hdd.h>
+#include <86box/machine.h>
+#include <86box/mem.h>
+#include <86box/nmi.h>
+#include <86box/plat.h>
+#include <86box/snapshot.h>
+
+#define SNAPSHOT_REC_END     0x00
+#define SNAPSHOT_REC_SECTION 0x01
+
+#define SNAPSHOT_ENC_MAX     (SNAPSHOT_CHUNK_SIZE + (SNAPSHOT_CHUNK_SIZE / 128) + 16)
+
+/* Sections that have to be present in every snapshot. */
+#define SNAPSHOT_SEC_TIMER   0x01
+#define SNAPSHOT_SEC_CPU     0x02
+#define SNAPSHOT_SEC_MEM     0x04
+#define SNAPSHOT_SEC_PIC     0x08
+#define SNAPSHOT_SEC_DMA     0x10
+#define SNAPSHOT_SEC_CORE    0x1f
+
+struct snapshot_t {
+    FILE    *fp;
+    int      write;
+    int      error;
+    int      in_section;
+    int      section_end;
+
+    uint32_t pos;
+    uint32_t len;
+
+    uint8_t  buf[SNAPSHOT_CHUNK_SIZE];
+    uint8_t  enc[SNAPSHOT_ENC_MAX];
+};
+
+#ifdef ENABLE_SNAPSHOT_LOG
+int snapshot_do_log = ENABLE_SNAPSHOT_LOG;
+
+static void
+snapshot_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (snapshot_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define snapshot_log(fmt, ...)
+#endif
+
+/* PackBits: a control byte of 0..127 is followed by that many + 1 literal
+   bytes, one of -1..-127 is followed by one byte repeated 1 - n times. */
+static uint32_t
+snapshot_rle_encode(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+    uint32_t i = 0;
+    uint32_t o = 0;
+    uint32_t run;
+    uint32_t lit;
+
+    while (i < len) {
+        run = 1;
+        while (((i + run) < len) && (run < 128) && (src[i + run] == src[i]))
+            run++;
+
+        if (run >= 3) {
+            dst[o++] = (uint8_t) (int8_t) (1 - (int) run);
+            dst[o++] = src[i];
+            i += run;
+            continue;
+        }
+
+        lit = 0;
+        while (((i + lit) < len) && (lit < 128)) {
+            if (((i + lit + 2) < len) && (src[i + lit] == src[i + lit + 1]) &&
+                (src[i + lit] == src[i + lit + 2]))
+                break;
+            lit++;
+        }
+
+        dst[o++] = (uint8_t) (lit - 1);
+        memcpy(&dst[o], &src[i], lit);
+        o += lit;
+        i += lit;
+    }
+
+    return o;
+}
+
+static int
+snapshot_rle_decode(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_len)
+{
+    uint32_t i = 0;
+    uint32_t o = 0;
+    int8_t   c;
+    uint32_t n;
+
+    while (i < len) {
+        c = (int8_t) src[i++];
+
+        if (c >= 0) {
+            n = ((uint32_t) c) + 1;
+            if (((i + n) > len) || ((o + n) > dst_len))
+                return 0;
+            memcpy(&dst[o], &src[i], n);
+            i += n;
+        } else if (c != -128) {
+            n = 1 - (int) c;
+            if ((i >= len) || ((o + n) > dst_len))
+                return 0;
+            memset(&dst[o], src[i++], n);
+        } else
+            continue;
+
+        o += n;
+    }
+
+    return (o == dst_len);
+}
+
+static void
+snapshot_put(snapshot_t *snap, const void *data, size_t len)
+{
+    if (snap->error)
+        return;
+
+    if (fwrite(data, 1, len, snap->fp) != len)
+        snap->error = 1;
+}
+
+static void
+snapshot_get(snapshot_t *snap, void *data, size_t len)
+{
+    if (snap->error) {
+        memset(data, 0x00, len);
+        return;
+    }
+
+    if (fread(data, 1, len, snap->fp) != len) {
+        memset(data, 0x00, len);
+        snap->error = 1;
+    }
+}
+
+static void
+snapshot_chunk_flush(snapshot_t *snap)
+{
+    uint32_t hdr[2];
+    uint8_t  enc = SNAPSHOT_ENC_ZERO;
+    uint32_t i;
+
+    if (snap->pos == 0)
+        return;
+
+    hdr[0] = snap->pos;
+    hdr[1] = 0;
+
+    for (i = 0; i < snap->pos; i++) {
+        if (snap->buf[i] != 0x00) {
+            enc = SNAPSHOT_ENC_RLE;
+            break;
+        }
+    }
+
+    if (enc == SNAPSHOT_ENC_RLE) {
+        hdr[1] = snapshot_rle_encode(snap->buf, snap->pos, snap->enc);
+        if (hdr[1] >= snap->pos) {
+            enc    = SNAPSHOT_ENC_RAW;
+            hdr[1] = snap->pos;
+        }
+    }
+
+    snapshot_put(snap, hdr, sizeof(hdr));
+    snapshot_put(snap, &enc, 1);
+    if (enc == SNAPSHOT_ENC_RAW)
+        snapshot_put(snap, snap->buf, hdr[1]);
+    else if (enc == SNAPSHOT_ENC_RLE)
+        snapshot_put(snap, snap->enc, hdr[1]);
+
+    snap->pos = 0;
+}
+
+static void
+snapshot_chunk_load(snapshot_t *snap)
+{
+    uint32_t hdr[2];
+    uint8_t  enc;
+
+    snap->pos = snap->len = 0;
+
+    snapshot_get(snap, hdr, sizeof(hdr));
+    snapshot_get(snap, &enc, 1);
+    if (snap->error)
+        return;
+
+    if (hdr[0] == 0) {
+        snap->section_end = 1;
+        return;
+    }
+
+    if ((hdr[0] > SNAPSHOT_CHUNK_SIZE) || (hdr[1] > SNAPSHOT_ENC_MAX)) {
+        snap->error = 1;
+        return;
+    }
+
+    switch (enc) {
+        case SNAPSHOT_ENC_RAW:
+            if (hdr[1] != hdr[0])
+                snap->error = 1;
+            else
+                snapshot_get(snap, snap->buf, hdr[0]);
+            break;
+
+        case SNAPSHOT_ENC_ZERO:
+            memset(snap->buf, 0x00, hdr[0]);
+            break;
+
+        case SNAPSHOT_ENC_RLE:
+            snapshot_get(snap, snap->enc, hdr[1]);
+            if (!snap->error && !snapshot_rle_decode(snap->enc, hdr[1], snap->buf, hdr[0]))
+                snap->error = 1;
+            break;
+
+        default:
+            snap->error = 1;
+            break;
+    }
+
+    if (!snap->error)
+        snap->len = hdr[0];
+}
+
+snapshot_t *
+snapshot_open(const char *fn, int write)
+{
+    snapshot_t *snap;
+    char        magic[8];
+    uint32_t    version;
+
+    snap = (snapshot_t *) calloc(1, sizeof(snapshot_t));
+    if (snap == NULL)
+        return NULL;
+
+    snap->write = write;
+    snap->fp    = plat_fopen(fn, write ? "wb" : "rb");
+    if (snap->fp == NULL) {
+        free(snap);
+        return NULL;
+    }
+
+    if (write) {
+        version = SNAPSHOT_VERSION;
+        snapshot_put(snap, SNAPSHOT_MAGIC, 8);
+        snapshot_put(snap, &version, sizeof(version));
+    } else {
+        snapshot_get(snap, magic, 8);
+        snapshot_get(snap, &version, sizeof(version));
+        if (memcmp(magic, SNAPSHOT_MAGIC, 8) || (version != SNAPSHOT_VERSION)) {
+            snapshot_log("Snapshot: %s is not a version %i snapshot\n", fn, SNAPSHOT_VERSION);
+            snap->error = 1;
+        }
+    }
+
+    return snap;
+}
+
+int
+snapshot_close(snapshot_t *snap)
+{
+    uint8_t rec = SNAPSHOT_REC_END;
+    int     ret;
+
+    if (snap == NULL)
+        return 0;
+
+    if (snap->write) {
+        if (snap->in_section)
+            snapshot_section_end(snap);
+        snapshot_put(snap, &rec, 1);
+        if (fflush(snap->fp))
+            snap->error = 1;
+    }
+
+    fclose(snap->fp);
+
+    ret = !snap->error;
+    free(snap);
+
+    return ret;
+}
+
+int
+snapshot_error(const snapshot_t *snap)
+{
+    return snap->error;
+}
+
+void
+snapshot_set_error(snapshot_t *snap)
+{
+    snap->error = 1;
+}
+
+void
+snapshot_section_begin(snapshot_t *snap, const char *tag, uint32_t version)
+{
+    uint8_t rec = SNAPSHOT_REC_SECTION;
+    uint8_t len = (uint8_t) strlen(tag);
+
+    if (snap->in_section)
+        snapshot_section_end(snap);
+
+    if (len >= SNAPSHOT_TAG_LEN)
+        len = SNAPSHOT_TAG_LEN - 1;
+
+    snapshot_put(snap, &rec, 1);
+    snapshot_put(snap, &len, 1);
+    snapshot_put(snap, tag, len);
+    snapshot_put(snap, &version, sizeof(version));
+
+    snap->in_section = 1;
+    snap->pos        = 0;
+}
+
+void
+snapshot_section_end(snapshot_t *snap)
+{
+    uint32_t hdr[2] = { 0, 0 };
+    uint8_t  enc    = SNAPSHOT_ENC_RAW;
+
+    if (!snap->in_section)
+        return;
+
+    snapshot_chunk_flush(snap);
+    snapshot_put(snap, hdr, sizeof(hdr));
+    snapshot_put(snap, &enc, 1);
+
+    snap->in_section = 0;
+}
+
+/* Move on to the next section, returns 0 at the end of the stream. */
+int
+snapshot_section_next(snapshot_t *snap, char *tag, uint32_t *version)
+{
+    uint8_t rec = SNAPSHOT_REC_END;
+    uint8_t len = 0;
+
+    if (snap->in_section)
+        snapshot_section_skip(snap);
+
+    snapshot_get(snap, &rec, 1);
+    if (snap->error || (rec != SNAPSHOT_REC_SECTION))
+        return 0;
+
+    snapshot_get(snap, &len, 1);
+    if (len >= SNAPSHOT_TAG_LEN)
+        snap->error = 1;
+    snapshot_get(snap, tag, len);
+    snapshot_get(snap, version, sizeof(uint32_t));
+    if (snap->error)
+        return 0;
+
+    tag[len]          = '\0';
+    snap->in_section  = 1;
+    snap->section_end = 0;
+    snap->pos = snap->len = 0;
+
+    return 1;
+}
+
+/* Discard whatever the handler did not consume of the current section. */
+void
+snapshot_section_skip(snapshot_t *snap)
+{
+    while (snap->in_section && !snap->section_end && !snap->error)
+        snapshot_chunk_load(snap);
+
+    snap->in_section = 0;
+    snap->pos = snap->len = 0;
+}
+
+void
+snapshot_write(snapshot_t *snap, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    uint32_t       n;
+
+    while (len && !snap->error) {
+        n = SNAPSHOT_CHUNK_SIZE - snap->pos;
+        if (n > len)
+            n = (uint32_t) len;
+
+        memcpy(&snap->buf[snap->pos], p, n);
+        snap->pos += n;
+        p += n;
+        len -= n;
+
+        if (snap->pos == SNAPSHOT_CHUNK_SIZE)
+            snapshot_chunk_flush(snap);
+    }
+}
+
+void
+snapshot_read(snapshot_t *snap, void *data, size_t len)
+{
+    uint8_t *p = (uint8_t *) data;
+    uint32_t n;
+
+    while (len) {
+        if (!snap->error && (snap->pos == snap->len)) {
+            if (snap->section_end)
+                snap->error = 1;
+            else
+                snapshot_chunk_load(snap);
+        }
+
+        if (snap->error) {
+            memset(p, 0x00, len);
+            return;
+        }
+
+        n = snap->len - snap->pos;
+        if (n > len)
+            n = (uint32_t) len;
+
+        memcpy(p, &snap->buf[snap->pos], n);
+        snap->pos += n;
+        p += n;
+        len -= n;
+    }
+}
+
+void
+snapshot_write_timer(snapshot_t *snap, const pc_timer_t *timer)
+{
+    int64_t remaining = 0;
+
+    if (timer->flags & TIMER_ENABLED)
+        remaining = (int64_t) (timer->ts.ts64 - (tsc << 32));
+
+    snapshot_write_u32(snap, timer->flags);
+    snapshot_write_u64(snap, (uint64_t) remaining);
+    snapshot_write(snap, &timer->period, sizeof(timer->period));
+}
+
+void
+snapshot_read_timer(snapshot_t *snap, pc_timer_t *timer)
+{
+    int     flags     = (int) snapshot_read_u32(snap);
+    int64_t remaining = (int64_t) snapshot_read_u64(snap);
+
+    snapshot_read(snap, &timer->period, sizeof(timer->period));
+
+    timer_disable(timer);
+    timer->flags = flags & ~TIMER_ENABLED;
+
+    if (flags & TIMER_ENABLED) {
+        timer->ts.ts64 = (tsc << 32) + (uint64_t) remaining;
+        timer_enable(timer);
+    }
+}
+
+static void
+snapshot_save_machine(snapshot_t *snap)
+{
+    char name[SNAPSHOT_TAG_LEN] = { 0 };
+
+    snprintf(name, sizeof(name), "%s", machine_get_internal_name());
+    snapshot_write(snap, name, sizeof(name));
+    snprintf(name, sizeof(name), "%s", cpu_f->internal_name);
+    snapshot_write(snap, name, sizeof(name));
+    snapshot_write_u32(snap, cpu);
+    snapshot_write_u32(snap, mem_size);
+    snapshot_write_u32(snap, fpu_type);
+    snapshot_write_u32(snap, cpu_use_dynarec);
+}
+
+static int
+snapshot_check_machine(snapshot_t *snap)
+{
+    char m_name[SNAPSHOT_TAG_LEN];
+    char c_name[SNAPSHOT_TAG_LEN];
+
+    snapshot_read(snap, m_name, sizeof(m_name));
+    snapshot_read(snap, c_name, sizeof(c_name));
+    m_name[SNAPSHOT_TAG_LEN - 1] = c_name[SNAPSHOT_TAG_LEN - 1] = '\0';
+
+    if (strcmp(m_name, machine_get_internal_name()) || strcmp(c_name, cpu_f->internal_name) ||
+        (snapshot_read_u32(snap) != cpu) || (snapshot_read_u32(snap) != mem_size) ||
+        (snapshot_read_u32(snap) != fpu_type) || (snapshot_read_u32(snap) != cpu_use_dynarec))
+        return 0;
+
+    return !snap->error;
+}
+
+static void
+snapshot_save_cpu(snapshot_t *snap)
+{
+    cpu_state_t state = cpu_state;
+    x86seg     *segs[6] = { &cpu_state.seg_cs, &cpu_state.seg_ds, &cpu_state.seg_es,
+                            &cpu_state.seg_ss, &cpu_state.seg_fs, &cpu_state.seg_gs };
+    uint8_t     ea_seg  = 1;
+
+    /* The effective segment is a pointer, store it as an index. */
+    for (uint8_t i = 0; i < 6; i++) {
+        if (cpu_state.ea_seg == segs[i])
+            ea_seg = i;
+    }
+    state.ea_seg = NULL;
+
+    snapshot_write(snap, &state, sizeof(state));
+    snapshot_write_u8(snap, ea_seg);
+    snapshot_write(snap, &fpu_state, sizeof(fpu_state));
+    snapshot_write(snap, &msr, sizeof(msr));
+    snapshot_write(snap, &cpu_cur_status, sizeof(cpu_cur_status));
+
+    snapshot_write_u32(snap, cr2);
+    snapshot_write_u32(snap, cr3);
+    snapshot_write_u32(snap, cr4);
+    snapshot_write(snap, dr, sizeof(dr));
+    snapshot_write(snap, &gdt, sizeof(gdt));
+    snapshot_write(snap, &ldt, sizeof(ldt));
+    snapshot_write(snap, &idt, sizeof(idt));
+    snapshot_write(snap, &tr, sizeof(tr));
+
+    snapshot_write_u32(snap, use32);
+    snapshot_write_u32(snap, stack32);
+    snapshot_write_u32(snap, oldcpl);
+    snapshot_write_u32(snap, trap);
+    snapshot_write_u32(snap, in_sys);
+    snapshot_write_u32(snap, smi_latched);
+    snapshot_write_u32(snap, smm_in_hlt);
+    snapshot_write_u32(snap, smi_block);
+    snapshot_write_u32(snap, nmi);
+    snapshot_write_u32(snap, nmi_mask);
+    snapshot_write_u32(snap, cpu_old_paging);
+    snapshot_write_u32(snap, cpu_cache_int_enabled);
+    snapshot_write_u32(snap, cpu_cache_ext_enabled);
+
+    snapshot_write_u64(snap, amd_efer);
+    snapshot_write_u64(snap, star);
+    snapshot_write_u16(snap, cs_msr);
+    snapshot_write_u32(snap, esp_msr);
+    snapshot_write_u32(snap, eip_msr);
+}
+
+static int
+snapshot_load_cpu(snapshot_t *snap)
+{
+    x86seg *segs[6] = { &cpu_state.seg_cs, &cpu_state.seg_ds, &cpu_state.seg_es,
+                        &cpu_state.seg_ss, &cpu_state.seg_fs, &cpu_state.seg_gs };
+    uint8_t ea_seg;
+
+    snapshot_read(snap, &cpu_state, sizeof(cpu_state));
+    ea_seg           = snapshot_read_u8(snap);
+    cpu_state.ea_seg = segs[(ea_seg < 6) ? ea_seg : 1];
+    snapshot_read(snap, &fpu_state, sizeof(fpu_state));
+    snapshot_read(snap, &msr, sizeof(msr));
+    snapshot_read(snap, &cpu_cur_status, sizeof(cpu_cur_status));
+
+    cr2 = snapshot_read_u32(snap);
+    cr3 = snapshot_read_u32(snap);
+    cr4 = snapshot_read_u32(snap);
+    snapshot_read(snap, dr, sizeof(dr));
+    snapshot_read(snap, &gdt, sizeof(gdt));
+    snapshot_read(snap, &ldt, sizeof(ldt));
+    snapshot_read(snap, &idt, sizeof(idt));
+    snapshot_read(snap, &tr, sizeof(tr));
+
+    use32                 = snapshot_read_u32(snap);
+    stack32               = (int) snapshot_read_u32(snap);
+    oldcpl                = (int) snapshot_read_u32(snap);
+    trap                  = (int) snapshot_read_u32(snap);
+    in_sys                = (int) snapshot_read_u32(snap);
+    smi_latched           = (int) snapshot_read_u32(snap);
+    smm_in_hlt            = (int) snapshot_read_u32(snap);
+    smi_block             = (int) snapshot_read_u32(snap);
+    nmi                   = (int) snapshot_read_u32(snap);
+    nmi_mask              = (int) snapshot_read_u32(snap);
+    cpu_old_paging        = (int) snapshot_read_u32(snap);
+    cpu_cache_int_enabled = (int) snapshot_read_u32(snap);
+    cpu_cache_ext_enabled = (int) snapshot_read_u32(snap);
+
+    amd_efer = snapshot_read_u64(snap);
+    star     = snapshot_read_u64(snap);
+    cs_msr   = snapshot_read_u16(snap);
+    esp_msr  = snapshot_read_u32(snap);
+    eip_msr  = snapshot_read_u32(snap);
+
+    return !snap->error;
+}
+
+int
+snapshot_save(const char *fn)
+{
+    snapshot_t *snap;
+    const char *missing = device_state_missing();
+
+    if (missing != NULL) {
+        pclog("Snapshot: %s cannot save its state, not saving %s\n", missing, fn);
+        return 0;
+    }
+
+    /* The snapshot refers to the disk images as they are on the host. */
+    hdd_image_flush_all();
+
+    snap = snapshot_open(fn, 1);
+    if (snap == NULL) {
+        pclog("Snapshot: unable to create %s\n", fn);
+        return 0;
+    }
+
+#ifdef USE_DYNAREC
+    if (cpu_use_dynarec)
+        update_tsc();
+#endif
+
+    snapshot_section_begin(snap, "machine", 1);
+    snapshot_save_machine(snap);
+
+    snapshot_section_begin(snap, "timer", 1);
+    snapshot_write_u64(snap, tsc);
+
+    snapshot_section_begin(snap, "cpu", 1);
+    snapshot_save_cpu(snap);
+
+    snapshot_section_begin(snap, "mem", 1);
+    mem_save_state(snap);
+
+    snapshot_section_begin(snap, "pic", 1);
+    pic_save_state(snap);
+
+    snapshot_section_begin(snap, "dma", 1);
+    dma_save_state(snap);
+
+    device_save_state_all(snap);
+
+    if (!snapshot_close(snap)) {
+        pclog("Snapshot: error writing %s\n", fn);
+        remove(fn);
+        return 0;
+    }
+
+    snapshot_log("Snapshot: saved %s\n", fn);
+
+    return 1;
+}
+
+int
+snapshot_load(const char *fn)
+{
+    snapshot_t *snap;
+    const char *missing = device_state_missing();
+    char        tag[SNAPSHOT_TAG_LEN];
+    uint32_t    version;
+    uint32_t    sections = 0;
+    int         devices  = 0;
+    int         ret      = 1;
+
+    if (missing != NULL) {
+        pclog("Snapshot: %s cannot restore its state, not loading %s\n", missing, fn);
+        return 0;
+    }
+
+    snap = snapshot_open(fn, 0);
+    if (snap == NULL) {
+        pclog("Snapshot: unable to open %s\n", fn);
+        return 0;
+    }
+
+    /* Refuse the snapshot before touching the machine if it was taken
+       with a different configuration. */
+    if (!snapshot_section_next(snap, tag, &version) || strcmp(tag, "machine") ||
+        !snapshot_check_machine(snap)) {
+        snapshot_close(snap);
+        pclog("Snapshot: %s does not match the current configuration\n", fn);
+        return 0;
+    }
+
+    pc_reset_hard_close();
+    pc_reset_hard_init();
+
+    while (ret && snapshot_section_next(snap, tag, &version)) {
+        if (!strcmp(tag, "timer")) {
+            /* Rebase the timers that were set up by the reset. */
+            timer_set_new_tsc(snapshot_read_u64(snap));
+            ret = (version == 1);
+            sections |= SNAPSHOT_SEC_TIMER;
+        } else if (!strcmp(tag, "cpu")) {
+            ret = (version == 1) && snapshot_load_cpu(snap);
+            sections |= SNAPSHOT_SEC_CPU;
+        } else if (!strcmp(tag, "mem")) {
+            ret = (version == 1) && mem_load_state(snap);
+            sections |= SNAPSHOT_SEC_MEM;
+        } else if (!strcmp(tag, "pic")) {
+            ret = (version == 1) && pic_load_state(snap);
+            sections |= SNAPSHOT_SEC_PIC;
+        } else if (!strcmp(tag, "dma")) {
+            ret = (version == 1) && dma_load_state(snap);
+            sections |= SNAPSHOT_SEC_DMA;
+        } else if (!strncmp(tag, "dev.", 4)) {
+            ret = device_load_state(snap, tag, version);
+            devices++;
+        } else
+            ret = 0;
+
+        if (!ret)
+            pclog("Snapshot: section \"%s\" (version %i) could not be restored\n", tag, version);
+    }
+
+    if (ret && ((sections != SNAPSHOT_SEC_CORE) || (devices != device_state_count()))) {
+        pclog("Snapshot: %s is incomplete\n", fn);
+        ret = 0;
+    }
+
+    if (!snapshot_close(snap) || !ret) {
+        /* The machine is in an undefined state now, start over before the
+           CPU gets to run on it. */
+        pclog("Snapshot: error reading %s, resetting\n", fn);
+        pc_reset_hard_close();
+        pc_reset_hard_init();
+        return 0;
+    }
+
+    flushmmucache();
+
+    snapshot_log("Snapshot: loaded %s\n", fn);
+
+    return 1;
+}
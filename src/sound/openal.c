@@ -37,17 +37,14 @@
 #define FREQ   SOUND_FREQ
 #define BUFLEN SOUNDBUFLEN
 
-ALuint        buffers[4];       /* front and back buffers */
-ALuint        buffers_music[4]; /* front and back buffers */
-ALuint        buffers_wt[4];    /* front and back buffers */
-ALuint        buffers_cd[4];    /* front and back buffers */
-ALuint        buffers_midi[4];  /* front and back buffers */
-static ALuint source[5];        /* audio source */
+ALuint        buffers[4];      /* front and back buffers */
+ALuint        buffers_midi[4]; /* front and back buffers */
+static ALuint source[2];       /* audio source */
 
 static int         midi_freq     = 44100;
 static int         midi_buf_size = 4410;
 static int         initialized   = 0;
-static int         sources       = 2;
+static int         sources       = 1;
 static ALCcontext *Context;
 static ALCdevice  *Device;
 
@@ -99,10 +96,8 @@ closeal(void)
     alSourceStopv(sources, source);
     alDeleteSources(sources, source);
 
-    if (sources == 4)
+    if (sources == 2)
         alDeleteBuffers(4, buffers_midi);
-    alDeleteBuffers(4, buffers_cd);
-    alDeleteBuffers(4, buffers_music);
     alDeleteBuffers(4, buffers);
 
     alutExit();
@@ -113,16 +108,10 @@ closeal(void)
 void
 inital(void)
 {
-    float   *buf             = NULL;
-    float   *music_buf       = NULL;
-    float   *wt_buf          = NULL;
-    float   *cd_buf          = NULL;
-    float   *midi_buf        = NULL;
-    int16_t *buf_int16       = NULL;
-    int16_t *music_buf_int16 = NULL;
-    int16_t *wt_buf_int16    = NULL;
-    int16_t *cd_buf_int16    = NULL;
-    int16_t *midi_buf_int16  = NULL;
+    float   *buf            = NULL;
+    float   *midi_buf       = NULL;
+    int16_t *buf_int16      = NULL;
+    int16_t *midi_buf_int16 = NULL;
 
     int         init_midi = 0;
 
@@ -136,76 +125,43 @@ inital(void)
     if ((strcmp(mdn, "none") != 0) && (strcmp(mdn, SYSTEM_MIDI_INTERNAL_NAME) != 0))
         init_midi = 1; /* If the device is neither none, nor system MIDI, initialize the
                           MIDI buffer and source, otherwise, do not. */
-    sources = 4 + !!init_midi;
+    sources = 1 + !!init_midi;
 
     if (sound_is_float) {
-        buf       = (float *) calloc((BUFLEN << 1), sizeof(float));
-        music_buf = (float *) calloc((MUSICBUFLEN << 1), sizeof(float));
-        wt_buf    = (float *) calloc((WTBUFLEN << 1), sizeof(float));
-        cd_buf    = (float *) calloc((CD_BUFLEN << 1), sizeof(float));
+        buf = (float *) calloc((BUFLEN << 1), sizeof(float));
         if (init_midi)
             midi_buf = (float *) calloc(midi_buf_size, sizeof(float));
     } else {
-        buf_int16       = (int16_t *) calloc((BUFLEN << 1), sizeof(int16_t));
-        music_buf_int16 = (int16_t *) calloc((MUSICBUFLEN << 1), sizeof(int16_t));
-        wt_buf_int16    = (int16_t *) calloc((WTBUFLEN << 1), sizeof(int16_t));
-        cd_buf_int16    = (int16_t *) calloc((CD_BUFLEN << 1), sizeof(int16_t));
+        buf_int16 = (int16_t *) calloc((BUFLEN << 1), sizeof(int16_t));
         if (init_midi)
             midi_buf_int16 = (int16_t *) calloc(midi_buf_size, sizeof(int16_t));
     }
 
     alGenBuffers(4, buffers);
-    alGenBuffers(4, buffers_cd);
-    alGenBuffers(4, buffers_music);
-    alGenBuffers(4, buffers_wt);
     if (init_midi)
         alGenBuffers(4, buffers_midi);
 
-    if (init_midi)
-        alGenSources(5, source);
-    else
-        alGenSources(4, source);
+    alGenSources(sources, source);
 
     alSource3f(source[0], AL_POSITION, 0.0f, 0.0f, 0.0f);
     alSource3f(source[0], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
     alSource3f(source[0], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
     alSourcef(source[0], AL_ROLLOFF_FACTOR, 0.0f);
     alSourcei(source[0], AL_SOURCE_RELATIVE, AL_TRUE);
-    alSource3f(source[1], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[1], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[1], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[1], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[1], AL_SOURCE_RELATIVE, AL_TRUE);
-    alSource3f(source[2], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[2], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[2], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[2], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[2], AL_SOURCE_RELATIVE, AL_TRUE);
-    alSource3f(source[3], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[3], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[3], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[3], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[3], AL_SOURCE_RELATIVE, AL_TRUE);
     if (init_midi) {
-        alSource3f(source[4], AL_POSITION, 0.0f, 0.0f, 0.0f);
-        alSource3f(source[4], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-        alSource3f(source[4], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-        alSourcef(source[4], AL_ROLLOFF_FACTOR, 0.0f);
-        alSourcei(source[4], AL_SOURCE_RELATIVE, AL_TRUE);
+        alSource3f(source[1], AL_POSITION, 0.0f, 0.0f, 0.0f);
+        alSource3f(source[1], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
+        alSource3f(source[1], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
+        alSourcef(source[1], AL_ROLLOFF_FACTOR, 0.0f);
+        alSourcei(source[1], AL_SOURCE_RELATIVE, AL_TRUE);
     }
 
     if (sound_is_float) {
         memset(buf, 0, BUFLEN * 2 * sizeof(float));
-        memset(cd_buf, 0, CD_BUFLEN * 2 * sizeof(float));
-        memset(music_buf, 0, MUSICBUFLEN * 2 * sizeof(float));
-        memset(wt_buf, 0, WTBUFLEN * 2 * sizeof(float));
         if (init_midi)
             memset(midi_buf, 0, midi_buf_size * sizeof(float));
     } else {
         memset(buf_int16, 0, BUFLEN * 2 * sizeof(int16_t));
-        memset(cd_buf_int16, 0, CD_BUFLEN * 2 * sizeof(int16_t));
-        memset(music_buf_int16, 0, MUSICBUFLEN * 2 * sizeof(int16_t));
-        memset(wt_buf_int16, 0, WTBUFLEN * 2 * sizeof(int16_t));
         if (init_midi)
             memset(midi_buf_int16, 0, midi_buf_size * sizeof(int16_t));
     }
@@ -213,47 +169,29 @@ inital(void)
     for (uint8_t c = 0; c < 4; c++) {
         if (sound_is_float) {
             alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, BUFLEN * 2 * sizeof(float), FREQ);
-            alBufferData(buffers_music[c], AL_FORMAT_STEREO_FLOAT32, music_buf, MUSICBUFLEN * 2 * sizeof(float), MUSIC_FREQ);
-            alBufferData(buffers_wt[c], AL_FORMAT_STEREO_FLOAT32, wt_buf, WTBUFLEN * 2 * sizeof(float), WT_FREQ);
-            alBufferData(buffers_cd[c], AL_FORMAT_STEREO_FLOAT32, cd_buf, CD_BUFLEN * 2 * sizeof(float), CD_FREQ);
             if (init_midi)
                 alBufferData(buffers_midi[c], AL_FORMAT_STEREO_FLOAT32, midi_buf, midi_buf_size * (int) sizeof(float), midi_freq);
         } else {
             alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, BUFLEN * 2 * sizeof(int16_t), FREQ);
-            alBufferData(buffers_music[c], AL_FORMAT_STEREO16, music_buf_int16, MUSICBUFLEN * 2 * sizeof(int16_t), MUSIC_FREQ);
-            alBufferData(buffers_wt[c], AL_FORMAT_STEREO16, wt_buf_int16, WTBUFLEN * 2 * sizeof(int16_t), WT_FREQ);
-            alBufferData(buffers_cd[c], AL_FORMAT_STEREO16, cd_buf_int16, CD_BUFLEN * 2 * sizeof(int16_t), CD_FREQ);
             if (init_midi)
                 alBufferData(buffers_midi[c], AL_FORMAT_STEREO16, midi_buf_int16, midi_buf_size * (int) sizeof(int16_t), midi_freq);
         }
     }
 
     alSourceQueueBuffers(source[0], 4, buffers);
-    alSourceQueueBuffers(source[1], 4, buffers_music);
-    alSourceQueueBuffers(source[2], 4, buffers_wt);
-    alSourceQueueBuffers(source[3], 4, buffers_cd);
     if (init_midi)
-        alSourceQueueBuffers(source[4], 4, buffers_midi);
+        alSourceQueueBuffers(source[1], 4, buffers_midi);
     alSourcePlay(source[0]);
-    alSourcePlay(source[1]);
-    alSourcePlay(source[2]);
-    alSourcePlay(source[3]);
     if (init_midi)
-        alSourcePlay(source[4]);
+        alSourcePlay(source[1]);
 
     if (sound_is_float) {
         if (init_midi)
             free(midi_buf);
-        free(cd_buf);
-        free(wt_buf);
-        free(music_buf);
         free(buf);
     } else {
         if (init_midi)
             free(midi_buf_int16);
-        free(cd_buf_int16);
-        free(wt_buf_int16);
-        free(music_buf_int16);
         free(buf_int16);
     }
 
@@ -298,26 +236,8 @@ givealbuffer(const void *buf)
     givealbuffer_common(buf, 0, BUFLEN << 1, FREQ);
 }
 
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, 1, MUSICBUFLEN << 1, MUSIC_FREQ);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, 2, WTBUFLEN << 1, WT_FREQ);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    givealbuffer_common(buf, 3, CD_BUFLEN << 1, CD_FREQ);
-}
-
 void
 givealbuffer_midi(const void *buf, const uint32_t size)
 {
-    givealbuffer_common(buf, 4, (int) size, midi_freq);
+    givealbuffer_common(buf, 1, (int) size, midi_freq);
 }
@@ -18,6 +18,7 @@
  */
 #include <math.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,6 +37,22 @@
 #include <86box/timer.h>
 #include <86box/snd_mpu401.h>
 #include <86box/sound.h>
+#include <86box/video.h>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#    include <xmmintrin.h>
+#    define RESAMPLE_SSE
+#endif
+
+/* The music, wavetable and CD audio paths run at their own rates and are
+   brought to SOUND_FREQ by a polyphase windowed sinc filter; the phase is
+   linearly interpolated between the table entries. */
+#define RESAMPLE_TAPS       16
+#define RESAMPLE_PHASE_BITS 8
+#define RESAMPLE_PHASES     (1 << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_MAX_IN     CD_BUFLEN
+
+#define MIX_RING_LEN  16384
+#define MIX_RING_MASK (MIX_RING_LEN - 1)
 
 typedef struct {
     const device_t *device;
@@ -46,6 +63,22 @@ typedef struct {
     void *priv;
 } sound_handler_t;
 
+/* A source mixed into the main output stream. The resampler state is only
+   touched by the producer; the ring is single producer, single consumer,
+   with sound_poll() as the consumer. */
+typedef struct mix_source_t {
+    uint64_t    step; /* Input frames per output frame, 32.32 fixed point. */
+    uint64_t    pos;  /* Position of the next output frame in hist, 32.32. */
+    int         hist_len;
+    int         prime_len;
+    int         primed;
+    float       coeffs[RESAMPLE_PHASES + 1][RESAMPLE_TAPS];
+    float       hist[2][RESAMPLE_TAPS + RESAMPLE_MAX_IN];
+    float       ring[MIX_RING_LEN * 2];
+    atomic_uint ring_wr;
+    atomic_uint ring_rd;
+} mix_source_t;
+
 int sound_card_current[SOUND_CARD_MAX] = { 0, 0, 0, 0 };
 int sound_pos_global                   = 0;
 int music_pos_global                   = 0;
@@ -66,11 +99,9 @@ static int32_t   *outbuffer;
 static float     *outbuffer_ex;
 static int16_t   *outbuffer_ex_int16;
 static int32_t   *outbuffer_m;
-static float     *outbuffer_m_ex;
-static int16_t   *outbuffer_m_ex_int16;
+static float      outbuffer_m_ex[MUSICBUFLEN * 2];
 static int32_t   *outbuffer_w;
-static float     *outbuffer_w_ex;
-static int16_t   *outbuffer_w_ex_int16;
+static float      outbuffer_w_ex[WTBUFLEN * 2];
 static int        sound_handlers_num;
 static int        music_handlers_num;
 static int        wavetable_handlers_num;
@@ -83,13 +114,16 @@ static uint64_t   wavetable_poll_latch;
 
 static int16_t      cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
 static float        cd_out_buffer[CD_BUFLEN * 2];
-static int16_t      cd_out_buffer_int16[CD_BUFLEN * 2];
 static unsigned int cd_vol_l;
 static unsigned int cd_vol_r;
 static int          cd_buf_update    = CD_BUFLEN / SOUNDBUFLEN;
 static volatile int cdaudioon        = 0;
 static int          cd_thread_enable = 0;
 
+static mix_source_t music_source;
+static mix_source_t wavetable_source;
+static mix_source_t cd_source;
+
 static void (*filter_cd_audio)(int channel, double *buffer, void *priv) = NULL;
 static void *filter_cd_audio_p                                          = NULL;
 
@@ -226,6 +260,171 @@ sound_card_init(void)
             device_add_inst(sound_cards[sound_card_current[i]].device, i + 1);
 }
 
+static void
+mix_source_reset(mix_source_t *src)
+{
+    memset(src->hist, 0x00, sizeof(src->hist));
+
+    /* Start with a full window of silence so the first output frame lines
+       up with the first input frame. */
+    src->hist_len = RESAMPLE_TAPS - 1;
+    src->pos      = 0;
+    src->primed   = 0;
+
+    atomic_store(&src->ring_wr, 0);
+    atomic_store(&src->ring_rd, 0);
+}
+
+static void
+mix_source_init(mix_source_t *src, int in_freq, int in_len)
+{
+    double cutoff = 0.5 * 0.95;
+    double taps[RESAMPLE_TAPS];
+
+    /* When decimating, move the cutoff below the output Nyquist frequency. */
+    if (in_freq > SOUND_FREQ)
+        cutoff *= (double) SOUND_FREQ / (double) in_freq;
+
+    for (int p = 0; p <= RESAMPLE_PHASES; p++) {
+        double sum = 0.0;
+
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            const double x = (double) (k - ((RESAMPLE_TAPS / 2) - 1)) - ((double) p / (double) RESAMPLE_PHASES);
+            const double w = 0.42 + (0.5 * cos((M_PI * x) / (RESAMPLE_TAPS / 2))) +
+                             (0.08 * cos((2.0 * M_PI * x) / (RESAMPLE_TAPS / 2)));
+
+            if (x == 0.0)
+                taps[k] = 2.0 * cutoff;
+            else
+                taps[k] = (sin(2.0 * M_PI * cutoff * x) / (M_PI * x)) * w;
+            sum += taps[k];
+        }
+
+        /* Normalize every phase to unity gain at DC. */
+        for (int k = 0; k < RESAMPLE_TAPS; k++)
+            src->coeffs[p][k] = (float) (taps[k] / sum);
+    }
+
+    src->step = ((uint64_t) in_freq << 32) / SOUND_FREQ;
+
+    /* Hold back one producer block plus one output buffer before playing,
+       so that the producer's burst granularity does not cause underruns. */
+    src->prime_len = ((in_len * SOUND_FREQ) / in_freq) + 1 + SOUNDBUFLEN;
+
+    mix_source_reset(src);
+}
+
+static inline float
+resample_dot(const float *x, const float *c)
+{
+#ifdef RESAMPLE_SSE
+    __m128 acc = _mm_mul_ps(_mm_loadu_ps(x), _mm_loadu_ps(c));
+
+    for (int k = 4; k < RESAMPLE_TAPS; k += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(c + k)));
+
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+    return _mm_cvtss_f32(acc);
+#else
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (int k = 0; k < RESAMPLE_TAPS; k += 4) {
+        acc[0] += x[k] * c[k];
+        acc[1] += x[k + 1] * c[k + 1];
+        acc[2] += x[k + 2] * c[k + 2];
+        acc[3] += x[k + 3] * c[k + 3];
+    }
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+/* Resample a block of interleaved stereo frames and queue it for mixing. */
+static void
+mix_source_write(mix_source_t *src, const float *buf, int len)
+{
+    unsigned int wr = atomic_load_explicit(&src->ring_wr, memory_order_relaxed);
+    unsigned int rd = atomic_load_explicit(&src->ring_rd, memory_order_acquire);
+    float        coeffs[RESAMPLE_TAPS];
+    int          used;
+
+    for (int c = 0; c < len; c++) {
+        src->hist[0][src->hist_len + c] = buf[c << 1];
+        src->hist[1][src->hist_len + c] = buf[(c << 1) + 1];
+    }
+    src->hist_len += len;
+
+    while ((int) (src->pos >> 32) + RESAMPLE_TAPS <= src->hist_len) {
+        const int      i     = (int) (src->pos >> 32);
+        const uint32_t frac  = (uint32_t) src->pos;
+        const int      phase = (int) (frac >> (32 - RESAMPLE_PHASE_BITS));
+        const float    f     = (float) (frac & ((1U << (32 - RESAMPLE_PHASE_BITS)) - 1)) /
+                               (float) (1U << (32 - RESAMPLE_PHASE_BITS));
+        const float   *c0    = src->coeffs[phase];
+        const float   *c1    = src->coeffs[phase + 1];
+
+        for (int k = 0; k < RESAMPLE_TAPS; k++)
+            coeffs[k] = c0[k] + ((c1[k] - c0[k]) * f);
+
+        /* A full ring means the consumer has stopped; drop the frame. */
+        if ((wr - rd) < MIX_RING_LEN) {
+            src->ring[(wr & MIX_RING_MASK) << 1]       = resample_dot(&src->hist[0][i], coeffs);
+            src->ring[((wr & MIX_RING_MASK) << 1) + 1] = resample_dot(&src->hist[1][i], coeffs);
+            wr++;
+        }
+
+        src->pos += src->step;
+    }
+
+    atomic_store_explicit(&src->ring_wr, wr, memory_order_release);
+
+    /* Keep only the input frames the next output frame still needs. */
+    used = (int) (src->pos >> 32);
+    src->hist_len -= used;
+    memmove(src->hist[0], &src->hist[0][used], src->hist_len * sizeof(float));
+    memmove(src->hist[1], &src->hist[1][used], src->hist_len * sizeof(float));
+    src->pos -= ((uint64_t) used) << 32;
+}
+
+/* Add up to len queued frames of a source to the output buffer. */
+static void
+mix_source_read(mix_source_t *src, int32_t *buffer, int len)
+{
+    unsigned int       rd    = atomic_load_explicit(&src->ring_rd, memory_order_relaxed);
+    const unsigned int wr    = atomic_load_explicit(&src->ring_wr, memory_order_acquire);
+    unsigned int       avail = wr - rd;
+
+    if (!src->primed) {
+        if (avail < (unsigned int) src->prime_len)
+            return;
+        src->primed = 1;
+    }
+
+    /* Do not let the latency grow without bound if the consumer fell
+       behind, e.g. while the emulation was paused. */
+    if (avail > (MIX_RING_LEN / 2)) {
+        rd    = wr - src->prime_len;
+        avail = src->prime_len;
+    }
+
+    if (avail < (unsigned int) len) {
+        /* Underrun, play what is left and build up the cushion again. */
+        len         = (int) avail;
+        src->primed = 0;
+    }
+
+    for (int c = 0; c < len; c++) {
+        const unsigned int idx = ((rd + c) & MIX_RING_MASK) << 1;
+
+        buffer[c << 1]       += (int32_t) lrintf(src->ring[idx]);
+        buffer[(c << 1) + 1] += (int32_t) lrintf(src->ring[idx + 1]);
+    }
+
+    atomic_store_explicit(&src->ring_rd, rd + len, memory_order_release);
+}
+
 void
 sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r)
 {
@@ -236,16 +435,12 @@ sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r)
 static void
 sound_cd_clean_buffers(void)
 {
-    if (sound_is_float)
-        memset(cd_out_buffer, 0, (CD_BUFLEN * 2) * sizeof(float));
-    else
-        memset(cd_out_buffer_int16, 0, (CD_BUFLEN * 2) * sizeof(int16_t));
+    memset(cd_out_buffer, 0, (CD_BUFLEN * 2) * sizeof(float));
 }
 
 static void
 sound_cd_thread(UNUSED(void *param))
 {
-    int      temp_buffer[2];
     int      channel_select[2];
     double   audio_vol_l;
     double   audio_vol_r;
@@ -262,8 +457,6 @@ sound_cd_thread(UNUSED(void *param))
 
         sound_cd_clean_buffers();
 
-        temp_buffer[0] = temp_buffer[1] = 0;
-
         for (uint8_t i = 0; i < CDROM_NUM; i++) {
             if ((cdrom[i].bus_type == CDROM_BUS_DISABLED) || (cdrom[i].cd_status == CD_STATUS_EMPTY))
                 continue;
@@ -324,32 +517,12 @@ sound_cd_thread(UNUSED(void *param))
                     filter_cd_audio(1, &(cd_buffer_temp[1]), filter_cd_audio_p);
                 }
 
-                if (sound_is_float) {
-                    cd_out_buffer[c] += (float) (cd_buffer_temp[0] / 32768.0);
-                    cd_out_buffer[c + 1] += (float) (cd_buffer_temp[1] / 32768.0);
-                } else {
-                    temp_buffer[0] += (int) trunc(cd_buffer_temp[0]);
-                    temp_buffer[1] += (int) trunc(cd_buffer_temp[1]);
-
-                    if (temp_buffer[0] > 32767)
-                        temp_buffer[0] = 32767;
-                    if (temp_buffer[0] < -32768)
-                        temp_buffer[0] = -32768;
-                    if (temp_buffer[1] > 32767)
-                        temp_buffer[1] = 32767;
-                    if (temp_buffer[1] < -32768)
-                        temp_buffer[1] = -32768;
-
-                    cd_out_buffer_int16[c]     = (int16_t) temp_buffer[0];
-                    cd_out_buffer_int16[c + 1] = (int16_t) temp_buffer[1];
-                }
+                cd_out_buffer[c] += (float) cd_buffer_temp[0];
+                cd_out_buffer[c + 1] += (float) cd_buffer_temp[1];
             }
         }
 
-        if (sound_is_float)
-            givealbuffer_cd(cd_out_buffer);
-        else
-            givealbuffer_cd(cd_out_buffer_int16);
+        mix_source_write(&cd_source, cd_out_buffer, CD_BUFLEN);
     }
 }
 
@@ -375,50 +548,6 @@ sound_realloc_buffers(void)
     }
 }
 
-static void
-music_realloc_buffers(void)
-{
-    if (outbuffer_m_ex != NULL) {
-        free(outbuffer_m_ex);
-        outbuffer_m_ex = NULL;
-    }
-
-    if (outbuffer_m_ex_int16 != NULL) {
-        free(outbuffer_m_ex_int16);
-        outbuffer_m_ex_int16 = NULL;
-    }
-
-    if (sound_is_float) {
-        outbuffer_m_ex = calloc(MUSICBUFLEN * 2, sizeof(float));
-        memset(outbuffer_m_ex, 0x00, MUSICBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_m_ex_int16 = calloc(MUSICBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_m_ex_int16, 0x00, MUSICBUFLEN * 2 * sizeof(int16_t));
-    }
-}
-
-static void
-wavetable_realloc_buffers(void)
-{
-    if (outbuffer_w_ex != NULL) {
-        free(outbuffer_w_ex);
-        outbuffer_w_ex = NULL;
-    }
-
-    if (outbuffer_w_ex_int16 != NULL) {
-        free(outbuffer_w_ex_int16);
-        outbuffer_w_ex_int16 = NULL;
-    }
-
-    if (sound_is_float) {
-        outbuffer_w_ex = calloc(WTBUFLEN * 2, sizeof(float));
-        memset(outbuffer_w_ex, 0x00, WTBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_w_ex_int16 = calloc(WTBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_w_ex_int16, 0x00, WTBUFLEN * 2 * sizeof(int16_t));
-    }
-}
-
 void
 sound_init(void)
 {
@@ -427,12 +556,6 @@ sound_init(void)
     outbuffer_ex       = NULL;
     outbuffer_ex_int16 = NULL;
 
-    outbuffer_m_ex       = NULL;
-    outbuffer_m_ex_int16 = NULL;
-
-    outbuffer_w_ex       = NULL;
-    outbuffer_w_ex_int16 = NULL;
-
     outbuffer = NULL;
     outbuffer = calloc(SOUNDBUFLEN * 2, sizeof(int32_t));
     memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
@@ -458,6 +581,10 @@ sound_init(void)
         cd_audio_volume_lut[i] = di;
     }
 
+    mix_source_init(&music_source, MUSIC_FREQ, MUSICBUFLEN);
+    mix_source_init(&wavetable_source, WT_FREQ, WTBUFLEN);
+    mix_source_init(&cd_source, CD_FREQ, CD_BUFLEN);
+
     for (uint8_t i = 0; i < CDROM_NUM; i++) {
         if (cdrom[i].bus_type != CDROM_BUS_DISABLED)
             available_cdrom_drives++;
@@ -468,6 +595,8 @@ sound_init(void)
 
         sound_cd_start_event = thread_create_event();
 
+        mix_source_reset(&cd_source);
+
         sound_cd_event    = thread_create_event();
         sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
 
@@ -539,6 +668,13 @@ sound_poll(UNUSED(void *priv))
         for (c = 0; c < sound_handlers_num; c++)
             sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
 
+        mix_source_read(&music_source, outbuffer, SOUNDBUFLEN);
+        mix_source_read(&wavetable_source, outbuffer, SOUNDBUFLEN);
+        if (cd_thread_enable)
+            mix_source_read(&cd_source, outbuffer, SOUNDBUFLEN);
+
+        video_capture_audio(outbuffer, SOUNDBUFLEN);
+
         for (c = 0; c < SOUNDBUFLEN * 2; c++) {
             if (sound_is_float)
                 outbuffer_ex[c] = ((float) outbuffer[c]) / (float) 32768.0;
@@ -583,23 +719,10 @@ music_poll(UNUSED(void *priv))
         for (c = 0; c < music_handlers_num; c++)
             music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
 
-        for (c = 0; c < MUSICBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_m_ex[c] = ((float) outbuffer_m[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_m[c] > 32767)
-                    outbuffer_m[c] = 32767;
-                if (outbuffer_m[c] < -32768)
-                    outbuffer_m[c] = -32768;
-
-                outbuffer_m_ex_int16[c] = (int16_t) outbuffer_m[c];
-            }
-        }
+        for (c = 0; c < MUSICBUFLEN * 2; c++)
+            outbuffer_m_ex[c] = (float) outbuffer_m[c];
 
-        if (sound_is_float)
-            givealbuffer_music(outbuffer_m_ex);
-        else
-            givealbuffer_music(outbuffer_m_ex_int16);
+        mix_source_write(&music_source, outbuffer_m_ex, MUSICBUFLEN);
 
         music_pos_global = 0;
     }
@@ -619,23 +742,10 @@ wavetable_poll(UNUSED(void *priv))
         for (c = 0; c < wavetable_handlers_num; c++)
             wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
 
-        for (c = 0; c < WTBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_w_ex[c] = ((float) outbuffer_w[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_w[c] > 32767)
-                    outbuffer_w[c] = 32767;
-                if (outbuffer_w[c] < -32768)
-                    outbuffer_w[c] = -32768;
+        for (c = 0; c < WTBUFLEN * 2; c++)
+            outbuffer_w_ex[c] = (float) outbuffer_w[c];
 
-                outbuffer_w_ex_int16[c] = (int16_t) outbuffer_w[c];
-            }
-        }
-
-        if (sound_is_float)
-            givealbuffer_wt(outbuffer_w_ex);
-        else
-            givealbuffer_wt(outbuffer_w_ex_int16);
+        mix_source_write(&wavetable_source, outbuffer_w_ex, WTBUFLEN);
 
         wavetable_pos_global = 0;
     }
@@ -656,9 +766,8 @@ sound_reset(void)
 {
     sound_realloc_buffers();
 
-    music_realloc_buffers();
-
-    wavetable_realloc_buffers();
+    mix_source_reset(&music_source);
+    mix_source_reset(&wavetable_source);
 
     midi_out_device_init();
     midi_in_device_init();
@@ -743,6 +852,8 @@ sound_cd_thread_reset(void)
 
         sound_cd_start_event = thread_create_event();
 
+        mix_source_reset(&cd_source);
+
         sound_cd_event    = thread_create_event();
         sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
 
@@ -1,27 +1,160 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include <86box/timer.h>
+#ifdef ENABLE_TIMER_TRACE
+#    include <86box/path.h>
+#    include <86box/plat.h>
+#endif
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+/*Enabled timers are stored in a binary min-heap, with the first timer to expire
+  at the root. The heap is a contiguous array of (timestamp, timer) entries so
+  re-arming a timer is O(log n) and sifting does not have to chase pointers.
+  Timers with the same timestamp expire in reverse order of being enabled, as
+  they did with the old sorted list.*/
+typedef struct timer_entry_t {
+    uint64_t    ts;
+    pc_timer_t *timer;
+} timer_entry_t;
+
+static timer_entry_t *timer_heap       = NULL;
+static uint32_t       timer_heap_count = 0;
+static uint32_t       timer_heap_size  = 0;
+static uint32_t       timer_seq        = 0;
 
 /* Are we initialized? */
 int timer_inited = 0;
 
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+#ifdef ENABLE_TIMER_TRACE
+static FILE        *timer_trace_fp    = NULL;
+static pc_timer_t **timer_trace_ids   = NULL;
+static uint32_t     timer_trace_count = 0;
+static uint32_t     timer_trace_size  = 0;
+
+static void
+timer_trace(uint32_t op, pc_timer_t *timer, uint64_t ts)
+{
+    timer_trace_t rec;
+    uint32_t      id = 0;
+
+    if (timer_trace_fp == NULL)
+        return;
+
+    if (timer != NULL) {
+        /* Only used for tracing, so a linear search is good enough. */
+        for (id = 0; id < timer_trace_count; id++) {
+            if (timer_trace_ids[id] == timer)
+                break;
+        }
+        if (id == timer_trace_count) {
+            if (timer_trace_count == timer_trace_size) {
+                timer_trace_size = timer_trace_size ? (timer_trace_size << 1) : 64;
+                timer_trace_ids  = (pc_timer_t **) realloc(timer_trace_ids, timer_trace_size * sizeof(pc_timer_t *));
+                if (timer_trace_ids == NULL)
+                    fatal("timer_trace - out of memory\n");
+            }
+            timer_trace_ids[timer_trace_count++] = timer;
+        }
+    }
+
+    rec.op = op;
+    rec.id = id;
+    rec.ts = ts;
+    fwrite(&rec, sizeof(rec), 1, timer_trace_fp);
+}
+#else
+#    define timer_trace(op, timer, ts)
+#endif
+
+/*True if heap entry a expires before heap entry b*/
+static __inline int
+timer_entry_before(const timer_entry_t *a, const timer_entry_t *b)
+{
+    int64_t diff = (int64_t) (a->ts - b->ts);
+
+    if (diff != 0)
+        return diff < 0;
+
+    return (int32_t) (a->timer->seq - b->timer->seq) > 0;
+}
+
+static __inline void
+timer_heap_set(uint32_t idx, timer_entry_t entry)
+{
+    timer_heap[idx]       = entry;
+    entry.timer->heap_idx = idx;
+}
+
+static void
+timer_heap_sift_up(uint32_t idx)
+{
+    timer_entry_t entry = timer_heap[idx];
+
+    while (idx > 0) {
+        uint32_t parent = (idx - 1) >> 1;
+
+        if (!timer_entry_before(&entry, &timer_heap[parent]))
+            break;
+
+        timer_heap_set(idx, timer_heap[parent]);
+        idx = parent;
+    }
+
+    timer_heap_set(idx, entry);
+}
+
+static void
+timer_heap_sift_down(uint32_t idx)
+{
+    timer_entry_t entry = timer_heap[idx];
+
+    while (1) {
+        uint32_t child = (idx << 1) + 1;
+
+        if (child >= timer_heap_count)
+            break;
+
+        if (((child + 1) < timer_heap_count) && timer_entry_before(&timer_heap[child + 1], &timer_heap[child]))
+            child++;
+
+        if (!timer_entry_before(&timer_heap[child], &entry))
+            break;
+
+        timer_heap_set(idx, timer_heap[child]);
+        idx = child;
+    }
+
+    timer_heap_set(idx, entry);
+}
+
+static void
+timer_heap_remove(uint32_t idx)
+{
+    timer_heap_count--;
+
+    if (idx == timer_heap_count)
+        return;
+
+    timer_heap_set(idx, timer_heap[timer_heap_count]);
+
+    if ((idx > 0) && timer_entry_before(&timer_heap[idx], &timer_heap[(idx - 1) >> 1]))
+        timer_heap_sift_up(idx);
+    else
+        timer_heap_sift_down(idx);
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
+    timer_entry_t *heap;
 
     if (!timer_inited || (timer == NULL))
         return;
@@ -29,59 +162,25 @@ timer_enable(pc_timer_t *timer)
     if (timer->flags & TIMER_ENABLED)
         timer_disable(timer);
 
-    if (timer->next || timer->prev)
-        fatal("timer_enable - timer->next\n");
-
-    /*List currently empty - add to head*/
-    if (!timer_head) {
-        timer_head  = timer;
-        timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
-        timer->next      = timer_head;
-        timer->prev      = NULL;
-        timer_head->prev = timer;
-        timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
+    if (timer_heap_count == timer_heap_size) {
+        heap = (timer_entry_t *) realloc(timer_heap, (timer_heap_size ? (timer_heap_size << 1) : 64) * sizeof(timer_entry_t));
+        if (heap == NULL)
+            fatal("timer_enable - out of memory\n");
+
+        timer_heap      = heap;
+        timer_heap_size = timer_heap_size ? (timer_heap_size << 1) : 64;
     }
 
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
+    timer_trace(TIMER_TRACE_ENABLE, timer, timer->ts.ts64);
 
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
+    timer->seq                         = ++timer_seq;
+    timer_heap[timer_heap_count].ts    = timer->ts.ts64;
+    timer_heap[timer_heap_count].timer = timer;
+    timer_heap_sift_up(timer_heap_count++);
 
-            prev       = timer_node;
-            timer_node = timer_node->next;
-        }
-    }
+    timer->flags |= TIMER_ENABLED;
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
-        timer->flags |= TIMER_ENABLED;
+    timer_target = timer_heap[0].timer->ts.ts32.integer;
 }
 
 void
@@ -90,19 +189,18 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
-        fatal("timer_disable - !timer->next\n");
+    if ((timer->heap_idx >= timer_heap_count) || (timer_heap[timer->heap_idx].timer != timer))
+        fatal("timer_disable - timer not queued\n");
+
+    timer_trace(TIMER_TRACE_DISABLE, timer, 0);
 
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
-    else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+    timer_heap_remove(timer->heap_idx);
+
+    if (timer_heap_count)
+        timer_target = timer_heap[0].timer->ts.ts32.integer;
 }
 
 void
@@ -110,20 +208,15 @@ timer_process(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_head)
-        return;
+    timer_trace(TIMER_TRACE_PROCESS, NULL, tsc);
 
-    while (1) {
-        timer = timer_head;
+    while (timer_heap_count) {
+        timer = timer_heap[0].timer;
 
         if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
             break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
-
-        timer->next = timer->prev = NULL;
+        timer_heap_remove(0);
         timer->flags &= ~TIMER_ENABLED;
 
         if (timer->flags & TIMER_SPLIT)
@@ -139,25 +232,32 @@ timer_process(void)
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    if (timer_heap_count)
+        timer_target = timer_heap[0].timer->ts.ts32.integer;
 }
 
 void
 timer_close(void)
 {
-    pc_timer_t *t = timer_head;
-    pc_timer_t *r;
-
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-        r       = t;
-        r->prev = r->next = NULL;
-        t                 = r->next;
-    }
-
-    timer_head = NULL;
+    /* Mark all queued timers as disabled so that timers that are not in
+       malloc'd structs are not taken for queued ones after a reset. */
+    for (uint32_t i = 0; i < timer_heap_count; i++)
+        timer_heap[i].timer->flags &= ~TIMER_ENABLED;
+
+    free(timer_heap);
+    timer_heap       = NULL;
+    timer_heap_count = 0;
+    timer_heap_size  = 0;
+
+#ifdef ENABLE_TIMER_TRACE
+    if (timer_trace_fp != NULL)
+        fclose(timer_trace_fp);
+    timer_trace_fp = NULL;
+    free(timer_trace_ids);
+    timer_trace_ids   = NULL;
+    timer_trace_count = 0;
+    timer_trace_size  = 0;
+#endif
 
     timer_inited = 0;
 }
@@ -165,9 +265,19 @@ timer_close(void)
 void
 timer_init(void)
 {
+#ifdef ENABLE_TIMER_TRACE
+    char fn[1024];
+#endif
+
     timer_target = 0ULL;
     tsc          = 0;
 
+#ifdef ENABLE_TIMER_TRACE
+    /* Each hard reset starts a new trace. */
+    path_append_filename(fn, usr_path, "timer_trace.bin");
+    timer_trace_fp = plat_fopen(fn, "wb");
+#endif
+
     timer_inited = 1;
 }
 
@@ -180,7 +290,6 @@ timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start
     timer->in_callback = 0;
     timer->priv        = priv;
     timer->flags       = 0;
-    timer->prev        = timer->next = NULL;
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
@@ -264,19 +373,22 @@ timer_set_new_tsc(uint64_t new_tsc)
         update_tsc();
 #endif
 
-    if (!timer_head) {
+    timer_trace(TIMER_TRACE_NEW_TSC, NULL, new_tsc);
+
+    if (!timer_heap_count) {
         tsc = new_tsc;
         return;
     }
 
-    timer = timer_head;
-    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_head) - (uint32_t)tsc);
+    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_heap[0].timer) - (uint32_t)tsc);
+
+    /* Every timer moves by the same amount, so the heap order is kept. */
+    for (uint32_t i = 0; i < timer_heap_count; i++) {
+        timer = timer_heap[i].timer;
 
-    while (timer) {
         int32_t offset_from_current_tsc = (int32_t)(timer_get_ts_int(timer) - (uint32_t)tsc);
         timer->ts.ts32.integer = new_tsc + offset_from_current_tsc;
-
-        timer = timer->next;
+        timer_heap[i].ts       = timer->ts.ts64;
     }
 
     tsc = new_tsc;
@@ -450,6 +450,12 @@ plat_get_ticks(void)
     return (uint32_t) (plat_get_ticks_common() / 1000);
 }
 
+uint64_t
+plat_get_micro_ticks(void)
+{
+    return plat_get_ticks_common();
+}
+
 void
 plat_remove(char *path)
 {
@@ -551,6 +557,10 @@ main_thread(void *param)
             drawits = 10;
         else
 #endif
+        /* Batch mode runs unthrottled, emulated time is not tied to the host clock. */
+        if (batch_mode)
+            drawits = 10;
+        else
             drawits += (new_time - old_time);
         old_time = new_time;
         if (drawits > 0 && !dopause) {
@@ -568,11 +578,16 @@ main_thread(void *param)
                 nvr_dosave = 0;
                 frames     = 0;
             }
-        } else /* Just so we dont overload the host OS. */
+        } else {
+            /* Take or restore a snapshot requested while paused. */
+            pc_snapshot_poll();
+
+            /* Just so we dont overload the host OS. */
             SDL_Delay(1);
+        }
 
         /* If needed, handle a screen resize. */
-        if (atomic_load(&doresize_monitors[0]) && !video_fullscreen && !is_quit) {
+        if (atomic_load(&doresize_monitors[0]) && !video_fullscreen && !is_quit && !batch_mode) {
             if (vid_resize & 2)
                 plat_resize(fixed_size_x, fixed_size_y, 0);
             else
@@ -1209,11 +1224,13 @@ main(int argc, char **argv)
     } else
         fprintf(stderr, "libedit not found, line editing will be limited.\n");
     mousemutex = SDL_CreateMutex();
-    sdl_initho();
+    if (!batch_mode) {
+        sdl_initho();
 
-    if (start_in_fullscreen) {
-        video_fullscreen = 1;
-        sdl_set_fs(1);
+        if (start_in_fullscreen) {
+            video_fullscreen = 1;
+            sdl_set_fs(1);
+        }
     }
     /* Fire up the machine. */
     pc_reset_hard_init();
@@ -1224,6 +1241,18 @@ main(int argc, char **argv)
     /* Initialize the rendering window, or fullscreen. */
 
     do_start();
+
+    if (batch_mode) {
+        /* No window and no monitor, just wait for the machine to power off. */
+        thread_wait(thMain);
+        pc_close(thMain);
+        thMain = NULL;
+
+        SDL_DestroyMutex(blitmtx);
+        SDL_DestroyMutex(mousemutex);
+        SDL_Quit();
+        return batch_exit_code;
+    }
 #ifndef USE_CLI
     thread_create(monitor_thread, NULL);
 #endif
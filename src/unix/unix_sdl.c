@@ -34,6 +34,8 @@ extern int             blitreq;
 SDL_Window         *sdl_win     = NULL;
 SDL_Renderer       *sdl_render  = NULL;
 static SDL_Texture *sdl_tex     = NULL;
+static int          sdl_tex_w   = 0;
+static int          sdl_tex_h   = 0;
 int                 sdl_w       = SCREEN_RES_X;
 int                 sdl_h       = SCREEN_RES_Y;
 static int          sdl_fs;
@@ -51,7 +53,7 @@ int                 title_set         = 0;
 int                 resize_pending    = 0;
 int                 resize_w          = 0;
 int                 resize_h          = 0;
-static void        *pixeldata;
+static bitmap_t    *sdl_frame = NULL; /* held until sdl_blit() uploads it */
 
 extern void RenderImGui(void);
 static void
@@ -146,18 +148,38 @@ sdl_stretch(int *w, int *h, int *x, int *y)
 void
 sdl_blit_shim(int x, int y, int w, int h, int monitor_index)
 {
-    params.x = x;
-    params.y = y;
-    params.w = w;
-    params.h = h;
+    const bitmap_t *target = monitors[monitor_index].target_buffer;
+    bitmap_t       *frame  = NULL;
 
-    if (!(!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) || (monitor_index >= 1))
-        for (int row = 0; row < h; ++row)
-            video_copy(&(((uint8_t *) pixeldata)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    if (monitors[monitor_index].mon_screenshots && (target != NULL))
+        video_screenshot_monitor(target->dat, x, y, target->w, monitor_index);
 
-    if (monitors[monitor_index].mon_screenshots)
-        video_screenshot((uint32_t *) pixeldata, 0, 0, 2048);
-    blitreq = 1;
+    /* Only the first monitor is shown. */
+    if (monitor_index != 0) {
+        video_blit_complete_monitor(monitor_index);
+        return;
+    }
+
+    /* The texture is updated straight from the frame on the main thread;
+       while it still holds the previous one, this one is dropped. */
+    if (sdl_enabled && (x >= 0) && (y >= 0) && (w > 0) && (h > 0) && (buffer32 != NULL) && (sdl_render != NULL) && (sdl_tex != NULL)) {
+        frame = video_frame_acquire_monitor(monitor_index);
+        if (frame == NULL) {
+            video_blit_complete_monitor(monitor_index);
+            return;
+        }
+    }
+
+    SDL_LockMutex(sdl_mutex);
+    if (sdl_frame != NULL)
+        video_frame_release_monitor(monitor_index);
+    sdl_frame = frame;
+    params.x  = x;
+    params.y  = y;
+    params.w  = w;
+    params.h  = h;
+    blitreq   = 1;
+    SDL_UnlockMutex(sdl_mutex);
 
     video_blit_complete_monitor(monitor_index);
 }
@@ -197,12 +219,16 @@ sdl_blit(int x, int y, int w, int h)
 {
     SDL_Rect r_src;
 
-    if (!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) {
+    if (!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL) || (sdl_frame == NULL)) {
         r_src.x = x;
         r_src.y = y;
         r_src.w = w;
         r_src.h = h;
         sdl_real_blit(&r_src);
+        if (sdl_frame != NULL) {
+            sdl_frame = NULL;
+            video_frame_release_monitor(0);
+        }
         blitreq = 0;
         return;
     }
@@ -214,11 +240,24 @@ sdl_blit(int x, int y, int w, int h)
             sdl_resize(resize_w, resize_h);
         resize_pending = 0;
     }
+    if (((x + w) > sdl_tex_w) || ((y + h) > sdl_tex_h)) {
+        if ((x + w) > sdl_tex_w)
+            sdl_tex_w = x + w;
+        if ((y + h) > sdl_tex_h)
+            sdl_tex_h = y + h;
+        SDL_DestroyTexture(sdl_tex);
+        sdl_tex = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, sdl_tex_w, sdl_tex_h);
+    }
+
     r_src.x = x;
     r_src.y = y;
     r_src.w = w;
     r_src.h = h;
-    SDL_UpdateTexture(sdl_tex, &r_src, pixeldata, 2048 * 4);
+    if (sdl_tex != NULL)
+        SDL_UpdateTexture(sdl_tex, &r_src, &sdl_frame->line[y][x], sdl_frame->w * sizeof(uint32_t));
+    sdl_frame = NULL;
+    video_frame_release_monitor(0);
     blitreq = 0;
 
     sdl_real_blit(&r_src);
@@ -262,6 +301,11 @@ sdl_close(void)
     if (sdl_enabled)
         sdl_enabled = 0;
 
+    if (sdl_frame != NULL) {
+        sdl_frame = NULL;
+        video_frame_release_monitor(0);
+    }
+
     if (sdl_mutex != NULL) {
         SDL_DestroyMutex(sdl_mutex);
         sdl_mutex = NULL;
@@ -270,11 +314,6 @@ sdl_close(void)
     sdl_destroy_texture();
     sdl_destroy_window();
 
-    if (pixeldata != NULL) {
-        free(pixeldata);
-        pixeldata = NULL;
-    }
-
     /* Quit. */
     SDL_Quit();
     sdl_flags = -1;
@@ -322,8 +361,11 @@ sdl_reinit_texture(void)
     } else
         sdl_render = SDL_CreateRenderer(sdl_win, -1, SDL_RENDERER_SOFTWARE);
 
-    sdl_tex = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
-                                SDL_TEXTUREACCESS_STREAMING, 2048, 2048);
+    /* sdl_blit() grows the texture when a frame does not fit. */
+    sdl_tex_w = 640;
+    sdl_tex_h = 480;
+    sdl_tex   = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
+                                  SDL_TEXTUREACCESS_STREAMING, sdl_tex_w, sdl_tex_h);
 }
 
 void
@@ -435,8 +477,6 @@ sdl_init_common(int flags)
     /* Make sure we get a clean exit. */
     atexit(sdl_close);
 
-    pixeldata = malloc(2048 * 2048 * 4);
-
     /* Register our renderer! */
     video_setblit(sdl_blit_shim);
 
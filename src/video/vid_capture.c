@@ -0,0 +1,911 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Lossless capture of the emulated display and sound output.
+ *
+ *          Frames are taken from the blit path of monitor 0 and stamped
+ *          with the emulated time, which is the number of sound samples
+ *          produced since the capture started. Each frame slot at
+ *          CAPTURE_FPS gets at most one frame; further blits in the same
+ *          slot are folded into the next one and empty slots become
+ *          repeated frames, so the video stays in sync with the sound
+ *          regardless of how fast the host runs.
+ *
+ *          Only the part of the frame that changed since the last
+ *          captured frame is copied on the emulation thread. Encoding
+ *          and file I/O run on a separate thread; if it falls behind,
+ *          frames are turned into repeats rather than stalling the
+ *          emulation.
+ *
+ *          The output is an AVI file with a ZMBV (DOSBox capture codec)
+ *          video stream and a 16-bit stereo PCM sound stream, which most
+ *          players and editors read directly.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <zlib.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/sound.h>
+#include <86box/video.h>
+
+#define CAPTURE_FPS         60
+#define CAPTURE_BLOCK       16
+#define CAPTURE_KEY_FRAMES  300                   /* one key frame every 5 seconds */
+#define CAPTURE_QUEUE_MAX   (64 << 20)            /* bytes of pending frames before dropping */
+#define CAPTURE_FILE_MAX    (1000U << 20)         /* start a new file past this size */
+#define CAPTURE_AVI_HEADER  324
+
+#define AVIIF_KEYFRAME      0x00000010
+
+enum {
+    CAPTURE_REC_FRAME = 0,
+    CAPTURE_REC_REPEAT,
+    CAPTURE_REC_AUDIO,
+    CAPTURE_REC_STOP
+};
+
+typedef struct capture_rec_t {
+    struct capture_rec_t *next;
+
+    int type;
+    int count;          /* repeats, or sound samples */
+    int w;              /* frame size */
+    int h;
+    int x;              /* changed area within the frame */
+    int y;
+    int cw;
+    int ch;
+
+    size_t size;
+    void  *data;
+} capture_rec_t;
+
+typedef struct capture_index_t {
+    uint32_t id;
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t size;
+} capture_index_t;
+
+/* State owned by the encoder thread. */
+typedef struct capture_enc_t {
+    FILE *fp;
+
+    int w;
+    int h;
+    int since_key;
+    int error;
+
+    uint32_t frames;
+    uint32_t samples;
+    uint32_t max_chunk;
+    uint32_t movi_pos;
+
+    uint32_t *cur;
+    uint32_t *prev;
+    uint8_t  *work;
+    uint8_t  *out;
+    size_t    out_size;
+
+    /* Area changed since the previous encoded frame. */
+    int dx;
+    int dy;
+    int dw;
+    int dh;
+
+    capture_index_t *index;
+    uint32_t         index_len;
+    uint32_t         index_max;
+
+    z_stream z;
+    int      z_init;
+} capture_enc_t;
+
+typedef struct capture_t {
+    /* Emulation thread side. */
+    int      started;
+    uint64_t samples;
+    uint64_t origin;
+    int      audio_skip;
+    uint64_t next_slot;
+
+    int fx;             /* geometry of the last captured frame */
+    int fy;
+    int fw;
+    int fh;
+    int full;           /* next frame must be taken whole */
+    int ax;             /* changes accumulated since the last captured frame */
+    int ay;
+    int aw;
+    int ah;
+
+    /* Shared with the encoder thread. */
+    mutex_t       *lock;
+    event_t       *wake;
+    capture_rec_t *head;
+    capture_rec_t *tail;
+    atomic_size_t  queued;
+
+    thread_t     *thread;
+    capture_enc_t enc;
+} capture_t;
+
+static capture_t *capture;
+static capture_t *capture_done; /* stopped, its thread still finishing the file */
+
+#ifdef ENABLE_CAPTURE_LOG
+int capture_do_log = ENABLE_CAPTURE_LOG;
+
+static void
+capture_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (capture_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define capture_log(fmt, ...)
+#endif
+
+static uint8_t *
+capture_put16(uint8_t *p, uint16_t val)
+{
+    p[0] = val & 0xff;
+    p[1] = val >> 8;
+
+    return p + 2;
+}
+
+static uint8_t *
+capture_put32(uint8_t *p, uint32_t val)
+{
+    p[0] = val & 0xff;
+    p[1] = (val >> 8) & 0xff;
+    p[2] = (val >> 16) & 0xff;
+    p[3] = val >> 24;
+
+    return p + 4;
+}
+
+static uint8_t *
+capture_fourcc(uint8_t *p, const char *cc)
+{
+    memcpy(p, cc, 4);
+
+    return p + 4;
+}
+
+static uint32_t
+capture_id(const char *cc)
+{
+    return (uint32_t) cc[0] | ((uint32_t) cc[1] << 8) | ((uint32_t) cc[2] << 16) | ((uint32_t) cc[3] << 24);
+}
+
+/* Builds the RIFF/AVI header up to and including the movi list header.
+   Written with zero counts when the file is opened and again with the
+   final ones when it is closed. */
+static void
+capture_avi_header(const capture_enc_t *enc, uint8_t *hdr, uint32_t riff_size, uint32_t movi_size)
+{
+    uint8_t *p = hdr;
+
+    p = capture_fourcc(p, "RIFF");
+    p = capture_put32(p, riff_size);
+    p = capture_fourcc(p, "AVI ");
+
+    p = capture_fourcc(p, "LIST");
+    p = capture_put32(p, 292);
+    p = capture_fourcc(p, "hdrl");
+
+    /* Main header. */
+    p = capture_fourcc(p, "avih");
+    p = capture_put32(p, 56);
+    p = capture_put32(p, 1000000 / CAPTURE_FPS);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0x00000110); /* AVIF_HASINDEX | AVIF_ISINTERLEAVED */
+    p = capture_put32(p, enc->frames);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 2);
+    p = capture_put32(p, enc->max_chunk);
+    p = capture_put32(p, enc->w);
+    p = capture_put32(p, enc->h);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+
+    /* Video stream. */
+    p = capture_fourcc(p, "LIST");
+    p = capture_put32(p, 116);
+    p = capture_fourcc(p, "strl");
+
+    p = capture_fourcc(p, "strh");
+    p = capture_put32(p, 56);
+    p = capture_fourcc(p, "vids");
+    p = capture_fourcc(p, "ZMBV");
+    p = capture_put32(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 1);
+    p = capture_put32(p, CAPTURE_FPS);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, enc->frames);
+    p = capture_put32(p, enc->max_chunk);
+    p = capture_put32(p, 0xffffffff);
+    p = capture_put32(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, enc->w);
+    p = capture_put16(p, enc->h);
+
+    p = capture_fourcc(p, "strf");
+    p = capture_put32(p, 40);
+    p = capture_put32(p, 40);
+    p = capture_put32(p, enc->w);
+    p = capture_put32(p, enc->h);
+    p = capture_put16(p, 1);
+    p = capture_put16(p, 24);
+    p = capture_fourcc(p, "ZMBV");
+    p = capture_put32(p, enc->w * enc->h * 4);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+
+    /* Sound stream. */
+    p = capture_fourcc(p, "LIST");
+    p = capture_put32(p, 92);
+    p = capture_fourcc(p, "strl");
+
+    p = capture_fourcc(p, "strh");
+    p = capture_put32(p, 56);
+    p = capture_fourcc(p, "auds");
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, 1);
+    p = capture_put32(p, SOUND_FREQ);
+    p = capture_put32(p, 0);
+    p = capture_put32(p, enc->samples);
+    p = capture_put32(p, SOUNDBUFLEN * 4);
+    p = capture_put32(p, 0xffffffff);
+    p = capture_put32(p, 4);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+    p = capture_put16(p, 0);
+
+    p = capture_fourcc(p, "strf");
+    p = capture_put32(p, 16);
+    p = capture_put16(p, 1); /* WAVE_FORMAT_PCM */
+    p = capture_put16(p, 2);
+    p = capture_put32(p, SOUND_FREQ);
+    p = capture_put32(p, SOUND_FREQ * 4);
+    p = capture_put16(p, 4);
+    p = capture_put16(p, 16);
+
+    p = capture_fourcc(p, "LIST");
+    p = capture_put32(p, movi_size);
+    (void) capture_fourcc(p, "movi");
+}
+
+static void
+capture_write_chunk(capture_enc_t *enc, const char *cc, uint32_t flags, const void *data, uint32_t size)
+{
+    uint8_t          hdr[8];
+    uint32_t         pos = (uint32_t) ftell(enc->fp);
+    capture_index_t *idx;
+
+    if (enc->index_len == enc->index_max) {
+        enc->index_max = enc->index_max ? (enc->index_max * 2) : 4096;
+        enc->index     = realloc(enc->index, enc->index_max * sizeof(capture_index_t));
+    }
+
+    idx         = &enc->index[enc->index_len++];
+    idx->id     = capture_id(cc);
+    idx->flags  = flags;
+    idx->offset = pos - enc->movi_pos;
+    idx->size   = size;
+
+    capture_put32(capture_fourcc(hdr, cc), size);
+    fwrite(hdr, 1, 8, enc->fp);
+    if (size > 0)
+        fwrite(data, 1, size, enc->fp);
+    if (size & 1)
+        fputc(0, enc->fp);
+
+    if (size > enc->max_chunk)
+        enc->max_chunk = size;
+}
+
+static void
+capture_file_close(capture_enc_t *enc)
+{
+    uint8_t  hdr[CAPTURE_AVI_HEADER];
+    uint8_t  entry[16];
+    uint32_t movi_end;
+    uint32_t file_end;
+
+    if (enc->fp == NULL)
+        return;
+
+    movi_end = (uint32_t) ftell(enc->fp);
+
+    capture_put32(capture_fourcc(hdr, "idx1"), enc->index_len * 16);
+    fwrite(hdr, 1, 8, enc->fp);
+    for (uint32_t i = 0; i < enc->index_len; i++) {
+        capture_put32(entry, enc->index[i].id);
+        capture_put32(entry + 4, enc->index[i].flags);
+        capture_put32(entry + 8, enc->index[i].offset);
+        capture_put32(entry + 12, enc->index[i].size);
+        fwrite(entry, 1, 16, enc->fp);
+    }
+    file_end = (uint32_t) ftell(enc->fp);
+
+    capture_avi_header(enc, hdr, file_end - 8, movi_end - enc->movi_pos);
+    fseek(enc->fp, 0, SEEK_SET);
+    fwrite(hdr, 1, CAPTURE_AVI_HEADER, enc->fp);
+    fclose(enc->fp);
+    enc->fp = NULL;
+
+    capture_log("Video capture: file closed, %u frames, %u samples\n", enc->frames, enc->samples);
+}
+
+static void
+capture_file_open(capture_enc_t *enc, int w, int h)
+{
+    uint8_t hdr[CAPTURE_AVI_HEADER];
+    char    path[1024];
+    char    fn[256];
+    size_t  work_size;
+
+    memset(fn, 0, sizeof(fn));
+    memset(path, 0, sizeof(path));
+
+    path_append_filename(path, usr_path, VIDEO_CAPTURE_PATH);
+
+    if (!plat_dir_check(path))
+        plat_dir_create(path);
+
+    path_slash(path);
+    plat_tempfile(fn, NULL, ".avi");
+    strcat(path, fn);
+
+    capture_log("Video capture: recording to %s\n", path);
+
+    if ((enc->w != w) || (enc->h != h)) {
+        free(enc->cur);
+        free(enc->prev);
+        free(enc->work);
+        free(enc->out);
+
+        enc->w = w;
+        enc->h = h;
+
+        /* Block vectors, padded to 4 bytes, followed by the XOR data. */
+        work_size = ((((w + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK) * ((h + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK) * 2 + 3) & ~3) + ((size_t) w * h * 4);
+
+        enc->cur      = calloc((size_t) w * h, sizeof(uint32_t));
+        enc->prev     = calloc((size_t) w * h, sizeof(uint32_t));
+        enc->work     = malloc(work_size);
+        enc->out_size = deflateBound(&enc->z, work_size) + 64;
+        enc->out      = malloc(enc->out_size);
+    }
+
+    enc->frames    = 0;
+    enc->samples   = 0;
+    enc->max_chunk = 0;
+    enc->index_len = 0;
+    enc->since_key = CAPTURE_KEY_FRAMES;
+
+    enc->fp = plat_fopen(path, "wb");
+    if (enc->fp == NULL) {
+        capture_log("Video capture: unable to open %s for writing\n", path);
+        return;
+    }
+
+    capture_avi_header(enc, hdr, 0, 0);
+    fwrite(hdr, 1, CAPTURE_AVI_HEADER, enc->fp);
+    enc->movi_pos = CAPTURE_AVI_HEADER - 4;
+}
+
+/* Encodes enc->cur against enc->prev; returns the size of the packet in
+   enc->out, or 0 if the frame is identical to the previous one. */
+static uint32_t
+capture_zmbv_encode(capture_enc_t *enc, int key)
+{
+    int      bw   = (enc->w + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK;
+    int      bh   = (enc->h + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK;
+    int      hdr  = 1;
+    int      bx1  = 0;
+    int      by1  = 0;
+    int      bx2  = -1;
+    int      by2  = -1;
+    int      any  = 0;
+    uint8_t *src;
+    size_t   len;
+
+    if (key) {
+        enc->out[0] = 0x01; /* key frame */
+        enc->out[1] = 0;    /* version 0.1 */
+        enc->out[2] = 1;
+        enc->out[3] = 1;    /* zlib */
+        enc->out[4] = 8;    /* 32 bpp */
+        enc->out[5] = CAPTURE_BLOCK;
+        enc->out[6] = CAPTURE_BLOCK;
+        hdr         = 7;
+
+        deflateReset(&enc->z);
+
+        src = (uint8_t *) enc->cur;
+        len = (size_t) enc->w * enc->h * 4;
+    } else {
+        uint8_t  *vec  = enc->work;
+        uint32_t *xorp = (uint32_t *) (enc->work + (((bw * bh * 2) + 3) & ~3));
+
+        enc->out[0] = 0x00;
+
+        memset(vec, 0, ((bw * bh * 2) + 3) & ~3);
+
+        /* Only blocks overlapping the changed area can differ. */
+        if ((enc->dw > 0) && (enc->dh > 0)) {
+            bx1 = enc->dx / CAPTURE_BLOCK;
+            by1 = enc->dy / CAPTURE_BLOCK;
+            bx2 = (enc->dx + enc->dw - 1) / CAPTURE_BLOCK;
+            by2 = (enc->dy + enc->dh - 1) / CAPTURE_BLOCK;
+        }
+
+        for (int by = by1; by <= by2; by++) {
+            int y0 = by * CAPTURE_BLOCK;
+            int rows = MIN(CAPTURE_BLOCK, enc->h - y0);
+
+            for (int bx = bx1; bx <= bx2; bx++) {
+                int              x0    = bx * CAPTURE_BLOCK;
+                int              cols  = MIN(CAPTURE_BLOCK, enc->w - x0);
+                int              diff  = 0;
+                const uint32_t  *c     = &enc->cur[(size_t) y0 * enc->w + x0];
+                const uint32_t  *p     = &enc->prev[(size_t) y0 * enc->w + x0];
+
+                for (int y = 0; (y < rows) && !diff; y++)
+                    diff = memcmp(&c[y * enc->w], &p[y * enc->w], cols * 4);
+
+                if (!diff)
+                    continue;
+
+                vec[(by * bw + bx) * 2] = 1; /* motion vector 0,0 with XOR data */
+                for (int y = 0; y < rows; y++) {
+                    for (int x = 0; x < cols; x++)
+                        *xorp++ = c[y * enc->w + x] ^ p[y * enc->w + x];
+                }
+                any = 1;
+            }
+        }
+
+        if (!any)
+            return 0;
+
+        src = enc->work;
+        len = (uint8_t *) xorp - enc->work;
+    }
+
+    enc->z.next_in   = src;
+    enc->z.avail_in  = (uInt) len;
+    enc->z.next_out  = enc->out + hdr;
+    enc->z.avail_out = (uInt) (enc->out_size - hdr);
+    deflate(&enc->z, Z_SYNC_FLUSH);
+
+    return (uint32_t) (enc->out_size - enc->z.avail_out);
+}
+
+static void
+capture_enc_frame(capture_enc_t *enc, capture_rec_t *rec)
+{
+    const uint32_t *src = (const uint32_t *) rec->data;
+    uint32_t        size;
+    int             key;
+
+    if ((enc->fp != NULL) && ((rec->w != enc->w) || (rec->h != enc->h) || ((uint32_t) ftell(enc->fp) >= CAPTURE_FILE_MAX)))
+        capture_file_close(enc);
+
+    if (enc->fp == NULL) {
+        if (enc->error)
+            return;
+
+        /* Starts with a key frame; when only splitting the file, the
+           current frame carries over. */
+        capture_file_open(enc, rec->w, rec->h);
+        if (enc->fp == NULL) {
+            enc->error = 1;
+            return;
+        }
+    }
+
+    for (int y = 0; y < rec->ch; y++) {
+        uint32_t *dst = &enc->cur[(size_t) (rec->y + y) * enc->w + rec->x];
+
+        for (int x = 0; x < rec->cw; x++)
+            dst[x] = src[x] & 0x00ffffff;
+        src += rec->cw;
+    }
+
+    enc->dx = rec->x;
+    enc->dy = rec->y;
+    enc->dw = rec->cw;
+    enc->dh = rec->ch;
+
+    key = (enc->since_key >= CAPTURE_KEY_FRAMES);
+    size = capture_zmbv_encode(enc, key);
+    capture_write_chunk(enc, "00dc", key ? AVIIF_KEYFRAME : 0, enc->out, size);
+    enc->frames++;
+    enc->since_key = key ? 1 : (enc->since_key + 1);
+
+    if (key)
+        memcpy(enc->prev, enc->cur, (size_t) enc->w * enc->h * 4);
+    else {
+        for (int y = 0; y < rec->ch; y++) {
+            size_t off = (size_t) (rec->y + y) * enc->w + rec->x;
+
+            memcpy(&enc->prev[off], &enc->cur[off], rec->cw * 4);
+        }
+    }
+}
+
+static void
+capture_enc_repeat(capture_enc_t *enc, int count)
+{
+    if (enc->fp == NULL)
+        return;
+
+    /* An empty chunk repeats the previous frame. */
+    for (int i = 0; i < count; i++) {
+        capture_write_chunk(enc, "00dc", 0, NULL, 0);
+        enc->frames++;
+        enc->since_key++;
+    }
+}
+
+static void
+capture_enc_audio(capture_enc_t *enc, capture_rec_t *rec)
+{
+    if (enc->fp == NULL)
+        return;
+
+    capture_write_chunk(enc, "01wb", AVIIF_KEYFRAME, rec->data, rec->count * 4);
+    enc->samples += rec->count;
+}
+
+static void
+capture_thread(void *priv)
+{
+    capture_t     *dev = (capture_t *) priv;
+    capture_enc_t *enc = &dev->enc;
+    capture_rec_t *rec;
+    capture_rec_t *next;
+    int            stop = 0;
+
+    while (!stop) {
+        thread_wait_event(dev->wake, -1);
+        thread_reset_event(dev->wake);
+
+        thread_wait_mutex(dev->lock);
+        rec       = dev->head;
+        dev->head = dev->tail = NULL;
+        thread_release_mutex(dev->lock);
+
+        for (; rec != NULL; rec = next) {
+            next = rec->next;
+
+            switch (rec->type) {
+                case CAPTURE_REC_FRAME:
+                    capture_enc_frame(enc, rec);
+                    break;
+                case CAPTURE_REC_REPEAT:
+                    capture_enc_repeat(enc, rec->count);
+                    break;
+                case CAPTURE_REC_AUDIO:
+                    capture_enc_audio(enc, rec);
+                    break;
+                case CAPTURE_REC_STOP:
+                    stop = 1;
+                    break;
+
+                default:
+                    break;
+            }
+
+            atomic_fetch_sub(&dev->queued, rec->size);
+            free(rec->data);
+            free(rec);
+        }
+    }
+
+    capture_file_close(enc);
+}
+
+static capture_rec_t *
+capture_rec_new(int type, size_t size)
+{
+    capture_rec_t *rec = calloc(1, sizeof(capture_rec_t));
+
+    rec->type = type;
+    rec->size = size;
+    if (size > 0)
+        rec->data = malloc(size);
+
+    return rec;
+}
+
+static void
+capture_queue(capture_t *dev, capture_rec_t *rec)
+{
+    atomic_fetch_add(&dev->queued, rec->size);
+
+    thread_wait_mutex(dev->lock);
+    if (dev->tail != NULL)
+        dev->tail->next = rec;
+    else
+        dev->head = rec;
+    dev->tail = rec;
+    thread_release_mutex(dev->lock);
+
+    thread_set_event(dev->wake);
+}
+
+static void
+capture_queue_repeat(capture_t *dev, int count)
+{
+    capture_rec_t *rec = capture_rec_new(CAPTURE_REC_REPEAT, 0);
+
+    rec->count = count;
+    capture_queue(dev, rec);
+}
+
+static void
+capture_free(capture_t *dev)
+{
+    thread_wait(dev->thread);
+
+    thread_destroy_event(dev->wake);
+    thread_close_mutex(dev->lock);
+
+    if (dev->enc.z_init)
+        deflateEnd(&dev->enc.z);
+    free(dev->enc.cur);
+    free(dev->enc.prev);
+    free(dev->enc.work);
+    free(dev->enc.out);
+    free(dev->enc.index);
+    free(dev);
+}
+
+int
+video_capture_active(void)
+{
+    return capture != NULL;
+}
+
+void
+video_capture_start(void)
+{
+    capture_t *dev;
+
+    if (capture != NULL)
+        return;
+
+    /* Let the previous recording finish writing its file. */
+    if (capture_done != NULL) {
+        capture_free(capture_done);
+        capture_done = NULL;
+    }
+
+    dev = calloc(1, sizeof(capture_t));
+    if (deflateInit(&dev->enc.z, Z_BEST_SPEED) != Z_OK) {
+        free(dev);
+        return;
+    }
+    dev->enc.z_init = 1;
+
+    atomic_init(&dev->queued, 0);
+    dev->lock   = thread_create_mutex();
+    dev->wake   = thread_create_event();
+    dev->thread = thread_create(capture_thread, dev);
+
+    capture = dev;
+}
+
+void
+video_capture_stop(void)
+{
+    if (capture == NULL)
+        return;
+
+    capture_queue(capture, capture_rec_new(CAPTURE_REC_STOP, 0));
+
+    capture_done = capture;
+    capture      = NULL;
+}
+
+void
+video_capture_close(void)
+{
+    video_capture_stop();
+
+    if (capture_done != NULL) {
+        capture_free(capture_done);
+        capture_done = NULL;
+    }
+}
+
+/* Called from the blit path once the dirty area of the frame has been
+   latched; the target buffer is not written to until the next blit. */
+void
+video_capture_frame(int x, int y, int w, int h, int monitor_index)
+{
+    capture_t      *dev = capture;
+    capture_rec_t  *rec;
+    const bitmap_t *target;
+    uint32_t       *dst;
+    uint64_t        now;
+    uint64_t        slot;
+    int             dx;
+    int             dy;
+    int             dw;
+    int             dh;
+    int             x2;
+    int             y2;
+
+    if ((dev == NULL) || (monitor_index != 0))
+        return;
+
+    if ((x != dev->fx) || (y != dev->fy) || (w != dev->fw) || (h != dev->fh)) {
+        dev->fx   = x;
+        dev->fy   = y;
+        dev->fw   = w;
+        dev->fh   = h;
+        dev->full = 1;
+    } else if (!dev->full && video_blit_get_dirty_monitor(monitor_index, &dx, &dy, &dw, &dh)) {
+        dx -= x;
+        dy -= y;
+        if ((dev->aw > 0) && (dev->ah > 0)) {
+            x2      = MAX(dev->ax + dev->aw, dx + dw);
+            y2      = MAX(dev->ay + dev->ah, dy + dh);
+            dev->ax = MIN(dev->ax, dx);
+            dev->ay = MIN(dev->ay, dy);
+            dev->aw = x2 - dev->ax;
+            dev->ah = y2 - dev->ay;
+        } else {
+            dev->ax = dx;
+            dev->ay = dy;
+            dev->aw = dw;
+            dev->ah = dh;
+        }
+    }
+
+    now = dev->samples + sound_pos_global;
+
+    if (!dev->started) {
+        /* The recording starts with the first frame; sound produced
+           before it in the current buffer is left out. */
+        dev->started    = 1;
+        dev->origin     = now;
+        dev->audio_skip = sound_pos_global;
+        dev->next_slot  = 0;
+        dev->full       = 1;
+    }
+
+    slot = ((now - dev->origin) * CAPTURE_FPS) / SOUND_FREQ;
+
+    /* This slot already has its frame, keep the changes for the next one. */
+    if (slot < dev->next_slot)
+        return;
+
+    if (slot > dev->next_slot)
+        capture_queue_repeat(dev, (int) (slot - dev->next_slot));
+    dev->next_slot = slot + 1;
+
+    if (dev->full) {
+        dev->ax = 0;
+        dev->ay = 0;
+        dev->aw = w;
+        dev->ah = h;
+    } else if ((dev->aw <= 0) || (dev->ah <= 0)) {
+        capture_queue_repeat(dev, 1);
+        return;
+    }
+
+    if ((atomic_load(&dev->queued) + ((size_t) dev->aw * dev->ah * 4)) > CAPTURE_QUEUE_MAX) {
+        /* The encoder is behind: repeat the previous frame and carry the
+           changes over, rather than waiting for it. */
+        capture_log("Video capture: encoder behind, frame dropped\n");
+        capture_queue_repeat(dev, 1);
+        return;
+    }
+
+    rec     = capture_rec_new(CAPTURE_REC_FRAME, (size_t) dev->aw * dev->ah * 4);
+    rec->w  = w;
+    rec->h  = h;
+    rec->x  = dev->ax;
+    rec->y  = dev->ay;
+    rec->cw = dev->aw;
+    rec->ch = dev->ah;
+
+    target = monitors[monitor_index].target_buffer;
+    dst    = (uint32_t *) rec->data;
+    for (int yy = 0; yy < dev->ah; yy++) {
+        memcpy(dst, &target->line[y + dev->ay + yy][x + dev->ax], dev->aw * 4);
+        dst += dev->aw;
+    }
+
+    capture_queue(dev, rec);
+
+    dev->full = 0;
+    dev->aw   = 0;
+    dev->ah   = 0;
+}
+
+/* Called by the sound code with each mixed buffer of stereo samples. */
+void
+video_capture_audio(const int32_t *buf, int samples)
+{
+    capture_t     *dev = capture;
+    capture_rec_t *rec;
+    uint8_t       *dst;
+    int            skip;
+    int32_t        val;
+
+    if (dev == NULL)
+        return;
+
+    dev->samples += samples;
+
+    if (!dev->started)
+        return;
+
+    skip            = dev->audio_skip;
+    dev->audio_skip = 0;
+    if (skip >= samples)
+        return;
+
+    rec        = capture_rec_new(CAPTURE_REC_AUDIO, (size_t) (samples - skip) * 4);
+    rec->count = samples - skip;
+
+    dst = (uint8_t *) rec->data;
+    for (int c = skip * 2; c < samples * 2; c++) {
+        val = buf[c];
+        if (val > 32767)
+            val = 32767;
+        else if (val < -32768)
+            val = -32768;
+        dst = capture_put16(dst, (uint16_t) val);
+    }
+
+    capture_queue(dev, rec);
+}
@@ -84,6 +84,41 @@ svga_get_pri(void)
     return svga_pri;
 }
 
+/* Sizes the target buffer to the largest of what may be drawn into it: the
+   VGA mode, the 8514/A and XGA modes if those are present, and whatever
+   device overrides the output. The extra 64 pixels cover the cursor and
+   overlay drawing past the right edge. Returns 1 if the buffer was
+   replaced, after setting fullchange. */
+static int
+svga_size_buffer(svga_t *svga)
+{
+    const ibm8514_t *dev = (ibm8514_t *) svga->dev8514;
+    const xga_t     *xga = (xga_t *) svga->xga;
+    int              w   = svga->hdisp;
+    int              h   = (svga->dispend << !!svga->interlace) << !!svga->vertical_linedbl;
+
+    if (ibm8514_active && (dev != NULL)) {
+        w = MAX(w, dev->h_disp);
+        h = MAX(h, dev->dispend << !!dev->interlace);
+    }
+
+    if (xga_active && (xga != NULL)) {
+        w = MAX(w, xga->h_disp);
+        h = MAX(h, xga->dispend << !!xga->interlace);
+    }
+
+    if (svga->override) {
+        w = MAX(w, svga->override_x);
+        h = MAX(h, svga->override_y);
+    }
+
+    if (!video_monitor_size_buffer(w + svga->monitor->mon_overscan_x + 64, h + svga->monitor->mon_overscan_y + 64, svga->monitor_index))
+        return 0;
+
+    svga->fullchange = svga->monitor->mon_changeframecount;
+    return 1;
+}
+
 void
 svga_set_override(svga_t *svga, int val)
 {
@@ -109,6 +144,18 @@ svga_set_override(svga_t *svga, int val)
 #endif
 }
 
+/* Called by the device overriding the output whenever its resolution
+   changes. Returns 1 if the target buffer was replaced, in which case the
+   device has to redraw the whole frame. */
+int
+svga_set_override_size(svga_t *svga, int x, int y)
+{
+    svga->override_x = x;
+    svga->override_y = y;
+
+    return svga->override ? svga_size_buffer(svga) : 0;
+}
+
 void
 svga_out(uint16_t addr, uint8_t val, void *priv)
 {
@@ -596,6 +643,10 @@ svga_recalctimings(svga_t *svga)
     int              hsyncend;
 #endif
 
+    /* Timings, overscan or the owner of the screen may have changed. */
+    svga->dirty_full = 1;
+    svga_render_pool_wait(svga);
+
     svga->vtotal      = svga->crtc[6];
     svga->dispend     = svga->crtc[0x12];
     svga->vsyncstart  = svga->crtc[0x10];
@@ -853,12 +904,16 @@ svga_recalctimings(svga_t *svga)
     }
 #endif
 
-    if (svga->hdisp >= 2048)
+    if ((svga->hdisp + svga->monitor->mon_overscan_x) > VIDEO_MAX_X)
         svga->monitor->mon_overscan_x = 0;
 
     svga->y_add = (svga->monitor->mon_overscan_y >> 1);
     svga->x_add = (svga->monitor->mon_overscan_x >> 1);
 
+    /* The target buffer is sized to the mode before anything is rendered
+       into it, and shrunk again when going back to a smaller one. */
+    svga_size_buffer(svga);
+
     if (svga->vblankstart < svga->dispend) {
         svga_log("DISPEND > VBLANKSTART.\n");
         svga->dispend = svga->vblankstart;
@@ -978,43 +1033,96 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+static __inline void
+svga_mark_dirty(svga_t *svga, int line)
+{
+    if (line < svga->dirty_top)
+        svga->dirty_top = line;
+    if (line > svga->dirty_bottom)
+        svga->dirty_bottom = line;
+}
+
+/* Cursors clipped at the top wrap around the target buffer, whose height
+   depends on the mode. */
+static __inline int
+svga_buffer_line(const svga_t *svga, int line)
+{
+    int h = svga->monitor->target_buffer->h;
+
+    line %= h;
+    return (line < 0) ? (line + h) : line;
+}
+
 static void
 svga_do_render(svga_t *svga)
 {
+    int firstline_draw = svga->firstline_draw;
+    int lastline_draw  = svga->lastline_draw;
+    int compose;
+
     /* Always render a blank screen and nothing else while in DPMS mode. */
     if (svga->dpms) {
         svga_render_blank(svga);
+        if ((svga->firstline_draw != firstline_draw) || (svga->lastline_draw != lastline_draw))
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
         return;
     }
 
     if (!svga->override) {
+        /* The cursor and overlay callbacks advance the card's own state as
+           they draw, so they cannot be run later from a worker. Render the
+           lines they cover right here, and leave the rest of the pool
+           running. */
+        compose = (svga->overlay_on && svga->overlay_draw) || (svga->dac_hwcursor_on && svga->dac_hwcursor_draw) || (svga->hwcursor_on && svga->hwcursor_draw);
+
+        svga->render_defer  = (svga->render_pool != NULL) && !compose;
+        svga->render_queued = 0;
         svga->render(svga);
+        svga->render_defer = 0;
+
+        /* The renderers only touch firstline_draw/lastline_draw when they
+           actually redraw the line. */
+        if ((svga->firstline_draw != firstline_draw) || (svga->lastline_draw != lastline_draw))
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
 
         svga->x_add = (svga->monitor->mon_overscan_x >> 1);
         svga_render_overscan_left(svga);
         svga_render_overscan_right(svga);
+        svga->render_queued = 0;
         svga->x_add = (svga->monitor->mon_overscan_x >> 1) - svga->scrollcache;
     }
 
     if (svga->overlay_on) {
-        if (!svga->override && svga->overlay_draw)
+        if (!svga->override && svga->overlay_draw) {
             svga->overlay_draw(svga, svga->displine + svga->y_add);
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
+        }
         svga->overlay_on--;
         if (svga->overlay_on && svga->interlace)
             svga->overlay_on--;
     }
 
     if (svga->dac_hwcursor_on) {
-        if (!svga->override && svga->dac_hwcursor_draw)
-            svga->dac_hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+        if (!svga->override && svga->dac_hwcursor_draw) {
+            /* A cursor clipped at the top draws onto an earlier line,
+               which may still be queued. */
+            if (svga->dac_hwcursor_latch.y < 0)
+                svga_render_pool_wait(svga);
+            svga->dac_hwcursor_draw(svga, svga_buffer_line(svga, svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)));
+            svga_mark_dirty(svga, svga_buffer_line(svga, svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)));
+        }
         svga->dac_hwcursor_on--;
         if (svga->dac_hwcursor_on && svga->interlace)
             svga->dac_hwcursor_on--;
     }
 
     if (svga->hwcursor_on) {
-        if (!svga->override && svga->hwcursor_draw)
-            svga->hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+        if (!svga->override && svga->hwcursor_draw) {
+            if (svga->hwcursor_latch.y < 0)
+                svga_render_pool_wait(svga);
+            svga->hwcursor_draw(svga, svga_buffer_line(svga, svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)));
+            svga_mark_dirty(svga, svga_buffer_line(svga, svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)));
+        }
         svga->hwcursor_on--;
         if (svga->hwcursor_on && svga->interlace)
             svga->hwcursor_on--;
@@ -1036,6 +1144,7 @@ svga_poll(void *priv)
     if (!svga->override) {
         if (xga_active && xga && xga->on) {
             if ((xga->disp_cntl_2 & 7) >= 2) {
+                svga_render_pool_wait(svga);
                 xga_poll(xga, svga);
                 return;
             }
@@ -1119,7 +1228,7 @@ svga_poll(void *priv)
         if ((svga->cgastat & 8) && ((svga->displine & 15) == (svga->crtc[0x11] & 15)) && svga->vslines)
             svga->cgastat &= ~8;
         svga->vslines++;
-        if (svga->displine > 2000)
+        if (svga->displine > (svga->monitor->target_buffer->h - 48))
             svga->displine = 0;
     } else {
         timer_advance_u64(&svga->timer, svga->dispontime);
@@ -1221,7 +1330,10 @@ svga_poll(void *priv)
 
             wx = x;
 
+            svga_render_pool_wait(svga);
+
             if (!svga->override) {
+                svga->dirty_valid = 1;
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga->vdisp = wy + 1;
@@ -1231,13 +1343,16 @@ svga_poll(void *priv)
                     svga->vdisp = wy + 1;
                     svga_doblit(wx, wy, svga);
                 }
-            }
+            } else
+                svga->dirty_full = 1;
 
             svga->firstline = 2000;
             svga->lastline  = 0;
 
             svga->firstline_draw = 2000;
             svga->lastline_draw  = 0;
+            svga->dirty_top      = VIDEO_MAX_Y;
+            svga->dirty_bottom   = -1;
 
             svga->oddeven ^= 1;
 
@@ -1340,6 +1455,10 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
     svga->x_add                   = 8;
     svga->y_add                   = 16;
 
+    svga->dirty_top    = VIDEO_MAX_Y;
+    svga->dirty_bottom = -1;
+    svga->dirty_full   = 1;
+
     svga->crtc[0]           = 63;
     svga->crtc[6]           = 255;
     svga->dispontime        = 1000ULL << 32;
@@ -1392,12 +1511,16 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
 
     svga->map8            = svga->pallook;
 
+    svga_render_pool_init(svga);
+
     return 0;
 }
 
 void
 svga_close(svga_t *svga)
 {
+    svga_render_pool_close(svga);
+
     free(svga->changedvram);
     free(svga->vram);
 
@@ -1834,6 +1957,9 @@ svga_doblit(int wx, int wy, svga_t *svga)
     int       xs_temp;
     int       ys_temp;
 
+    /* Lines still being rendered by the render pool. */
+    svga_render_pool_wait(svga);
+
     y_add   = enable_overscan ? svga->monitor->mon_overscan_y : 0;
     x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
     y_start = enable_overscan ? 0 : (svga->monitor->mon_overscan_y >> 1);
@@ -1846,8 +1972,12 @@ svga_doblit(int wx, int wy, svga_t *svga)
         bottom <<= 1;
     }
 
-    if ((wx <= 0) || (wy <= 0))
+    if ((wx <= 0) || (wy <= 0)) {
+        /* Lines redrawn this frame will not reach the consumers. */
+        svga->dirty_full  = 1;
+        svga->dirty_valid = 0;
         return;
+    }
 
     if (svga->vertical_linedbl)
         svga->y_add <<= 1;
@@ -1866,9 +1996,10 @@ svga_doblit(int wx, int wy, svga_t *svga)
         svga->monitor->mon_xsize = xs_temp;
         svga->monitor->mon_ysize = ys_temp;
 
-        if ((svga->monitor->mon_xsize > 1984) || (svga->monitor->mon_ysize > 2016)) {
-            /* 2048x2048 is the biggest safe render texture, to account for overscan,
-               we suppress overscan starting from x 1984 and y 2016. */
+        if ((svga->monitor->mon_xsize > (VIDEO_MAX_X - 64)) || (svga->monitor->mon_ysize > (VIDEO_MAX_Y - 32))) {
+            /* VIDEO_MAX_X x VIDEO_MAX_Y is the biggest frame the blit consumers
+               take, to account for overscan, we suppress it for modes this close
+               to the limit. */
             x_add             = 0;
             y_add             = 0;
             suppress_overscan = 1;
@@ -1885,22 +2016,47 @@ svga_doblit(int wx, int wy, svga_t *svga)
     }
 
     if ((wx >= 160) && ((wy + 1) >= 120)) {
+        /* The screen size is not updated with the CRTC disabled, so it may
+           still be that of a larger mode than the buffer was sized for. */
+        const int fill_w = MIN(svga->monitor->mon_xsize + x_add, svga->monitor->target_buffer->w);
+
         /* Draw (overscan_size - scroll size) lines of overscan on top and bottom. */
         for (i = 0; i < svga->y_add; i++) {
-            p = &svga->monitor->target_buffer->line[i & 0x7ff][0];
+            p = &svga->monitor->target_buffer->line[i][0];
 
-            for (j = 0; j < (svga->monitor->mon_xsize + x_add); j++)
+            for (j = 0; j < fill_w; j++)
                 p[j] = svga->dpms ? 0 : svga->overscan_color;
         }
 
         for (i = 0; i < bottom; i++) {
-            p = &svga->monitor->target_buffer->line[(svga->monitor->mon_ysize + svga->y_add + i) & 0x7ff][0];
+            if ((svga->monitor->mon_ysize + svga->y_add + i) >= svga->monitor->target_buffer->h)
+                break;
+
+            p = &svga->monitor->target_buffer->line[svga->monitor->mon_ysize + svga->y_add + i][0];
 
-            for (j = 0; j < (svga->monitor->mon_xsize + x_add); j++)
+            for (j = 0; j < fill_w; j++)
                 p[j] = svga->dpms ? 0 : svga->overscan_color;
         }
     }
 
+    /* Only blits from svga_poll() know which lines were redrawn; anything
+       else drawing to the screen means the next one has to be whole. The
+       overscan is refilled on every line and every blit, so a new overscan
+       colour changes the whole frame as well. */
+    if ((svga->dirty_dpms != svga->dpms) || (svga->dirty_overscan != svga->overscan_color))
+        svga->dirty_full = 1;
+    if (svga->dirty_valid && !svga->dirty_full) {
+        if (svga->dirty_top > svga->dirty_bottom)
+            video_blit_set_dirty_monitor(x_start, y_start, 0, 0, svga->monitor_index);
+        else
+            video_blit_set_dirty_monitor(x_start, svga->dirty_top, svga->monitor->mon_xsize + x_add,
+                                         svga->dirty_bottom - svga->dirty_top + 1, svga->monitor_index);
+    }
+    svga->dirty_full     = !svga->dirty_valid;
+    svga->dirty_valid    = 0;
+    svga->dirty_dpms     = svga->dpms;
+    svga->dirty_overscan = svga->overscan_color;
+
     video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
 
     if (svga->vertical_linedbl)
@@ -44,6 +44,14 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/* Whether len bytes of VRAM starting at the current display address can be
+   handed to a span converter in one piece, ie. without wrapping around. */
+static __inline int
+svga_span_contig(svga_t *svga, uint32_t len)
+{
+    return ((svga->ma & svga->vram_display_mask) + len - 1) <= svga->vram_display_mask;
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -111,6 +119,14 @@ svga_render_overscan_left(svga_t *svga)
         return;
 
     uint32_t *line_ptr = svga->monitor->target_buffer->line[svga->displine + svga->y_add];
+
+    /* The span for this line is still queued and may start inside the
+       left overscan when scrolling, so fill after it. */
+    if (svga->render_queued) {
+        svga_render_pool_fill(svga, line_ptr, svga->x_add, svga->overscan_color);
+        return;
+    }
+
     for (int i = 0; i < svga->x_add; i++)
         *line_ptr++ = svga->overscan_color;
 }
@@ -128,6 +144,13 @@ svga_render_overscan_right(svga_t *svga)
 
     uint32_t *line_ptr = &svga->monitor->target_buffer->line[svga->displine + svga->y_add][svga->x_add + svga->hdisp];
     right              = (overscan_x >> 1);
+
+    /* The span for this line is still queued, so fill after it. */
+    if (svga->render_queued) {
+        svga_render_pool_fill(svga, line_ptr, right, svga->overscan_color);
+        return;
+    }
+
     for (int i = 0; i < right; i++)
         *line_ptr++ = svga->overscan_color;
 }
@@ -747,6 +770,17 @@ svga_render_indexed_gfx(svga_t *svga, bool highres, bool combine8bits)
         svga->firstline_draw = svga->displine;
     svga->lastline_draw = svga->displine;
 
+    if (highres8bpp && !svga->packed_4bpp && !svga->ati_4color && !svga->force_old_addr && !svga->remap_required &&
+        (loadevery == 1) && (incevery == 1) && (planemask == 0xffffffff) && !attrblink) {
+        /* Plain packed 8bpp, every byte is one pixel in order. */
+        x = (((svga->hdisp + svga->scrollcache) >> 2) + 1) << 2;
+        if (svga_span_contig(svga, x)) {
+            svga_render_span_8(svga, p, svga->ma & svga->vram_display_mask, x);
+            svga->ma = (svga->ma + x) & svga->vram_display_mask;
+            return;
+        }
+    }
+
     uint32_t incr_counter = 0;
     uint32_t load_counter = 0;
     uint32_t edat         = 0;
@@ -932,21 +966,27 @@ svga_render_8bpp_clone_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
-                dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-                p[0] = svga->map8[dat & svga->dac_mask & 0xff];
-                p[1] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
-                p[2] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
-                p[3] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
+            x = ((svga->hdisp >> 3) + 1) << 3;
+            if (svga_span_contig(svga, x)) {
+                svga_render_span_8(svga, p, svga->ma & svga->vram_display_mask, x);
+                svga->ma += x;
+            } else {
+                for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
+                    dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                    p[0] = svga->map8[dat & svga->dac_mask & 0xff];
+                    p[1] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
+                    p[2] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
+                    p[3] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
 
-                dat  = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
-                p[4] = svga->map8[dat & svga->dac_mask & 0xff];
-                p[5] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
-                p[6] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
-                p[7] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
+                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
+                    p[4] = svga->map8[dat & svga->dac_mask & 0xff];
+                    p[5] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
+                    p[6] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
+                    p[7] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
 
-                svga->ma += 8;
-                p += 8;
+                    svga->ma += 8;
+                    p += 8;
+                }
             }
             svga->ma &= svga->vram_display_mask;
         }
@@ -961,21 +1001,27 @@ svga_render_8bpp_clone_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-                    p[0] = svga->map8[dat & svga->dac_mask & 0xff];
-                    p[1] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
-                    p[2] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
-                    p[3] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
-                    p[4] = svga->map8[dat & svga->dac_mask & 0xff];
-                    p[5] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
-                    p[6] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
-                    p[7] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
-
-                    svga->ma += 8;
-                    p += 8;
+                x = ((svga->hdisp >> 3) + 1) << 3;
+                if (svga_span_contig(svga, x)) {
+                    svga_render_span_8(svga, p, svga->ma & svga->vram_display_mask, x);
+                    svga->ma += x;
+                } else {
+                    for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                        p[0] = svga->map8[dat & svga->dac_mask & 0xff];
+                        p[1] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
+                        p[2] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
+                        p[3] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
+                        p[4] = svga->map8[dat & svga->dac_mask & 0xff];
+                        p[5] = svga->map8[(dat >> 8) & svga->dac_mask & 0xff];
+                        p[6] = svga->map8[(dat >> 16) & svga->dac_mask & 0xff];
+                        p[7] = svga->map8[(dat >> 24) & svga->dac_mask & 0xff];
+
+                        svga->ma += 8;
+                        p += 8;
+                    }
                 }
             } else {
                 for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 4) {
@@ -1197,6 +1243,7 @@ svga_render_8bpp_tseng_lowres(svga_t *svga)
 void
 svga_render_8bpp_tseng_highres(svga_t *svga)
 {
+    int       x;
     uint32_t *p;
     uint32_t  dat;
 
@@ -1210,43 +1257,49 @@ svga_render_8bpp_tseng_highres(svga_t *svga)
             svga->firstline_draw = svga->displine;
         svga->lastline_draw = svga->displine;
 
-        for (int x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
-            dat = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[0] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[1] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[2] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[3] = svga->map8[dat & svga->dac_mask & 0xff];
-
-            dat = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[4] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[5] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[6] = svga->map8[dat & svga->dac_mask & 0xff];
-            dat >>= 8;
-            if (svga->attrregs[0x10] & 0x80)
-                dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
-            p[7] = svga->map8[dat & svga->dac_mask & 0xff];
+        x = ((svga->hdisp >> 3) + 1) << 3;
+        if (!(svga->attrregs[0x10] & 0x80) && svga_span_contig(svga, x)) {
+            svga_render_span_8(svga, p, svga->ma & svga->vram_display_mask, x);
+            svga->ma += x;
+        } else {
+            for (x = 0; x <= (svga->hdisp /* + svga->scrollcache*/); x += 8) {
+                dat = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[0] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[1] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[2] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[3] = svga->map8[dat & svga->dac_mask & 0xff];
+
+                dat = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[4] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[5] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[6] = svga->map8[dat & svga->dac_mask & 0xff];
+                dat >>= 8;
+                if (svga->attrregs[0x10] & 0x80)
+                    dat = (dat & ~0xf0) | ((svga->attrregs[0x14] & 0x0f) << 4);
+                p[7] = svga->map8[dat & svga->dac_mask & 0xff];
 
-            svga->ma += 8;
-            p += 8;
+                svga->ma += 8;
+                p += 8;
+            }
         }
         svga->ma &= svga->vram_display_mask;
     }
@@ -1344,22 +1397,27 @@ svga_render_15bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                p[x]     = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 1] = svga->conv_16to32(svga, dat >> 16, 15);
+            x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+            if ((svga->conv_16to32 == svga_conv_16to32) && svga_span_contig(svga, x << 1)) {
+                svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 15);
+            } else {
+                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                    p[x]     = svga->conv_16to32(svga, dat & 0xffff, 15);
+                    p[x + 1] = svga->conv_16to32(svga, dat >> 16, 15);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 3] = svga->conv_16to32(svga, dat >> 16, 15);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                    p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 15);
+                    p[x + 3] = svga->conv_16to32(svga, dat >> 16, 15);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 5] = svga->conv_16to32(svga, dat >> 16, 15);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                    p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 15);
+                    p[x + 5] = svga->conv_16to32(svga, dat >> 16, 15);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 15);
-                p[x + 7] = svga->conv_16to32(svga, dat >> 16, 15);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                    p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 15);
+                    p[x + 7] = svga->conv_16to32(svga, dat >> 16, 15);
+                }
             }
             svga->ma += x << 1;
             svga->ma &= svga->vram_display_mask;
@@ -1375,22 +1433,27 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+                if ((svga->conv_16to32 == svga_conv_16to32) && svga_span_contig(svga, x << 1)) {
+                    svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 15);
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    }
                 }
                 svga->ma += x << 1;
             } else {
@@ -1576,22 +1639,27 @@ svga_render_16bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                uint32_t dat = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                p[x]         = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 1]     = svga->conv_16to32(svga, dat >> 16, 16);
+            x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+            if ((svga->conv_16to32 == svga_conv_16to32) && svga_span_contig(svga, x << 1)) {
+                svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 16);
+            } else {
+                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                    uint32_t dat = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                    p[x]         = svga->conv_16to32(svga, dat & 0xffff, 16);
+                    p[x + 1]     = svga->conv_16to32(svga, dat >> 16, 16);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 3] = svga->conv_16to32(svga, dat >> 16, 16);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                    p[x + 2] = svga->conv_16to32(svga, dat & 0xffff, 16);
+                    p[x + 3] = svga->conv_16to32(svga, dat >> 16, 16);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 5] = svga->conv_16to32(svga, dat >> 16, 16);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                    p[x + 4] = svga->conv_16to32(svga, dat & 0xffff, 16);
+                    p[x + 5] = svga->conv_16to32(svga, dat >> 16, 16);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 16);
-                p[x + 7] = svga->conv_16to32(svga, dat >> 16, 16);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                    p[x + 6] = svga->conv_16to32(svga, dat & 0xffff, 16);
+                    p[x + 7] = svga->conv_16to32(svga, dat >> 16, 16);
+                }
             }
             svga->ma += x << 1;
             svga->ma &= svga->vram_display_mask;
@@ -1607,22 +1675,27 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+                if ((svga->conv_16to32 == svga_conv_16to32) && svga_span_contig(svga, x << 1)) {
+                    svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 16);
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    }
                 }
                 svga->ma += x << 1;
             } else {
@@ -1740,20 +1813,26 @@ svga_render_24bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
-                dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-                p[x] = lookup_lut(dat & 0xffffff);
+            x = (((svga->hdisp + svga->scrollcache) >> 2) + 1) << 2;
+            if (!svga->lut_map && svga_span_contig(svga, x * 3)) {
+                svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 24);
+                svga->ma += x * 3;
+            } else {
+                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
+                    dat  = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                    p[x] = lookup_lut(dat & 0xffffff);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + 3) & svga->vram_display_mask]);
-                p[x + 1] = lookup_lut(dat & 0xffffff);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + 3) & svga->vram_display_mask]);
+                    p[x + 1] = lookup_lut(dat & 0xffffff);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + 6) & svga->vram_display_mask]);
-                p[x + 2] = lookup_lut(dat & 0xffffff);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + 6) & svga->vram_display_mask]);
+                    p[x + 2] = lookup_lut(dat & 0xffffff);
 
-                dat      = *(uint32_t *) (&svga->vram[(svga->ma + 9) & svga->vram_display_mask]);
-                p[x + 3] = lookup_lut(dat & 0xffffff);
+                    dat      = *(uint32_t *) (&svga->vram[(svga->ma + 9) & svga->vram_display_mask]);
+                    p[x + 3] = lookup_lut(dat & 0xffffff);
 
-                svga->ma += 12;
+                    svga->ma += 12;
+                }
             }
             svga->ma &= svga->vram_display_mask;
         }
@@ -1768,17 +1847,23 @@ svga_render_24bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
-                    dat0 = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-                    dat1 = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
-                    dat2 = *(uint32_t *) (&svga->vram[(svga->ma + 8) & svga->vram_display_mask]);
+                x = (((svga->hdisp + svga->scrollcache) >> 2) + 1) << 2;
+                if (!svga->lut_map && svga_span_contig(svga, x * 3)) {
+                    svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 24);
+                    svga->ma += x * 3;
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
+                        dat0 = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                        dat1 = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
+                        dat2 = *(uint32_t *) (&svga->vram[(svga->ma + 8) & svga->vram_display_mask]);
 
-                    *p++ = lookup_lut(dat0 & 0xffffff);
-                    *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
-                    *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
-                    *p++ = lookup_lut(dat2 >> 8);
+                        *p++ = lookup_lut(dat0 & 0xffffff);
+                        *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
+                        *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
+                        *p++ = lookup_lut(dat2 >> 8);
 
-                    svga->ma += 12;
+                        svga->ma += 12;
+                    }
                 }
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
@@ -1878,9 +1963,14 @@ svga_render_32bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
-                dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
-                p[x] = lookup_lut(dat & 0xffffff);
+            x = svga->hdisp + svga->scrollcache + 1;
+            if (!svga->lut_map && svga_span_contig(svga, x << 2)) {
+                svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 32);
+            } else {
+                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
+                    p[x] = lookup_lut(dat & 0xffffff);
+                }
             }
             svga->ma += 4;
             svga->ma &= svga->vram_display_mask;
@@ -1896,9 +1986,14 @@ svga_render_32bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
-                    *p++ = lookup_lut(dat & 0xffffff);
+                x = svga->hdisp + svga->scrollcache + 1;
+                if (!svga->lut_map && svga_span_contig(svga, x << 2)) {
+                    svga_render_span(svga, p, svga->ma & svga->vram_display_mask, x, 32);
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
+                        *p++ = lookup_lut(dat & 0xffffff);
+                    }
                 }
                 svga->ma += (x * 4);
             } else {
@@ -0,0 +1,404 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          SVGA span rendering.
+ *
+ *          Convert contiguous runs of VRAM pixels with the converters
+ *          in vid_svga_span.c, either right away or, with
+ *          svga_render_threads set, on a pool of worker threads which
+ *          svga_doblit() waits for.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/thread.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_svga_render.h>
+#include <86box/vid_svga_span.h>
+
+/*
+   Render pool.
+
+   The CPU thread appends one job per queued line and publishes them to
+   the workers SPAN_POOL_BATCH lines at a time. Workers (and the CPU
+   thread itself, while waiting) claim published jobs in batches. Each
+   job holds everything the conversion needs, so the renderer state and
+   VRAM may change as soon as the job is queued: the source pixels are
+   copied into the pool's arena, and 8bpp palettes are copied into the
+   pool whenever they change within a frame. Running out of jobs, arena
+   or palettes waits for the queued jobs first.
+ */
+#define SPAN_POOL_THREADS_MAX 8
+#define SPAN_POOL_JOBS        4096
+#define SPAN_POOL_BATCH       16
+#define SPAN_POOL_PALETTES    16
+#define SPAN_POOL_ARENA       (4 << 20)
+
+enum {
+    SPAN_JOB_8 = 0,
+    SPAN_JOB_15,
+    SPAN_JOB_16,
+    SPAN_JOB_24,
+    SPAN_JOB_32
+};
+
+typedef struct span_job_t {
+    uint32_t      *p;
+    const uint8_t *src;
+    int            n;
+    uint8_t   type;
+    uint8_t   mask;
+    uint8_t   pal;
+
+    /* Overscan written after the span, as svga_render_overscan_left()
+       and svga_render_overscan_right() would have done. */
+    struct {
+        uint32_t *p;
+        int       n;
+        uint32_t  color;
+    } fill[2];
+    int nfill;
+} span_job_t;
+
+typedef struct span_pool_t span_pool_t;
+
+typedef struct span_worker_t {
+    span_pool_t *pool;
+    thread_t    *thread;
+    event_t     *wake_event;
+} span_worker_t;
+
+struct span_pool_t {
+    svga_t *svga;
+
+    int           nthreads;
+    span_worker_t worker[SPAN_POOL_THREADS_MAX];
+    event_t      *done_event;
+    atomic_int    run;
+
+    int        queued; /* CPU thread only */
+    atomic_int published;
+    atomic_int next;
+    atomic_int finished;
+
+    int      npal;
+    uint32_t pal[SPAN_POOL_PALETTES][256];
+
+    int      arena_used;
+    uint8_t *arena;
+
+    span_job_t job[SPAN_POOL_JOBS];
+};
+
+static void
+span_job_run(span_pool_t *pool, const span_job_t *job)
+{
+    const uint8_t *src = job->src;
+
+    switch (job->type) {
+        case SPAN_JOB_8:
+            svga_span_8to32(job->p, src, pool->pal[job->pal], job->mask, job->n);
+            break;
+        case SPAN_JOB_15:
+            svga_span_15to32(job->p, src, job->n);
+            break;
+        case SPAN_JOB_16:
+            svga_span_16to32(job->p, src, job->n);
+            break;
+        case SPAN_JOB_24:
+            svga_span_24to32(job->p, src, job->n);
+            break;
+        case SPAN_JOB_32:
+            svga_span_32to32(job->p, src, job->n);
+            break;
+
+        default:
+            break;
+    }
+
+    for (int f = 0; f < job->nfill; f++) {
+        for (int i = 0; i < job->fill[f].n; i++)
+            job->fill[f].p[i] = job->fill[f].color;
+    }
+}
+
+/* Claim and run published jobs until there are none left. */
+static void
+span_pool_drain(span_pool_t *pool)
+{
+    int start;
+    int end;
+    int published;
+
+    for (;;) {
+        start     = atomic_load(&pool->next);
+        published = atomic_load(&pool->published);
+        if (start >= published)
+            break;
+
+        end = start + SPAN_POOL_BATCH;
+        if (end > published)
+            end = published;
+        if (!atomic_compare_exchange_weak(&pool->next, &start, end))
+            continue;
+
+        for (int i = start; i < end; i++)
+            span_job_run(pool, &pool->job[i]);
+
+        if ((atomic_fetch_add(&pool->finished, end - start) + (end - start)) >= published)
+            thread_set_event(pool->done_event);
+    }
+}
+
+static void
+span_pool_thread(void *priv)
+{
+    span_worker_t *worker = (span_worker_t *) priv;
+    span_pool_t   *pool   = worker->pool;
+
+    while (atomic_load(&pool->run)) {
+        thread_wait_event(worker->wake_event, -1);
+        thread_reset_event(worker->wake_event);
+
+        if (!atomic_load(&pool->run))
+            break;
+
+        span_pool_drain(pool);
+    }
+}
+
+static void
+span_pool_publish(span_pool_t *pool, int count)
+{
+    atomic_store(&pool->published, count);
+
+    for (int c = 0; c < pool->nthreads; c++)
+        thread_set_event(pool->worker[c].wake_event);
+}
+
+void
+svga_render_pool_wait(svga_t *svga)
+{
+    span_pool_t *pool = (span_pool_t *) svga->render_pool;
+
+    if (!pool || !pool->queued)
+        return;
+
+    if (atomic_load(&pool->published) != pool->queued)
+        span_pool_publish(pool, pool->queued);
+
+    span_pool_drain(pool);
+
+    while (atomic_load(&pool->finished) < pool->queued) {
+        thread_wait_event(pool->done_event, 1);
+        thread_reset_event(pool->done_event);
+    }
+
+    /* Every job is done, so nothing else touches the counters now. */
+    atomic_store(&pool->published, 0);
+    atomic_store(&pool->next, 0);
+    atomic_store(&pool->finished, 0);
+    pool->queued     = 0;
+    pool->npal       = 0;
+    pool->arena_used = 0;
+}
+
+/* Take the next job and copy its len source bytes (and palette, if any) into
+   the pool. Waiting for the queued jobs, if needed, happens before anything
+   is taken, so that it cannot pull the arena or palettes from under it. */
+static span_job_t *
+span_pool_queue(span_pool_t *pool, uint32_t addr, int len, const uint32_t *pal)
+{
+    span_job_t *job;
+    uint8_t    *src;
+    int         new_pal = pal && (!pool->npal || memcmp(pool->pal[pool->npal - 1], pal, sizeof(pool->pal[0])));
+
+    if ((pool->queued == SPAN_POOL_JOBS) || ((pool->arena_used + len) > SPAN_POOL_ARENA) || (new_pal && (pool->npal == SPAN_POOL_PALETTES))) {
+        svga_render_pool_wait(pool->svga);
+        new_pal = (pal != NULL);
+    }
+
+    job = &pool->job[pool->queued];
+
+    if (new_pal)
+        memcpy(pool->pal[pool->npal++], pal, sizeof(pool->pal[0]));
+    job->pal = pal ? (pool->npal - 1) : 0;
+
+    src = &pool->arena[pool->arena_used];
+    memcpy(src, &pool->svga->vram[addr], len);
+    pool->arena_used += len;
+    job->src = src;
+
+    return job;
+}
+
+/* The newest job is held back from the workers, so that
+   svga_render_pool_fill() can still add to it. */
+static void
+span_pool_commit(span_pool_t *pool)
+{
+    pool->queued++;
+    pool->svga->render_queued = 1;
+
+    if ((pool->queued - 1 - atomic_load(&pool->published)) >= SPAN_POOL_BATCH)
+        span_pool_publish(pool, pool->queued - 1);
+}
+
+void
+svga_render_span_8(svga_t *svga, uint32_t *p, uint32_t addr, int n)
+{
+    span_pool_t *pool = (span_pool_t *) svga->render_pool;
+    span_job_t  *job;
+
+    if (!pool || !svga->render_defer) {
+        svga_span_8to32(p, &svga->vram[addr], svga->map8, svga->dac_mask, n);
+        return;
+    }
+
+    job         = span_pool_queue(pool, addr, n, svga->map8);
+    job->p      = p;
+    job->n      = n;
+    job->type   = SPAN_JOB_8;
+    job->mask   = svga->dac_mask;
+    job->nfill  = 0;
+    span_pool_commit(pool);
+}
+
+void
+svga_render_span(svga_t *svga, uint32_t *p, uint32_t addr, int n, int bpp)
+{
+    span_pool_t *pool = (span_pool_t *) svga->render_pool;
+    span_job_t  *job;
+
+    if (!pool || !svga->render_defer) {
+        switch (bpp) {
+            case 15:
+                svga_span_15to32(p, &svga->vram[addr], n);
+                break;
+            case 16:
+                svga_span_16to32(p, &svga->vram[addr], n);
+                break;
+            case 24:
+                svga_span_24to32(p, &svga->vram[addr], n);
+                break;
+            case 32:
+                svga_span_32to32(p, &svga->vram[addr], n);
+                break;
+
+            default:
+                break;
+        }
+        return;
+    }
+
+    job         = span_pool_queue(pool, addr, n * ((bpp + 7) >> 3), NULL);
+    job->p      = p;
+    job->n      = n;
+    job->type   = (bpp == 15) ? SPAN_JOB_15 : (bpp == 16) ? SPAN_JOB_16 : (bpp == 24) ? SPAN_JOB_24 : SPAN_JOB_32;
+    job->nfill  = 0;
+    span_pool_commit(pool);
+}
+
+/* Attach an overscan fill to the span queued for the current line. With
+   scrollcache > 0 the span starts inside the left overscan, so both fills
+   have to be written after it. */
+void
+svga_render_pool_fill(svga_t *svga, uint32_t *p, int n, uint32_t color)
+{
+    span_pool_t *pool = (span_pool_t *) svga->render_pool;
+    span_job_t  *job  = &pool->job[pool->queued - 1];
+
+    if (job->nfill == (sizeof(job->fill) / sizeof(job->fill[0]))) {
+        svga_render_pool_wait(svga);
+        for (int i = 0; i < n; i++)
+            p[i] = color;
+        return;
+    }
+
+    job->fill[job->nfill].p     = p;
+    job->fill[job->nfill].n     = n;
+    job->fill[job->nfill].color = color;
+    job->nfill++;
+}
+
+void
+svga_render_pool_init(svga_t *svga)
+{
+    span_pool_t *pool;
+    int          threads = svga_render_threads;
+
+    svga->render_pool = NULL;
+
+    if (threads <= 0)
+        return;
+    if (threads > SPAN_POOL_THREADS_MAX)
+        threads = SPAN_POOL_THREADS_MAX;
+
+    pool = (span_pool_t *) calloc(1, sizeof(span_pool_t));
+    if (!pool)
+        return;
+
+    pool->arena = (uint8_t *) malloc(SPAN_POOL_ARENA);
+    if (!pool->arena) {
+        free(pool);
+        return;
+    }
+
+    pool->svga       = svga;
+    pool->nthreads   = threads;
+    pool->done_event = thread_create_event();
+    atomic_store(&pool->run, 1);
+
+    for (int c = 0; c < threads; c++) {
+        pool->worker[c].pool       = pool;
+        pool->worker[c].wake_event = thread_create_event();
+        pool->worker[c].thread     = thread_create(span_pool_thread, &pool->worker[c]);
+    }
+
+    svga->render_pool = pool;
+}
+
+void
+svga_render_pool_close(svga_t *svga)
+{
+    span_pool_t *pool = (span_pool_t *) svga->render_pool;
+
+    if (!pool)
+        return;
+
+    svga_render_pool_wait(svga);
+
+    atomic_store(&pool->run, 0);
+    for (int c = 0; c < pool->nthreads; c++) {
+        thread_set_event(pool->worker[c].wake_event);
+        thread_wait(pool->worker[c].thread);
+        thread_destroy_event(pool->worker[c].wake_event);
+    }
+    thread_destroy_event(pool->done_event);
+
+    free(pool->arena);
+    free(pool);
+    svga->render_pool = NULL;
+}
@@ -0,0 +1,427 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          SVGA span converters.
+ *
+ *          Convert a contiguous run of packed pixels from VRAM into
+ *          32bpp target buffer pixels. The scalar versions produce the
+ *          same output as the per-pixel code in vid_svga_render.c; the
+ *          SSE2/SSSE3/AVX2/NEON versions are picked once at startup
+ *          based on the host CPU. bench/span_bench.c checks each of
+ *          them against the scalar version and times them.
+ *
+ *
+ *
+ * Authors: The 86Box team.
+ *
+ *          Copyright 2026 The 86Box team.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/video.h>
+#include <86box/vid_svga_span.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#    define SPAN_X86
+#    define SPAN_TARGET(t) __attribute__((target(t)))
+#    include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#    define SPAN_X86
+#    define SPAN_X86_SSE2_ONLY
+#    define SPAN_TARGET(t)
+#    include <intrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define SPAN_NEON
+#    include <arm_neon.h>
+#endif
+
+
+enum {
+    SPAN_CPU_NONE = 0,
+    SPAN_CPU_SSE2,
+    SPAN_CPU_SSSE3,
+    SPAN_CPU_AVX2
+};
+
+void (*svga_span_8to32)(uint32_t *p, const uint8_t *src, const uint32_t *pal, uint8_t mask, int n);
+void (*svga_span_15to32)(uint32_t *p, const uint8_t *src, int n);
+void (*svga_span_16to32)(uint32_t *p, const uint8_t *src, int n);
+void (*svga_span_24to32)(uint32_t *p, const uint8_t *src, int n);
+void (*svga_span_32to32)(uint32_t *p, const uint8_t *src, int n);
+
+/* Scalar versions, also used for the tails of the vector ones. */
+static void
+span_8to32_c(uint32_t *p, const uint8_t *src, const uint32_t *pal, uint8_t mask, int n)
+{
+    for (int i = 0; i < n; i++)
+        p[i] = pal[src[i] & mask];
+}
+
+static void
+span_15to32_c(uint32_t *p, const uint8_t *src, int n)
+{
+    for (int i = 0; i < n; i++)
+        p[i] = video_15to32[src[i << 1] | (src[(i << 1) + 1] << 8)];
+}
+
+static void
+span_16to32_c(uint32_t *p, const uint8_t *src, int n)
+{
+    for (int i = 0; i < n; i++)
+        p[i] = video_16to32[src[i << 1] | (src[(i << 1) + 1] << 8)];
+}
+
+static void
+span_24to32_c(uint32_t *p, const uint8_t *src, int n)
+{
+    for (int i = 0; i < n; i++)
+        p[i] = src[i * 3] | (src[(i * 3) + 1] << 8) | (src[(i * 3) + 2] << 16);
+}
+
+static void
+span_32to32_c(uint32_t *p, const uint8_t *src, int n)
+{
+    for (int i = 0; i < n; i++)
+        p[i] = src[i << 2] | (src[(i << 2) + 1] << 8) | (src[(i << 2) + 2] << 16);
+}
+
+/*
+   The 5-bit and 6-bit channel expansions below are integer forms of the
+   conversion done by calc_15to32() and calc_16to32() in video.c:
+       5 -> 8 bits: (x * 1053) >> 7
+       6 -> 8 bits: (x * 259 + 3) >> 6
+   Both give the same result as the lookup tables for every input value,
+   and neither overflows a 16-bit lane.
+ */
+#ifdef SPAN_X86
+SPAN_TARGET("sse2")
+static void
+span_15to32_sse2(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m128i m5 = _mm_set1_epi16(0x1f);
+    const __m128i k5 = _mm_set1_epi16(1053);
+    int           i  = 0;
+
+    for (; (i + 8) <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[i << 1]);
+        __m128i b = _mm_and_si128(v, m5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), m5);
+        __m128i r = _mm_and_si128(_mm_srli_epi16(v, 10), m5);
+
+        b = _mm_srli_epi16(_mm_mullo_epi16(b, k5), 7);
+        g = _mm_srli_epi16(_mm_mullo_epi16(g, k5), 7);
+        r = _mm_srli_epi16(_mm_mullo_epi16(r, k5), 7);
+
+        __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i *) &p[i], _mm_unpacklo_epi16(bg, r));
+        _mm_storeu_si128((__m128i *) &p[i + 4], _mm_unpackhi_epi16(bg, r));
+    }
+
+    span_15to32_c(&p[i], &src[i << 1], n - i);
+}
+
+SPAN_TARGET("sse2")
+static void
+span_16to32_sse2(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m128i m5 = _mm_set1_epi16(0x1f);
+    const __m128i m6 = _mm_set1_epi16(0x3f);
+    const __m128i k5 = _mm_set1_epi16(1053);
+    const __m128i k6 = _mm_set1_epi16(259);
+    const __m128i r6 = _mm_set1_epi16(3);
+    int           i  = 0;
+
+    for (; (i + 8) <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[i << 1]);
+        __m128i b = _mm_and_si128(v, m5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), m6);
+        __m128i r = _mm_srli_epi16(v, 11);
+
+        b = _mm_srli_epi16(_mm_mullo_epi16(b, k5), 7);
+        g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, k6), r6), 6);
+        r = _mm_srli_epi16(_mm_mullo_epi16(r, k5), 7);
+
+        __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i *) &p[i], _mm_unpacklo_epi16(bg, r));
+        _mm_storeu_si128((__m128i *) &p[i + 4], _mm_unpackhi_epi16(bg, r));
+    }
+
+    span_16to32_c(&p[i], &src[i << 1], n - i);
+}
+
+SPAN_TARGET("sse2")
+static void
+span_32to32_sse2(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m128i m24 = _mm_set1_epi32(0x00ffffff);
+    int           i   = 0;
+
+    for (; (i + 4) <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[i << 2]);
+        _mm_storeu_si128((__m128i *) &p[i], _mm_and_si128(v, m24));
+    }
+
+    span_32to32_c(&p[i], &src[i << 2], n - i);
+}
+
+#    ifndef SPAN_X86_SSE2_ONLY
+SPAN_TARGET("ssse3")
+static void
+span_24to32_ssse3(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m128i shuf = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                       6, 7, 8, -1, 9, 10, 11, -1);
+    int           i    = 0;
+
+    /* Each load reads 16 bytes for 12 bytes of pixels, so stop early
+       enough not to run past the end of the span. */
+    for (; (i + 6) <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[i * 3]);
+        _mm_storeu_si128((__m128i *) &p[i], _mm_shuffle_epi8(v, shuf));
+    }
+
+    span_24to32_c(&p[i], &src[i * 3], n - i);
+}
+
+SPAN_TARGET("avx2")
+static void
+span_8to32_avx2(uint32_t *p, const uint8_t *src, const uint32_t *pal, uint8_t mask, int n)
+{
+    const __m256i m8 = _mm256_set1_epi32(mask);
+    int           i  = 0;
+
+    for (; (i + 8) <= n; i += 8) {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) &src[i]));
+        idx         = _mm256_and_si256(idx, m8);
+        _mm256_storeu_si256((__m256i *) &p[i], _mm256_i32gather_epi32((const int *) pal, idx, 4));
+    }
+
+    span_8to32_c(&p[i], &src[i], pal, mask, n - i);
+}
+
+SPAN_TARGET("avx2")
+static void
+span_15to32_avx2(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m256i m5 = _mm256_set1_epi16(0x1f);
+    const __m256i k5 = _mm256_set1_epi16(1053);
+    int           i  = 0;
+
+    for (; (i + 16) <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) &src[i << 1]);
+        __m256i b = _mm256_and_si256(v, m5);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(v, 5), m5);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi16(v, 10), m5);
+
+        b = _mm256_srli_epi16(_mm256_mullo_epi16(b, k5), 7);
+        g = _mm256_srli_epi16(_mm256_mullo_epi16(g, k5), 7);
+        r = _mm256_srli_epi16(_mm256_mullo_epi16(r, k5), 7);
+
+        /* The unpacks work within each 128-bit lane, so put the halves
+           back in pixel order when storing. */
+        __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+        __m256i lo = _mm256_unpacklo_epi16(bg, r);
+        __m256i hi = _mm256_unpackhi_epi16(bg, r);
+        _mm256_storeu_si256((__m256i *) &p[i], _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *) &p[i + 8], _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    span_15to32_sse2(&p[i], &src[i << 1], n - i);
+}
+
+SPAN_TARGET("avx2")
+static void
+span_16to32_avx2(uint32_t *p, const uint8_t *src, int n)
+{
+    const __m256i m5 = _mm256_set1_epi16(0x1f);
+    const __m256i m6 = _mm256_set1_epi16(0x3f);
+    const __m256i k5 = _mm256_set1_epi16(1053);
+    const __m256i k6 = _mm256_set1_epi16(259);
+    const __m256i r6 = _mm256_set1_epi16(3);
+    int           i  = 0;
+
+    for (; (i + 16) <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) &src[i << 1]);
+        __m256i b = _mm256_and_si256(v, m5);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(v, 5), m6);
+        __m256i r = _mm256_srli_epi16(v, 11);
+
+        b = _mm256_srli_epi16(_mm256_mullo_epi16(b, k5), 7);
+        g = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(g, k6), r6), 6);
+        r = _mm256_srli_epi16(_mm256_mullo_epi16(r, k5), 7);
+
+        __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+        __m256i lo = _mm256_unpacklo_epi16(bg, r);
+        __m256i hi = _mm256_unpackhi_epi16(bg, r);
+        _mm256_storeu_si256((__m256i *) &p[i], _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *) &p[i + 8], _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    span_16to32_sse2(&p[i], &src[i << 1], n - i);
+}
+#    endif
+#endif
+
+#ifdef SPAN_NEON
+static void
+span_15to32_neon(uint32_t *p, const uint8_t *src, int n)
+{
+    const uint16x8_t m5 = vdupq_n_u16(0x1f);
+    int              i  = 0;
+    uint8x8x4_t      o;
+
+    o.val[3] = vdup_n_u8(0);
+    for (; (i + 8) <= n; i += 8) {
+        uint16x8_t v = vld1q_u16((const uint16_t *) &src[i << 1]);
+        uint16x8_t b = vandq_u16(v, m5);
+        uint16x8_t g = vandq_u16(vshrq_n_u16(v, 5), m5);
+        uint16x8_t r = vandq_u16(vshrq_n_u16(v, 10), m5);
+
+        o.val[0] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(b, 1053), 7));
+        o.val[1] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(g, 1053), 7));
+        o.val[2] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(r, 1053), 7));
+        vst4_u8((uint8_t *) &p[i], o);
+    }
+
+    span_15to32_c(&p[i], &src[i << 1], n - i);
+}
+
+static void
+span_16to32_neon(uint32_t *p, const uint8_t *src, int n)
+{
+    const uint16x8_t m5 = vdupq_n_u16(0x1f);
+    const uint16x8_t m6 = vdupq_n_u16(0x3f);
+    const uint16x8_t r6 = vdupq_n_u16(3);
+    int              i  = 0;
+    uint8x8x4_t      o;
+
+    o.val[3] = vdup_n_u8(0);
+    for (; (i + 8) <= n; i += 8) {
+        uint16x8_t v = vld1q_u16((const uint16_t *) &src[i << 1]);
+        uint16x8_t b = vandq_u16(v, m5);
+        uint16x8_t g = vandq_u16(vshrq_n_u16(v, 5), m6);
+        uint16x8_t r = vshrq_n_u16(v, 11);
+
+        o.val[0] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(b, 1053), 7));
+        o.val[1] = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(r6, g, 259), 6));
+        o.val[2] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(r, 1053), 7));
+        vst4_u8((uint8_t *) &p[i], o);
+    }
+
+    span_16to32_c(&p[i], &src[i << 1], n - i);
+}
+
+static void
+span_24to32_neon(uint32_t *p, const uint8_t *src, int n)
+{
+    int         i = 0;
+    uint8x8x3_t v;
+    uint8x8x4_t o;
+
+    o.val[3] = vdup_n_u8(0);
+    for (; (i + 8) <= n; i += 8) {
+        v        = vld3_u8(&src[i * 3]);
+        o.val[0] = v.val[0];
+        o.val[1] = v.val[1];
+        o.val[2] = v.val[2];
+        vst4_u8((uint8_t *) &p[i], o);
+    }
+
+    span_24to32_c(&p[i], &src[i * 3], n - i);
+}
+
+static void
+span_32to32_neon(uint32_t *p, const uint8_t *src, int n)
+{
+    const uint32x4_t m24 = vdupq_n_u32(0x00ffffff);
+    int              i   = 0;
+
+    for (; (i + 4) <= n; i += 4)
+        vst1q_u32(&p[i], vandq_u32(vld1q_u32((const uint32_t *) &src[i << 2]), m24));
+
+    span_32to32_c(&p[i], &src[i << 2], n - i);
+}
+#endif
+
+/* Each set only holds the converters it improves on, the others are taken
+   from the sets before it. */
+static const svga_span_impl_t span_impls[] = {
+  // clang-format off
+    { "c",     SPAN_CPU_NONE,  span_8to32_c,    span_15to32_c,    span_16to32_c,    span_24to32_c,     span_32to32_c    },
+#ifdef SPAN_X86
+    { "sse2",  SPAN_CPU_SSE2,  NULL,            span_15to32_sse2, span_16to32_sse2, NULL,              span_32to32_sse2 },
+#    ifndef SPAN_X86_SSE2_ONLY
+    { "ssse3", SPAN_CPU_SSSE3, NULL,            NULL,             NULL,             span_24to32_ssse3, NULL             },
+    { "avx2",  SPAN_CPU_AVX2,  span_8to32_avx2, span_15to32_avx2, span_16to32_avx2, NULL,              NULL             },
+#    endif
+#elif defined(SPAN_NEON)
+    { "neon",  SPAN_CPU_NONE,  NULL,            span_15to32_neon, span_16to32_neon, span_24to32_neon,  span_32to32_neon },
+#endif
+  // clang-format on
+};
+
+static int
+span_cpu_supports(int cpu)
+{
+#if defined(SPAN_X86) && !defined(SPAN_X86_SSE2_ONLY)
+    __builtin_cpu_init();
+
+    switch (cpu) {
+        case SPAN_CPU_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case SPAN_CPU_SSSE3:
+            return __builtin_cpu_supports("ssse3");
+        case SPAN_CPU_AVX2:
+            return __builtin_cpu_supports("avx2");
+
+        default:
+            break;
+    }
+#else
+    (void) cpu;
+#endif
+
+    return 1;
+}
+
+int
+svga_span_get_impls(const svga_span_impl_t **impls, int max)
+{
+    int num = 0;
+
+    for (size_t c = 0; c < (sizeof(span_impls) / sizeof(span_impls[0])); c++) {
+        if ((num < max) && span_cpu_supports(span_impls[c].cpu))
+            impls[num++] = &span_impls[c];
+    }
+
+    return num;
+}
+
+void
+svga_span_init(void)
+{
+    const svga_span_impl_t *impls[SVGA_SPAN_IMPLS_MAX];
+    int                     num = svga_span_get_impls(impls, SVGA_SPAN_IMPLS_MAX);
+
+    for (int c = 0; c < num; c++) {
+        if (impls[c]->span_8to32)
+            svga_span_8to32 = impls[c]->span_8to32;
+        if (impls[c]->span_15to32)
+            svga_span_15to32 = impls[c]->span_15to32;
+        if (impls[c]->span_16to32)
+            svga_span_16to32 = impls[c]->span_16to32;
+        if (impls[c]->span_24to32)
+            svga_span_24to32 = impls[c]->span_24to32;
+        if (impls[c]->span_32to32)
+            svga_span_32to32 = impls[c]->span_32to32;
+    }
+}
@@ -93,13 +93,17 @@ voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val)
 {
     fifo_entry_t *fifo = &voodoo->fifo[voodoo->fifo_write_idx & FIFO_MASK];
 
-    while (FIFO_FULL) {
-        thread_reset_event(voodoo->fifo_not_full_event);
-        if (FIFO_FULL) {
-            thread_wait_event(voodoo->fifo_not_full_event, 1); /*Wait for room in ringbuffer*/
-            if (FIFO_FULL)
-                voodoo_wake_fifo_thread_now(voodoo);
+    if (FIFO_FULL) {
+        voodoo->fifo_producer_waiting = 1;
+        while (FIFO_FULL) {
+            thread_reset_event(voodoo->fifo_not_full_event);
+            if (FIFO_FULL) {
+                thread_wait_event(voodoo->fifo_not_full_event, 1); /*Wait for room in ringbuffer*/
+                if (FIFO_FULL)
+                    voodoo_wake_fifo_thread_now(voodoo);
+            }
         }
+        voodoo->fifo_producer_waiting = 0;
     }
 
     fifo->val       = val;
@@ -309,7 +313,7 @@ voodoo_fifo_thread(void *param)
                     fatal("Unknown fifo entry %08x\n", fifo->addr_type);
             }
 
-            if (FIFO_ENTRIES > 0xe000)
+            if (voodoo->fifo_producer_waiting && FIFO_ENTRIES > 0xe000)
                 thread_set_event(voodoo->fifo_not_full_event);
 
             end_time = plat_timer_read();
@@ -104,6 +104,7 @@ voodoo_reg_writel(uint32_t addr, uint32_t val, void *priv)
 #endif
 
                 voodoo_wait_for_render_thread_idle(voodoo);
+                voodoo_render_balance(voodoo);
                 if (!(val & 1)) {
                     banshee_set_overlay_addr(voodoo->priv, voodoo->leftOverlayBuf);
                     thread_wait_mutex(voodoo->swap_mutex);
@@ -145,6 +146,7 @@ voodoo_reg_writel(uint32_t addr, uint32_t val, void *priv)
             voodoo->front_offset = params->front_offset;
 #endif
             voodoo_wait_for_render_thread_idle(voodoo);
+            voodoo_render_balance(voodoo);
             if (!(val & 1)) {
                 memset(voodoo->dirty_line, 1, sizeof(voodoo->dirty_line));
                 voodoo->front_offset = voodoo->params.front_offset;
@@ -17,6 +17,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -664,6 +665,191 @@ voodoo_tmu_fetch_and_blend(voodoo_t *voodoo, voodoo_params_t *params, voodoo_sta
 int voodoo_recomp = 0;
 #endif
 
+/*Bands are kept at least this many scanlines high, and start out splitting
+  this many scanlines evenly until the first rebalance.*/
+#define VOODOO_BAND_MIN    8
+#define VOODOO_BAND_HEIGHT 480
+/*Stands in for no limit at the ends of the first and last bands.*/
+#define VOODOO_BAND_INF (1 << 20)
+
+/*Moves the start of the triangle down by dy scanlines.*/
+static void
+voodoo_skip_lines(voodoo_state_t *state, voodoo_params_t *params, int dy)
+{
+    state->base_r += params->dRdY * dy;
+    state->base_g += params->dGdY * dy;
+    state->base_b += params->dBdY * dy;
+    state->base_a += params->dAdY * dy;
+    state->base_z += params->dZdY * dy;
+    state->tmu[0].base_s += params->tmu[0].dSdY * dy;
+    state->tmu[0].base_t += params->tmu[0].dTdY * dy;
+    state->tmu[0].base_w += params->tmu[0].dWdY * dy;
+    state->tmu[1].base_s += params->tmu[1].dSdY * dy;
+    state->tmu[1].base_t += params->tmu[1].dTdY * dy;
+    state->tmu[1].base_w += params->tmu[1].dWdY * dy;
+    state->base_w += params->dWdY * dy;
+    state->xstart += state->dx1 * dy;
+    state->xend += state->dx2 * dy;
+}
+
+/*Returns the mask of the render threads whose bands the triangle covers.
+  Band scanlines are counted after Y origin flipping, and per card in SLI.*/
+static uint32_t
+voodoo_triangle_threads(voodoo_t *voodoo, voodoo_params_t *params)
+{
+    int      y_shift  = SLI_ENABLED ? 1 : 0;
+    int      y_origin = (voodoo->type >= VOODOO_BANSHEE) ? voodoo->y_origin_swap : (voodoo->v_disp - 1);
+    int      ystart   = ((int16_t) params->vertexAy + 7) >> 4;
+    int      yend     = ((int16_t) params->vertexCy + 7) >> 4;
+    int      lo;
+    int      hi;
+    uint32_t mask = 0;
+
+    if (params->fbzMode & 1) {
+        ystart = MAX(ystart, params->clipLowY);
+        yend   = MIN(yend, params->clipHighY);
+    }
+    if (ystart >= yend)
+        return 0;
+
+    if (params->fbzMode & (1 << 17)) {
+        lo = y_origin - (yend - 1);
+        hi = y_origin - ystart;
+    } else {
+        lo = ystart;
+        hi = yend - 1;
+    }
+    lo >>= y_shift;
+    hi >>= y_shift;
+
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if ((voodoo->render_band[c] <= hi) && (voodoo->render_band[c + 1] > lo))
+            mask |= (1 << c);
+    }
+
+    return mask;
+}
+
+static int
+voodoo_band_height(voodoo_t *voodoo)
+{
+    int height = SLI_ENABLED ? (voodoo->v_disp >> 1) : voodoo->v_disp;
+
+    if (height <= 0)
+        height = VOODOO_BAND_HEIGHT;
+
+    return MAX(height, voodoo->render_threads * VOODOO_BAND_MIN);
+}
+
+void
+voodoo_render_balance_init(voodoo_t *voodoo)
+{
+    const int threads = voodoo->render_threads;
+    const int height  = MAX(VOODOO_BAND_HEIGHT, threads * VOODOO_BAND_MIN);
+
+    for (int c = 1; c < threads; c++)
+        voodoo->render_band[c] = (height * c) / threads;
+    voodoo->render_band[0]       = -VOODOO_BAND_INF;
+    voodoo->render_band[threads] = VOODOO_BAND_INF;
+}
+
+/*Moves the band boundaries so that each thread would have been busy for the
+  same time over the last frame, assuming the cost of a band was spread evenly
+  over its scanlines. Only half the move is made each time, so that a single
+  odd frame does not throw the split off. The render threads have to be idle.*/
+void
+voodoo_render_balance(voodoo_t *voodoo)
+{
+    const int threads = voodoo->render_threads;
+    const int height  = voodoo_band_height(voodoo);
+    uint64_t  work[VOODOO_MAX_RENDER_THREADS];
+    int       start[VOODOO_MAX_RENDER_THREADS + 1];
+    double    total   = 0.0;
+    double    spread  = 0.0;
+    double    reached = 0.0;
+    double    share;
+    double    cost;
+    int       band = 0;
+    int       line = 0;
+
+    if (threads < 2)
+        return;
+
+    for (int c = 0; c < threads; c++) {
+        voodoo_thread_stats_t *stats = &voodoo->thread_stats[c];
+
+        work[c]             = stats->busy_time - stats->balance_time;
+        stats->balance_time = stats->busy_time;
+        total += (double) work[c];
+    }
+    if (total == 0.0)
+        return;
+
+    for (int c = 0; c <= threads; c++)
+        start[c] = MIN(MAX(voodoo->render_band[c], 0), height);
+    start[0]       = 0;
+    start[threads] = height;
+
+    /*Bands that are not on screen cannot be measured, their work is spread
+      over the whole screen instead.*/
+    for (int c = 0; c < threads; c++) {
+        if (start[c + 1] == start[c])
+            spread += (double) work[c];
+    }
+    spread /= (double) height;
+    share = total / (double) threads;
+
+    for (int c = 1; c < threads; c++) {
+        const double target = share * c;
+        int          cut;
+
+        /*Walk the old bands until the work covered reaches this cut.*/
+        for (;;) {
+            const int lines = start[band + 1] - start[band];
+
+            cost = (lines ? ((double) work[band] / (double) lines) : 0.0) + spread;
+            if ((band == (threads - 1)) || ((reached + cost * (start[band + 1] - line)) >= target))
+                break;
+
+            reached += cost * (start[band + 1] - line);
+            line = start[band + 1];
+            band++;
+        }
+        cut = line + ((cost > 0.0) ? (int) ((target - reached) / cost) : 0);
+        cut = MIN(cut, start[band + 1]);
+
+        reached += cost * (cut - line);
+        line = cut;
+
+        voodoo->render_band[c] = (start[c] + cut + 1) >> 1;
+    }
+
+    /*Keep every band at least VOODOO_BAND_MIN scanlines high.*/
+    for (int c = 1; c < threads; c++) {
+        voodoo->render_band[c] = MAX(voodoo->render_band[c], ((c == 1) ? 0 : voodoo->render_band[c - 1]) + VOODOO_BAND_MIN);
+        voodoo->render_band[c] = MIN(voodoo->render_band[c], height - (threads - c) * VOODOO_BAND_MIN);
+    }
+}
+
+void
+voodoo_get_stats(voodoo_t *voodoo, voodoo_stats_t *stats)
+{
+    memset(stats, 0, sizeof(voodoo_stats_t));
+
+    stats->render_threads = voodoo->render_threads;
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        stats->busy_us[c]    = (voodoo->thread_stats[c].busy_time * 1000000) / timer_freq;
+        stats->triangles[c]  = voodoo->thread_stats[c].triangles;
+        stats->band_start[c] = MAX(voodoo->render_band[c], 0);
+        stats->codegen_hits += voodoo->thread_stats[c].codegen_hits;
+        stats->codegen_misses += voodoo->thread_stats[c].codegen_misses;
+    }
+
+    stats->texture_hits      = voodoo->texture_hits;
+    stats->texture_misses    = voodoo->texture_misses;
+    stats->texture_evictions = voodoo->texture_evictions;
+}
+
 static void
 voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int ystart, int yend, int odd_even)
 {
@@ -729,29 +915,29 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
     state->tex_lod[1]    = params->tex_lod[1];
 
     if ((params->fbzMode & 1) && (ystart < params->clipLowY)) {
-        int dy = params->clipLowY - ystart;
-
-        state->base_r += params->dRdY * dy;
-        state->base_g += params->dGdY * dy;
-        state->base_b += params->dBdY * dy;
-        state->base_a += params->dAdY * dy;
-        state->base_z += params->dZdY * dy;
-        state->tmu[0].base_s += params->tmu[0].dSdY * dy;
-        state->tmu[0].base_t += params->tmu[0].dTdY * dy;
-        state->tmu[0].base_w += params->tmu[0].dWdY * dy;
-        state->tmu[1].base_s += params->tmu[1].dSdY * dy;
-        state->tmu[1].base_t += params->tmu[1].dTdY * dy;
-        state->tmu[1].base_w += params->tmu[1].dWdY * dy;
-        state->base_w += params->dWdY * dy;
-        state->xstart += state->dx1 * dy;
-        state->xend += state->dx2 * dy;
-
+        voodoo_skip_lines(state, params, params->clipLowY - ystart);
         ystart = params->clipLowY;
     }
 
     if ((params->fbzMode & 1) && (yend >= params->clipHighY))
         yend = params->clipHighY;
 
+    /*Only draw the scanlines of this thread's band.*/
+    if (voodoo->render_threads > 1) {
+        int y_shift = SLI_ENABLED ? 1 : 0;
+        int band_lo = voodoo->render_band[odd_even] << y_shift;
+        int band_hi = voodoo->render_band[odd_even + 1] << y_shift;
+        int y_lo    = (params->fbzMode & (1 << 17)) ? (y_origin - band_hi + 1) : band_lo;
+        int y_hi    = (params->fbzMode & (1 << 17)) ? (y_origin - band_lo + 1) : band_hi;
+
+        if (yend > y_hi)
+            yend = y_hi;
+        if ((ystart < y_lo) && (y_lo < yend)) {
+            voodoo_skip_lines(state, params, y_lo - ystart);
+            ystart = y_lo;
+        }
+    }
+
     state->y = ystart;
 #if 0
     yend--;
@@ -830,14 +1016,6 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         else
             real_y >>= 4;
 
-        if (SLI_ENABLED) {
-            if (((real_y >> 1) & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        } else {
-            if ((real_y & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        }
-
         start_x = x;
 
         if (state->xdir > 0)
@@ -1387,6 +1565,11 @@ next_line:
         state->xend += state->dx2;
     }
 
+#ifndef NO_CODEGEN
+    if (voodoo_draw)
+        voodoo_put_block(voodoo, odd_even);
+#endif
+
     voodoo->texture_cache[0][params->tex_entry[0]].refcount_r[odd_even]++;
     voodoo->texture_cache[1][params->tex_entry[1]].refcount_r[odd_even]++;
 }
@@ -1540,30 +1723,36 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
 }
 
 static void
-render_thread(void *param, int odd_even)
+render_thread(voodoo_t *voodoo, int odd_even)
 {
-    voodoo_t *voodoo = (voodoo_t *) param;
+    voodoo_thread_stats_t *stats = &voodoo->thread_stats[odd_even];
 
     while (voodoo->render_thread_run[odd_even]) {
         thread_set_event(voodoo->render_not_full_event[odd_even]);
-        thread_wait_event(voodoo->wake_render_thread[odd_even], -1);
+        /*The producer only signals the wake event while this is set, so the
+          ring has to be checked again after setting it.*/
+        voodoo->render_thread_sleeping[odd_even] = 1;
+        if (PARAM_EMPTY(odd_even))
+            thread_wait_event(voodoo->wake_render_thread[odd_even], -1);
+        voodoo->render_thread_sleeping[odd_even] = 0;
         thread_reset_event(voodoo->wake_render_thread[odd_even]);
         voodoo->render_voodoo_busy[odd_even] = 1;
 
         while (!PARAM_EMPTY(odd_even)) {
             uint64_t         start_time = plat_timer_read();
-            uint64_t         end_time;
-            voodoo_params_t *params = &voodoo->params_buffer[voodoo->params_read_idx[odd_even] & PARAM_MASK];
+            int              idx        = voodoo->render_queue[odd_even][voodoo->render_queue_read[odd_even] & PARAM_MASK];
+            voodoo_params_t *params     = &voodoo->params_buffer[idx & PARAM_MASK];
 
+            voodoo->params_read_idx[odd_even] = idx;
             voodoo_triangle(voodoo, params, odd_even);
 
-            voodoo->params_read_idx[odd_even]++;
+            voodoo->render_queue_read[odd_even]++;
 
-            if (PARAM_ENTRIES(odd_even) > (PARAM_SIZE - 10))
+            if (voodoo->params_producer_waiting)
                 thread_set_event(voodoo->render_not_full_event[odd_even]);
 
-            end_time = plat_timer_read();
-            voodoo->render_time[odd_even] += end_time - start_time;
+            stats->busy_time += plat_timer_read() - start_time;
+            stats->triangles++;
         }
 
         voodoo->render_voodoo_busy[odd_even] = 0;
@@ -1571,47 +1760,30 @@ render_thread(void *param, int odd_even)
 }
 
 void
-voodoo_render_thread_1(void *param)
-{
-    render_thread(param, 0);
-}
-void
-voodoo_render_thread_2(void *param)
+voodoo_render_thread(void *param)
 {
-    render_thread(param, 1);
-}
-void
-voodoo_render_thread_3(void *param)
-{
-    render_thread(param, 2);
-}
-void
-voodoo_render_thread_4(void *param)
-{
-    render_thread(param, 3);
+    struct voodoo_render_thread_t *thread = (struct voodoo_render_thread_t *) param;
+
+    render_thread(thread->voodoo, thread->idx);
 }
 
 void
 voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
     voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
-
-    while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) || (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3)))) {
-        thread_reset_event(voodoo->render_not_full_event[0]);
-        if (voodoo->render_threads >= 2)
-            thread_reset_event(voodoo->render_not_full_event[1]);
-        if (voodoo->render_threads == 4) {
-            thread_reset_event(voodoo->render_not_full_event[2]);
-            thread_reset_event(voodoo->render_not_full_event[3]);
+    uint32_t         mask;
+
+    if (voodoo_render_params_full(voodoo)) {
+        voodoo->params_producer_waiting = 1;
+        while (voodoo_render_params_full(voodoo)) {
+            for (int c = 0; c < voodoo->render_threads; c++)
+                thread_reset_event(voodoo->render_not_full_event[c]);
+            for (int c = 0; c < voodoo->render_threads; c++) {
+                if (PARAM_FULL(c))
+                    thread_wait_event(voodoo->render_not_full_event[c], -1); /*Wait for room in ringbuffer*/
+            }
         }
-        if (PARAM_FULL(0))
-            thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-            thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(2))
-            thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(3))
-            thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
+        voodoo->params_producer_waiting = 0;
     }
 
     voodoo_use_texture(voodoo, params, 0);
@@ -1620,8 +1792,23 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 
     memcpy(params_new, params, sizeof(voodoo_params_t));
 
+    /*Each thread only gets the triangles that cover its band. The texture
+      references of the others are dropped right away.*/
+    mask = (voodoo->render_threads > 1) ? voodoo_triangle_threads(voodoo, params_new) : 1;
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (mask & (1 << c)) {
+            voodoo->render_queue[c][voodoo->render_queue_write[c] & PARAM_MASK] = voodoo->params_write_idx;
+            voodoo->render_queue_write[c]++;
+        } else {
+            voodoo->texture_cache[0][params_new->tex_entry[0]].refcount_r[c]++;
+            voodoo->texture_cache[1][params_new->tex_entry[1]].refcount_r[c]++;
+        }
+    }
+
     voodoo->params_write_idx++;
 
-    if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) || (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
-        voodoo_wake_render_thread(voodoo);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if ((mask & (1 << c)) && voodoo->render_thread_sleeping[c])
+            thread_set_event(voodoo->wake_render_thread[c]);
+    }
 }
@@ -17,6 +17,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -239,6 +240,112 @@ voodoo_recalc_tex3(voodoo_t *voodoo, int tmu)
 
 #define makergba(r, g, b, a) ((b) | ((g) << 8) | ((r) << 16) | ((a) << 24))
 
+/*A cache entry is in use while any render thread has yet to consume a
+  triangle that references it.*/
+static int
+voodoo_texture_in_use(voodoo_t *voodoo, texture_t *texture)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (texture->refcount != texture->refcount_r[c])
+            return 1;
+    }
+
+    return 0;
+}
+
+#define TEX_DATA_SIZE ((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4)
+
+#define TEX_HASH(base, tLOD, palette_checksum) ((((base) >> 3) ^ ((base) >> 11) ^ (tLOD) ^ ((tLOD) >> 20) ^ (palette_checksum)) & (TEX_HASH_SIZE - 1))
+
+void
+voodoo_texture_cache_init(voodoo_t *voodoo)
+{
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        for (int c = 0; c < TEX_CACHE_MAX; c++) {
+            voodoo->texture_cache[tmu][c].data      = NULL; /*allocated on first use*/
+            voodoo->texture_cache[tmu][c].base      = -1;   /*invalid*/
+            voodoo->texture_cache[tmu][c].refcount  = 0;
+            voodoo->texture_cache[tmu][c].hash_next = -1;
+        }
+        for (int c = 0; c < TEX_HASH_SIZE; c++)
+            voodoo->texture_hash[tmu][c] = -1;
+    }
+
+    memset(voodoo->texture_page_entries, 0, sizeof(voodoo->texture_page_entries));
+    memset(voodoo->texture_present, 0, sizeof(voodoo->texture_present));
+}
+
+void
+voodoo_texture_cache_close(voodoo_t *voodoo)
+{
+    voodoo_stats_t stats;
+
+    voodoo_get_stats(voodoo, &stats);
+    voodoo_texture_log("Texture cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions\n",
+                       stats.texture_hits, stats.texture_misses, stats.texture_evictions);
+
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        for (int c = 0; c < TEX_CACHE_MAX; c++)
+            free(voodoo->texture_cache[tmu][c].data);
+    }
+}
+
+/*Adds or removes cache entry c in the page index, which records for each
+  TEX_DIRTY_SHIFT sized page of texture memory the entries built from it.
+  texture_present[] is kept in step so writes to untextured pages stay cheap.*/
+static void
+voodoo_texture_index(voodoo_t *voodoo, int tmu, int c, int add)
+{
+    const texture_t *texture = &voodoo->texture_cache[tmu][c];
+    uint64_t         bit     = 1ULL << (c & 63);
+
+    for (uint8_t d = 0; d < 4; d++) {
+        uint32_t page_start = texture->addr_start[d] >> TEX_DIRTY_SHIFT;
+        uint32_t page_end   = texture->addr_end[d] >> TEX_DIRTY_SHIFT;
+
+        if (texture->addr_end[d] == 0)
+            continue;
+
+        for (uint32_t page = page_start; page <= page_end; page++) {
+            uint32_t  masked  = ((page << TEX_DIRTY_SHIFT) & voodoo->texture_mask) >> TEX_DIRTY_SHIFT;
+            uint64_t *entries = voodoo->texture_page_entries[tmu][masked];
+            uint64_t  used    = 0;
+
+            if (add)
+                entries[c >> 6] |= bit;
+            else
+                entries[c >> 6] &= ~bit;
+
+            for (uint8_t w = 0; w < TEX_CACHE_WORDS; w++)
+                used |= entries[w];
+            voodoo->texture_present[tmu][masked] = !!used;
+        }
+    }
+}
+
+/*Drops cache entry c from the hash and page index and marks it invalid.*/
+static void
+voodoo_texture_remove(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+    int       *link    = &voodoo->texture_hash[tmu][TEX_HASH(texture->base, texture->tLOD, texture->palette_checksum)];
+
+    while (*link != -1) {
+        if (*link == c) {
+            *link = texture->hash_next;
+            break;
+        }
+        link = &voodoo->texture_cache[tmu][*link].hash_next;
+    }
+
+    voodoo_texture_index(voodoo, tmu, c, 0);
+
+    texture->base      = -1;
+    texture->hash_next = -1;
+    for (uint8_t d = 0; d < 4; d++)
+        texture->addr_start[d] = texture->addr_end[d] = 0;
+}
+
 void
 voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 {
@@ -246,7 +353,8 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     int      lod_min;
     int      lod_max;
     uint32_t addr = 0;
-    uint32_t addr_end;
+    uint32_t tLOD;
+    uint32_t hash;
     uint32_t palette_checksum;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
@@ -271,21 +379,26 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     else
         addr = params->texBaseAddr[tmu];
 
+    tLOD = params->tLOD[tmu] & 0xf00fff;
+    hash = TEX_HASH(addr, tLOD, palette_checksum);
+
     /*Try to find texture in cache*/
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == (params->tLOD[tmu] & 0xf00fff) && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
+    for (c = voodoo->texture_hash[tmu][hash]; c != -1; c = voodoo->texture_cache[tmu][c].hash_next) {
+        if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == tLOD && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
             params->tex_entry[tmu] = c;
             voodoo->texture_cache[tmu][c].refcount++;
+            voodoo->texture_hits++;
             return;
         }
     }
+    voodoo->texture_misses++;
 
     /*Texture not found, search for unused texture*/
     do {
         for (c = 0; c < TEX_CACHE_MAX; c++) {
             voodoo->texture_last_removed++;
             voodoo->texture_last_removed &= (TEX_CACHE_MAX - 1);
-            if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] && (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
+            if (!voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][voodoo->texture_last_removed]))
                 break;
         }
         if (c == TEX_CACHE_MAX)
@@ -296,6 +409,13 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 
     c = voodoo->texture_last_removed;
 
+    if (voodoo->texture_cache[tmu][c].base != -1) {
+        voodoo_texture_remove(voodoo, tmu, c);
+        voodoo->texture_evictions++;
+    }
+    if (!voodoo->texture_cache[tmu][c].data)
+        voodoo->texture_cache[tmu][c].data = malloc(TEX_DATA_SIZE);
+
     if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
         voodoo->texture_cache[tmu][c].base = params->texBaseAddr1[tmu];
     else
@@ -536,15 +656,11 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     } else
         voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-    for (uint8_t d = 0; d < 4; d++) {
-        addr     = voodoo->texture_cache[tmu][c].addr_start[d];
-        addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
+    voodoo_texture_index(voodoo, tmu, c, 1);
 
-        if (addr_end != 0) {
-            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-        }
-    }
+    hash                                    = TEX_HASH(voodoo->texture_cache[tmu][c].base, voodoo->texture_cache[tmu][c].tLOD, voodoo->texture_cache[tmu][c].palette_checksum);
+    voodoo->texture_cache[tmu][c].hash_next = voodoo->texture_hash[tmu][hash];
+    voodoo->texture_hash[tmu][hash]         = c;
 
     params->tex_entry[tmu] = c;
     voodoo->texture_cache[tmu][c].refcount++;
@@ -553,39 +669,26 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 void
 flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 {
-    int wait_for_idle = 0;
+    const uint64_t *entries       = voodoo->texture_page_entries[tmu][dirty_addr >> TEX_DIRTY_SHIFT];
+    int             wait_for_idle = 0;
 
-    memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
-#if 0
-    voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
-#endif
-    for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base != -1) {
-            for (uint8_t d = 0; d < 4; d++) {
-                int addr_start = voodoo->texture_cache[tmu][c].addr_start[d];
-                int addr_end   = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0) {
-                    int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
-                    int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
-
-                    if (addr_end_masked < addr_start_masked)
-                        addr_end_masked = voodoo->texture_mask + 1;
-                    if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
+    /*Only the entries indexed against the written page are evicted, so the
+      cost of a texture upload no longer grows with the size of the cache.*/
+    for (uint8_t w = 0; w < TEX_CACHE_WORDS; w++) {
+        uint64_t mask = entries[w];
+
+        for (int c = w * 64; mask; c++, mask >>= 1) {
+            if (!(mask & 1))
+                continue;
 #if 0
-                        voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
+            voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
 #endif
 
-                        if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] || (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
-                            wait_for_idle = 1;
+            if (voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][c]))
+                wait_for_idle = 1;
 
-                        voodoo->texture_cache[tmu][c].base = -1;
-                    } else {
-                        for (; addr_start <= addr_end; addr_start += (1 << TEX_DIRTY_SHIFT))
-                            voodoo->texture_present[tmu][(addr_start & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                    }
-                }
-            }
+            voodoo_texture_remove(voodoo, tmu, c);
+            voodoo->texture_evictions++;
         }
     }
     if (wait_for_idle)
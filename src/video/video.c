@@ -73,6 +73,7 @@
 #include <86box/thread.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#include <86box/vid_svga_span.h>
 
 #include <minitrace/minitrace.h>
 
@@ -234,13 +235,28 @@ const uint32_t shade[5][256] = {
     }
 };
 
+/* The target buffer of a monitor is one of VIDEO_FRAMES frames. A blit
+   consumer may hold the frame of a blit and read it in place after the
+   blit completes; the card then draws the next frame into another one,
+   which is brought up to date with what changed since it was last drawn
+   into. */
+#define VIDEO_FRAMES 2
+
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int dirty_x, dirty_y, dirty_w, dirty_h; /* changed part of the current blit */
+    int next_dirty_x, next_dirty_y, next_dirty_w, next_dirty_h;
+    int next_dirty_set;
     int busy;
     int buffer_in_use;
     int thread_run;
     int monitor_index;
 
+    bitmap_t  *frames[VIDEO_FRAMES];
+    int        frame_stale[VIDEO_FRAMES][4]; /* x, y, w, h published since last drawn into */
+    int        frame_cur;                    /* the one target_buffer points to */
+    atomic_int frame_held;                   /* the one a consumer holds, or -1 */
+
     thread_t *blit_thread;
     event_t  *wake_blit_thread;
     event_t  *blit_complete;
@@ -294,6 +310,68 @@ video_wait_for_blit_monitor(int monitor_index)
     thread_reset_event(blit_data_ptr->blit_complete);
 }
 
+static void
+video_rect_union(int *r, int x, int y, int w, int h)
+{
+    int x2;
+    int y2;
+
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    if ((r[2] <= 0) || (r[3] <= 0)) {
+        r[0] = x;
+        r[1] = y;
+        r[2] = w;
+        r[3] = h;
+        return;
+    }
+
+    x2   = MAX(r[0] + r[2], x + w);
+    y2   = MAX(r[1] + r[3], y + h);
+    r[0] = MIN(r[0], x);
+    r[1] = MIN(r[1], y);
+    r[2] = x2 - r[0];
+    r[3] = y2 - r[1];
+}
+
+/* Makes the target buffer a frame no consumer holds, with the contents of
+   the current one. */
+static void
+video_frame_switch(int monitor_index)
+{
+    blit_data_t    *data = monitors[monitor_index].mon_blit_data_ptr;
+    const bitmap_t *cur  = data->frames[data->frame_cur];
+    bitmap_t       *next;
+    int             n     = data->frame_cur ^ 1;
+    int            *stale = data->frame_stale[n];
+    int             x1;
+    int             x2;
+    int             y2;
+
+    if ((data->frames[n] == NULL) || (data->frames[n]->w != cur->w) || (data->frames[n]->h != cur->h)) {
+        destroy_bitmap(data->frames[n]);
+        data->frames[n] = create_bitmap(cur->w, cur->h);
+        stale[0]        = 0;
+        stale[1]        = 0;
+        stale[2]        = cur->w;
+        stale[3]        = cur->h;
+    }
+    next = data->frames[n];
+
+    x1 = MAX(stale[0], 0);
+    x2 = MIN(stale[0] + stale[2], cur->w);
+    y2 = MIN(stale[1] + stale[3], cur->h);
+    if (x2 > x1) {
+        for (int y = MAX(stale[1], 0); y < y2; y++)
+            memcpy(&next->line[y][x1], &cur->line[y][x1], (x2 - x1) * sizeof(uint32_t));
+    }
+
+    memset(stale, 0, sizeof(data->frame_stale[n]));
+    data->frame_cur                       = n;
+    monitors[monitor_index].target_buffer = next;
+}
+
 void
 video_wait_for_buffer_monitor(int monitor_index)
 {
@@ -302,114 +380,341 @@ video_wait_for_buffer_monitor(int monitor_index)
     while (blit_data_ptr->buffer_in_use)
         thread_wait_event(blit_data_ptr->buffer_not_in_use, -1);
     thread_reset_event(blit_data_ptr->buffer_not_in_use);
+
+    if (atomic_load(&blit_data_ptr->frame_held) == blit_data_ptr->frame_cur)
+        video_frame_switch(monitor_index);
+}
+
+/* Called by a blit consumer from its blit handler instead of copying the
+   target buffer: returns the frame of the blit, which stays valid after
+   video_blit_complete_monitor() until video_frame_release_monitor(). A
+   consumer holds one frame at a time, this returns NULL while it does. */
+bitmap_t *
+video_frame_acquire_monitor(int monitor_index)
+{
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    int          none          = -1;
+
+    if (!atomic_compare_exchange_strong(&blit_data_ptr->frame_held, &none, blit_data_ptr->frame_cur))
+        return NULL;
+
+    return blit_data_ptr->frames[blit_data_ptr->frame_cur];
 }
 
-static png_structp png_ptr[MONITORS_NUM];
-static png_infop   info_ptr[MONITORS_NUM];
+/* May be called from any thread. */
+void
+video_frame_release_monitor(int monitor_index)
+{
+    atomic_store(&monitors[monitor_index].mon_blit_data_ptr->frame_held, -1);
+}
 
+/* Screenshots are copied out of the blit buffer into a pooled buffer and
+   queued; a worker thread converts them and runs libpng, so the blit
+   thread only pays for the copy. */
+#define SCREENSHOT_POOL 4
+
+typedef struct screenshot_t {
+    struct screenshot_t *next;
+
+    char     path[1024];
+    int      w;
+    int      h;
+    size_t   size;
+    uint32_t *buf;
+
+    void (*done)(const char *path, int success, void *priv);
+    void *priv;
+} screenshot_t;
+
+static mutex_t      *screenshot_lock;
+static event_t      *screenshot_wake;
+static thread_t     *screenshot_thread;
+static screenshot_t *screenshot_head;
+static screenshot_t *screenshot_tail;
+static screenshot_t *screenshot_pool;
+static int           screenshot_pool_num;
+static int           screenshot_stop;
+
+/* Packs 0x00RRGGBB pixels into the R, G, B byte order libpng expects. */
 static void
-video_take_screenshot_monitor(const char *fn, uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
+video_screenshot_convert(uint8_t *dst, const uint32_t *src, int n)
 {
-    png_bytep         *b_rgb         = NULL;
-    FILE              *fp            = NULL;
-    uint32_t           temp          = 0x00000000;
-    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    int i = 0;
+
+    for (; i <= (n - 4); i += 4) {
+        uint32_t p0 = src[i];
+        uint32_t p1 = src[i + 1];
+        uint32_t p2 = src[i + 2];
+        uint32_t p3 = src[i + 3];
+
+        dst[0]  = p0 >> 16;
+        dst[1]  = p0 >> 8;
+        dst[2]  = p0;
+        dst[3]  = p1 >> 16;
+        dst[4]  = p1 >> 8;
+        dst[5]  = p1;
+        dst[6]  = p2 >> 16;
+        dst[7]  = p2 >> 8;
+        dst[8]  = p2;
+        dst[9]  = p3 >> 16;
+        dst[10] = p3 >> 8;
+        dst[11] = p3;
+        dst += 12;
+    }
+
+    for (; i < n; i++) {
+        dst[0] = src[i] >> 16;
+        dst[1] = src[i] >> 8;
+        dst[2] = src[i];
+        dst += 3;
+    }
+}
+
+static int
+video_take_screenshot(const screenshot_t *shot)
+{
+    png_structp png_ptr;
+    png_infop   info_ptr;
+    png_bytep  *b_rgb;
+    uint8_t    *rgb;
+    FILE       *fp;
 
     /* create file */
-    fp = plat_fopen(fn, (const char *) "wb");
+    fp = plat_fopen(shot->path, (const char *) "wb");
     if (!fp) {
-        video_log("[video_take_screenshot] File %s could not be opened for writing", fn);
-        return;
+        video_log("[video_take_screenshot] File %s could not be opened for writing", shot->path);
+        return 0;
     }
 
     /* initialize stuff */
-    png_ptr[monitor_index] = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-    if (!png_ptr[monitor_index]) {
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
         video_log("[video_take_screenshot] png_create_write_struct failed");
         fclose(fp);
-        return;
+        return 0;
     }
 
-    info_ptr[monitor_index] = png_create_info_struct(png_ptr[monitor_index]);
-    if (!info_ptr[monitor_index]) {
+    info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
         video_log("[video_take_screenshot] png_create_info_struct failed");
+        png_destroy_write_struct(&png_ptr, NULL);
         fclose(fp);
-        return;
+        return 0;
+    }
+
+    b_rgb = (png_bytep *) malloc(sizeof(png_bytep) * shot->h);
+    rgb   = (uint8_t *) malloc((size_t) shot->w * shot->h * 3);
+    if ((b_rgb == NULL) || (rgb == NULL)) {
+        video_log("[video_take_screenshot] Unable to Allocate RGB Bitmap Memory");
+        free(b_rgb);
+        free(rgb);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        fclose(fp);
+        return 0;
     }
 
-    png_init_io(png_ptr[monitor_index], fp);
+    png_init_io(png_ptr, fp);
 
-    png_set_IHDR(png_ptr[monitor_index], info_ptr[monitor_index], blit_data_ptr->w, blit_data_ptr->h,
+    png_set_IHDR(png_ptr, info_ptr, shot->w, shot->h,
                  8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
                  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
-    b_rgb = (png_bytep *) malloc(sizeof(png_bytep) * blit_data_ptr->h);
-    if (b_rgb == NULL) {
-        video_log("[video_take_screenshot] Unable to Allocate RGB Bitmap Memory");
-        fclose(fp);
-        return;
-    }
+    /* The image is contiguous, so it is converted in one go. */
+    video_screenshot_convert(rgb, shot->buf, shot->w * shot->h);
+    for (int y = 0; y < shot->h; ++y)
+        b_rgb[y] = &rgb[(size_t) y * shot->w * 3];
+
+    png_write_info(png_ptr, info_ptr);
+
+    png_write_image(png_ptr, b_rgb);
+
+    png_write_end(png_ptr, NULL);
 
-    for (int y = 0; y < blit_data_ptr->h; ++y) {
-        b_rgb[y] = (png_byte *) malloc(png_get_rowbytes(png_ptr[monitor_index], info_ptr[monitor_index]));
-        for (int x = 0; x < blit_data_ptr->w; ++x) {
-            if (buf == NULL)
-                memset(&(b_rgb[y][x * 3]), 0x00, 3);
-            else {
-                temp                  = buf[((start_y + y) * row_len) + start_x + x];
-                b_rgb[y][x * 3]       = (temp >> 16) & 0xff;
-                b_rgb[y][(x * 3) + 1] = (temp >> 8) & 0xff;
-                b_rgb[y][(x * 3) + 2] = temp & 0xff;
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    free(b_rgb);
+    free(rgb);
+
+    fclose(fp);
+
+    return 1;
+}
+
+static void
+video_screenshot_thread(UNUSED(void *priv))
+{
+    screenshot_t *shot;
+    screenshot_t *next;
+    int           stop = 0;
+    int           ret;
+
+    while (!stop) {
+        thread_wait_event(screenshot_wake, -1);
+        thread_reset_event(screenshot_wake);
+
+        thread_wait_mutex(screenshot_lock);
+        shot            = screenshot_head;
+        screenshot_head = screenshot_tail = NULL;
+        stop            = screenshot_stop;
+        thread_release_mutex(screenshot_lock);
+
+        for (; shot != NULL; shot = next) {
+            next = shot->next;
+
+            ret = video_take_screenshot(shot);
+            if (shot->done != NULL)
+                shot->done(shot->path, ret, shot->priv);
+
+            /* Keep a few buffers around for the next screenshots. */
+            thread_wait_mutex(screenshot_lock);
+            if (screenshot_pool_num < SCREENSHOT_POOL) {
+                shot->next      = screenshot_pool;
+                screenshot_pool = shot;
+                screenshot_pool_num++;
+                shot = NULL;
+            }
+            thread_release_mutex(screenshot_lock);
+
+            if (shot != NULL) {
+                free(shot->buf);
+                free(shot);
             }
         }
     }
+}
 
-    png_write_info(png_ptr[monitor_index], info_ptr[monitor_index]);
+static screenshot_t *
+video_screenshot_get(int w, int h)
+{
+    screenshot_t  *shot = NULL;
+    screenshot_t **prev;
+    size_t         size = (size_t) w * h * sizeof(uint32_t);
+
+    /* Prefer a pooled buffer that is already large enough. */
+    thread_wait_mutex(screenshot_lock);
+    for (prev = &screenshot_pool; *prev != NULL; prev = &(*prev)->next) {
+        if ((*prev)->size >= size)
+            break;
+    }
+    if ((*prev == NULL) && (screenshot_pool != NULL))
+        prev = &screenshot_pool;
+    if (*prev != NULL) {
+        shot  = *prev;
+        *prev = shot->next;
+        screenshot_pool_num--;
+    }
+    thread_release_mutex(screenshot_lock);
 
-    png_write_image(png_ptr[monitor_index], b_rgb);
+    if (shot == NULL)
+        shot = (screenshot_t *) calloc(1, sizeof(screenshot_t));
 
-    png_write_end(png_ptr[monitor_index], NULL);
+    if (shot->size < size) {
+        free(shot->buf);
+        shot->buf  = (uint32_t *) malloc(size);
+        shot->size = size;
+    }
 
-    /* cleanup heap allocation */
-    for (int i = 0; i < blit_data_ptr->h; i++)
-        if (b_rgb[i])
-            free(b_rgb[i]);
+    shot->next = NULL;
+    shot->w    = w;
+    shot->h    = h;
 
-    if (b_rgb)
-        free(b_rgb);
+    return shot;
+}
 
-    if (fp)
-        fclose(fp);
+static void
+video_screenshot_init(void)
+{
+    screenshot_lock   = thread_create_mutex();
+    screenshot_wake   = thread_create_event();
+    screenshot_stop   = 0;
+    screenshot_thread = thread_create(video_screenshot_thread, NULL);
+}
+
+static void
+video_screenshot_close(void)
+{
+    screenshot_t *shot;
+
+    if (screenshot_thread == NULL)
+        return;
+
+    /* Pending screenshots are still written out. */
+    thread_wait_mutex(screenshot_lock);
+    screenshot_stop = 1;
+    thread_release_mutex(screenshot_lock);
+    thread_set_event(screenshot_wake);
+    thread_wait(screenshot_thread);
+    screenshot_thread = NULL;
+
+    while (screenshot_pool != NULL) {
+        shot            = screenshot_pool;
+        screenshot_pool = shot->next;
+        free(shot->buf);
+        free(shot);
+    }
+    screenshot_pool_num = 0;
+
+    thread_destroy_event(screenshot_wake);
+    thread_close_mutex(screenshot_lock);
 }
 
+/* Copies the current frame of the blit buffer and queues it for writing;
+   done, if given, is called from the worker thread once the file has
+   been written (or failed to). */
 void
-video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
+video_screenshot_monitor_ex(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index,
+                            void (*done)(const char *path, int success, void *priv), void *priv)
 {
-    char path[1024];
-    char fn[256];
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    screenshot_t      *shot;
+    char               fn[256];
+
+    shot = video_screenshot_get(blit_data_ptr->w, blit_data_ptr->h);
+
+    for (int y = 0; y < shot->h; ++y) {
+        if (buf == NULL)
+            memset(&shot->buf[y * shot->w], 0x00, shot->w * sizeof(uint32_t));
+        else
+            video_copy(&shot->buf[y * shot->w], &buf[((start_y + y) * row_len) + start_x], shot->w * sizeof(uint32_t));
+    }
+
+    atomic_fetch_sub(&monitors[monitor_index].mon_screenshots, 1);
 
     memset(fn, 0, sizeof(fn));
-    memset(path, 0, sizeof(path));
+    memset(shot->path, 0, sizeof(shot->path));
 
-    path_append_filename(path, usr_path, SCREENSHOT_PATH);
+    path_append_filename(shot->path, usr_path, SCREENSHOT_PATH);
 
-    if (!plat_dir_check(path))
-        plat_dir_create(path);
+    if (!plat_dir_check(shot->path))
+        plat_dir_create(shot->path);
 
-    path_slash(path);
-    strcat(path, "Monitor_");
-    snprintf(&path[strlen(path)], 42, "%d_", monitor_index + 1);
+    path_slash(shot->path);
+    strcat(shot->path, "Monitor_");
+    snprintf(&shot->path[strlen(shot->path)], 42, "%d_", monitor_index + 1);
 
     plat_tempfile(fn, NULL, ".png");
-    strcat(path, fn);
+    strcat(shot->path, fn);
 
-    video_log("taking screenshot to: %s\n", path);
+    video_log("taking screenshot to: %s\n", shot->path);
 
-    video_take_screenshot_monitor((const char *) path, buf, start_x, start_y, row_len, monitor_index);
-    png_destroy_write_struct(&png_ptr[monitor_index], &info_ptr[monitor_index]);
+    shot->done = done;
+    shot->priv = priv;
 
-    atomic_fetch_sub(&monitors[monitor_index].mon_screenshots, 1);
+    thread_wait_mutex(screenshot_lock);
+    if (screenshot_tail != NULL)
+        screenshot_tail->next = shot;
+    else
+        screenshot_head = shot;
+    screenshot_tail = shot;
+    thread_release_mutex(screenshot_lock);
+
+    thread_set_event(screenshot_wake);
+}
+
+void
+video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
+{
+    video_screenshot_monitor_ex(buf, start_x, start_y, row_len, monitor_index, NULL, NULL);
 }
 
 void
@@ -460,16 +765,93 @@ blit_thread(void *param)
     }
 }
 
+/* Tell the blit consumers that only the given part of the target buffer
+   changed for the next blit; a zero width or height means nothing did.
+   Without this, the whole blit is treated as changed. */
+void
+video_blit_set_dirty_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    blit_data_ptr->next_dirty_x   = x;
+    blit_data_ptr->next_dirty_y   = y;
+    blit_data_ptr->next_dirty_w   = w;
+    blit_data_ptr->next_dirty_h   = h;
+    blit_data_ptr->next_dirty_set = 1;
+}
+
+/* Called by the blit consumers from their blit handler: returns 0 if
+   nothing changed since the previous blit, otherwise the changed part of
+   the target buffer, which always lies within the blit rectangle. */
+int
+video_blit_get_dirty_monitor(int monitor_index, int *x, int *y, int *w, int *h)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *x = blit_data_ptr->dirty_x;
+    *y = blit_data_ptr->dirty_y;
+    *w = blit_data_ptr->dirty_w;
+    *h = blit_data_ptr->dirty_h;
+
+    return (*w > 0) && (*h > 0);
+}
+
+static void
+video_blit_latch_dirty(blit_data_t *data, int x, int y, int w, int h)
+{
+    int x2;
+    int y2;
+
+    if (!data->next_dirty_set || (x != data->x) || (y != data->y) || (w != data->w) || (h != data->h)) {
+        /* Not reported, or the geometry changed: everything is new. */
+        data->dirty_x = x;
+        data->dirty_y = y;
+        data->dirty_w = w;
+        data->dirty_h = h;
+    } else {
+        x2 = MIN(data->next_dirty_x + data->next_dirty_w, x + w);
+        y2 = MIN(data->next_dirty_y + data->next_dirty_h, y + h);
+
+        data->dirty_x = MAX(data->next_dirty_x, x);
+        data->dirty_y = MAX(data->next_dirty_y, y);
+        data->dirty_w = MAX(x2 - data->dirty_x, 0);
+        data->dirty_h = MAX(y2 - data->dirty_y, 0);
+    }
+
+    data->next_dirty_set = 0;
+}
+
 void
 video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
 {
+    const bitmap_t *b = monitors[monitor_index].target_buffer;
+
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
+    /* The target buffer only fits the current mode, while the screen size
+       may lag behind it. */
+    if (b != NULL) {
+        w = MIN(w, b->w - x);
+        h = MIN(h, b->h - y);
+    }
+
     if ((w <= 0) || (h <= 0))
         return;
 
     video_wait_for_blit_monitor(monitor_index);
 
+    video_blit_latch_dirty(monitors[monitor_index].mon_blit_data_ptr, x, y, w, h);
+
+    /* What changed is missing from the frames not drawn into. */
+    for (int i = 0; i < VIDEO_FRAMES; i++) {
+        blit_data_t *data = monitors[monitor_index].mon_blit_data_ptr;
+
+        if (i != data->frame_cur)
+            video_rect_union(data->frame_stale[i], data->dirty_x, data->dirty_y, data->dirty_w, data->dirty_h);
+    }
+
+    video_capture_frame(x, y, w, h, monitor_index);
+
     monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
     monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
     monitors[monitor_index].mon_blit_data_ptr->x             = x;
@@ -824,6 +1206,9 @@ destroy_bitmap(bitmap_t *b)
     if ((b != NULL) && (b->dat != NULL))
         free(b->dat);
 
+    if ((b != NULL) && (b->line != NULL))
+        free(b->line);
+
     if (b != NULL)
         free(b);
 }
@@ -831,11 +1216,12 @@ destroy_bitmap(bitmap_t *b)
 bitmap_t *
 create_bitmap(int x, int y)
 {
-    bitmap_t *b = calloc(sizeof(bitmap_t), (y * sizeof(uint32_t *)));
+    bitmap_t *b = calloc(1, sizeof(bitmap_t));
 
-    b->dat = calloc((size_t) x * y, 4);
+    b->dat  = calloc((size_t) x * y, 4);
+    b->line = calloc(y, sizeof(uint32_t *));
     for (int c = 0; c < y; c++)
-        b->line[c] = &(b->dat[c * x]);
+        b->line[c] = &(b->dat[(size_t) c * x]);
     b->w = x;
     b->h = y;
 
@@ -857,8 +1243,10 @@ video_monitor_init(int index)
     monitors[index].mon_unscaled_size_y                  = 480;
     monitors[index].mon_bpp                              = 8;
     monitors[index].mon_changeframecount                 = 2;
-    monitors[index].target_buffer                        = create_bitmap(2048, 2048);
+    monitors[index].target_buffer                        = create_bitmap(VIDEO_BUFFER_X, VIDEO_BUFFER_Y);
     monitors[index].mon_blit_data_ptr                    = calloc(1, sizeof(blit_data_t));
+    monitors[index].mon_blit_data_ptr->frames[0]         = monitors[index].target_buffer;
+    atomic_init(&monitors[index].mon_blit_data_ptr->frame_held, -1);
     monitors[index].mon_blit_data_ptr->wake_blit_thread  = thread_create_event();
     monitors[index].mon_blit_data_ptr->blit_complete     = thread_create_event();
     monitors[index].mon_blit_data_ptr->buffer_not_in_use = thread_create_event();
@@ -875,6 +1263,52 @@ video_monitor_init(int index)
     monitors[index].mon_blit_data_ptr->blit_thread = thread_create(blit_thread, monitors[index].mon_blit_data_ptr);
 }
 
+/* Makes the target buffer of the monitor fit w x h pixels, rounded up to
+   64 and never smaller than VIDEO_BUFFER_MIN_X x VIDEO_BUFFER_MIN_Y; the
+   video cards call this from the emulation thread on every mode change. Returns 1 if the buffer was
+   replaced, in which case whatever it held is lost and the caller has to
+   redraw the whole frame. */
+int
+video_monitor_size_buffer(int w, int h, int monitor_index)
+{
+    blit_data_t    *data = monitors[monitor_index].mon_blit_data_ptr;
+    const bitmap_t *b    = monitors[monitor_index].target_buffer;
+    int             n;
+
+    if (b == NULL)
+        return 0;
+
+    w = MIN(MAX((w + 63) & ~63, VIDEO_BUFFER_MIN_X), VIDEO_MAX_X);
+    h = MIN(MAX((h + 63) & ~63, VIDEO_BUFFER_MIN_Y), VIDEO_MAX_Y);
+    if ((w == b->w) && (h == b->h))
+        return 0;
+
+    video_log("Monitor %i: target buffer resized to %i x %i\n", monitor_index, w, h);
+
+    /* The blit thread might still be reading the old one, and a consumer
+       may hold it for longer; a held frame is replaced on the next switch. */
+    video_wait_for_blit_monitor(monitor_index);
+
+    n = data->frame_cur;
+    if (atomic_load(&data->frame_held) == n)
+        n ^= 1;
+    destroy_bitmap(data->frames[n]);
+    data->frames[n] = create_bitmap(w, h);
+    memset(data->frame_stale[n], 0, sizeof(data->frame_stale[n]));
+
+    /* Release the other frame too unless it is held, video_frame_switch()
+       creates it again at the new size. */
+    if (atomic_load(&data->frame_held) != (n ^ 1)) {
+        destroy_bitmap(data->frames[n ^ 1]);
+        data->frames[n ^ 1] = NULL;
+    }
+
+    data->frame_cur                       = n;
+    monitors[monitor_index].target_buffer = data->frames[n];
+
+    return 1;
+}
+
 void
 video_monitor_close(int monitor_index)
 {
@@ -889,12 +1323,13 @@ video_monitor_close(int monitor_index)
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->buffer_not_in_use);
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->blit_complete);
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
+    for (int i = 0; i < VIDEO_FRAMES; i++)
+        destroy_bitmap(monitors[monitor_index].mon_blit_data_ptr->frames[i]);
     free(monitors[monitor_index].mon_blit_data_ptr);
     if (!monitors[monitor_index].mon_pal_lookup_static)
         free(monitors[monitor_index].mon_pal_lookup);
     if (!monitors[monitor_index].mon_cga_palette_static)
         free(monitors[monitor_index].mon_cga_palette);
-    destroy_bitmap(monitors[monitor_index].target_buffer);
     monitors[monitor_index].target_buffer = NULL;
     memset(&monitors[monitor_index], 0, sizeof(monitor_t));
 }
@@ -967,6 +1402,10 @@ video_init(void)
     for (uint32_t c = 0; c < 65536; c++)
         video_16to32[c] = calc_16to32(c);
 
+    svga_span_init();
+
+    video_screenshot_init();
+
     memset(monitors, 0, sizeof(monitors));
     video_monitor_init(0);
 }
@@ -974,6 +1413,9 @@ video_init(void)
 void
 video_close(void)
 {
+    video_capture_close();
+    video_screenshot_close();
+
     video_monitor_close(0);
 
     free(video_16to32);
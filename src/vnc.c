@@ -33,18 +33,29 @@
 #include <86box/vnc.h>
 
 #define VNC_MIN_X 320
-#define VNC_MAX_X 2048
+#define VNC_MAX_X VIDEO_MAX_X
 #define VNC_MIN_Y 200
-#define VNC_MAX_Y 2048
-
-static rfbScreenInfoPtr rfb = NULL;
-static int              clients;
-static int              updatingSize;
-static int              allowedX;
-static int              allowedY;
-static int              ptr_x;
-static int              ptr_y;
-static int              ptr_but;
+#define VNC_MAX_Y VIDEO_MAX_Y
+
+#define VNC_PORT  5900 /* the first monitor; the others follow */
+
+/* Every monitor is served as its own VNC screen, on its own port. */
+typedef struct vnc_screen_t {
+    rfbScreenInfoPtr rfb;
+    int              monitor_index;
+    int              updatingSize;
+    int              fullUpdate; /* framebuffer and clients need a whole frame */
+    int              allowedX;
+    int              allowedY;
+    char            *retiredFrameBuffer; /* may still be read by a client thread */
+    char             title[128];
+    int              ptr_x; /* last pointer position and buttons sent by a client */
+    int              ptr_y;
+    int              ptr_but;
+} vnc_screen_t;
+
+static vnc_screen_t *vnc_screens[MONITORS_NUM];
+static atomic_int    clients; /* on all screens, each served by its own threads */
 
 #ifdef ENABLE_VNC_LOG
 int vnc_do_log = ENABLE_VNC_LOG;
@@ -76,9 +87,10 @@ vnc_kbdevent(rfbBool down, rfbKeySym k, rfbClientPtr cl)
 static void
 vnc_ptrevent(int but, int x, int y, rfbClientPtr cl)
 {
-    int dx;
-    int dy;
-    int b;
+    vnc_screen_t *screen = (vnc_screen_t *) cl->screen->screenData;
+    int           dx;
+    int           dy;
+    int           b;
 
     b = 0x00;
     if (but & 0x01)
@@ -88,19 +100,19 @@ vnc_ptrevent(int but, int x, int y, rfbClientPtr cl)
     if (but & 0x04)
         b |= 0x02;
     mouse_set_buttons_ex(b);
-    ptr_but = but;
+    screen->ptr_but = but;
 
-    dx = (x - ptr_x) / 0.96; /* TODO: Figure out the correct scale factor for X and Y. */
-    dy = (y - ptr_y) / 0.96;
+    dx = (x - screen->ptr_x) / 0.96; /* TODO: Figure out the correct scale factor for X and Y. */
+    dy = (y - screen->ptr_y) / 0.96;
 
     /* VNC uses absolute positions within the window, no deltas. */
     mouse_scale(dx, dy);
 
-    ptr_x = x;
-    ptr_y = y;
+    screen->ptr_x = x;
+    screen->ptr_y = y;
 
-    mouse_x_abs = (double)ptr_x / (double)allowedX;
-    mouse_y_abs = (double)ptr_y / (double)allowedY;
+    mouse_x_abs = (double)screen->ptr_x / (double)screen->allowedX;
+    mouse_y_abs = (double)screen->ptr_y / (double)screen->allowedY;
 
     if (mouse_x_abs > 1.0) mouse_x_abs = 1.0;
     if (mouse_y_abs > 1.0) mouse_y_abs = 1.0;
@@ -115,9 +127,7 @@ vnc_clientgone(UNUSED(rfbClientPtr cl))
 {
     vnc_log("VNC: client disconnected: %s\n", cl->host);
 
-    if (clients > 0)
-        clients--;
-    if (clients == 0) {
+    if (atomic_fetch_sub(&clients, 1) == 1) {
         /* No more clients, pause the emulator. */
         vnc_log("VNC: no clients, pausing..\n");
 
@@ -134,14 +144,20 @@ vnc_clientgone(UNUSED(rfbClientPtr cl))
 static enum rfbNewClientAction
 vnc_newclient(rfbClientPtr cl)
 {
+    vnc_screen_t *screen = (vnc_screen_t *) cl->screen->screenData;
+
+    /* A new client needs the whole frame, and starts with the pointer in
+       the middle of it. */
+    screen->fullUpdate = 1;
+    screen->ptr_x      = screen->allowedX / 2;
+    screen->ptr_y      = screen->allowedY / 2;
+
     /* Hook the ClientGone function so we know when they're gone. */
     cl->clientGoneHook = vnc_clientgone;
 
-    vnc_log("VNC: new client: %s\n", cl->host);
-    if (++clients == 1) {
+    vnc_log("VNC: new client on monitor %d: %s\n", screen->monitor_index + 1, cl->host);
+    if (atomic_fetch_add(&clients, 1) == 0) {
         /* Reset the mouse. */
-        ptr_x   = allowedX / 2;
-        ptr_y   = allowedY / 2;
         mouse_clear_coords();
         mouse_clear_buttons();
 
@@ -164,42 +180,55 @@ vnc_newclient(rfbClientPtr cl)
 static void
 vnc_display(rfbClientPtr cl)
 {
+    vnc_screen_t *screen = (vnc_screen_t *) cl->screen->screenData;
+
     /* Avoid race condition between resize and update. */
-    if (!updatingSize && cl->newFBSizePending) {
-        updatingSize = 1;
-    } else if (updatingSize && !cl->newFBSizePending) {
-        updatingSize = 0;
+    if (!screen->updatingSize && cl->newFBSizePending) {
+        screen->updatingSize = 1;
+    } else if (screen->updatingSize && !cl->newFBSizePending) {
+        screen->updatingSize = 0;
 
-        allowedX = rfb->width;
-        allowedY = rfb->height;
+        screen->allowedX = screen->rfb->width;
+        screen->allowedY = screen->rfb->height;
     }
 }
 
+/* The framebuffer follows the size of the emulated screen. The one it
+   replaces is kept until the next resize, as the client threads may still
+   be sending from it. */
 static void
-vnc_blit(int x, int y, int w, int h, int monitor_index)
+vnc_resize_framebuffer(vnc_screen_t *screen, int w, int h)
 {
-    if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
-        video_blit_complete_monitor(monitor_index);
+    rfbScreenInfoPtr rfb    = screen->rfb;
+    rfbPixelFormat   format = rfb->serverFormat;
+    char            *fb;
+
+    fb = (char *) malloc((size_t) w * h * 4);
+    if (fb == NULL)
         return;
-    }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    vnc_log("VNC: updating resolution of monitor %d: %dx%d\n", screen->monitor_index + 1, w, h);
 
-    if (screenshots)
-        video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
+    free(screen->retiredFrameBuffer);
+    screen->retiredFrameBuffer = rfb->frameBuffer;
 
-    video_blit_complete_monitor(monitor_index);
+    if (rfb->clientHead == NULL) {
+        screen->allowedX = w;
+        screen->allowedY = h;
+    } else {
+        screen->allowedX = MIN(rfb->width, w);
+        screen->allowedY = MIN(rfb->height, h);
+    }
 
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+    rfbNewFramebuffer(rfb, fb, w, h, 8, 3, 4);
+    rfb->serverFormat  = format;
+    screen->fullUpdate = 1;
 }
 
-/* Initialize VNC for operation. */
-int
-vnc_init(UNUSED(void *arg))
+static vnc_screen_t *
+vnc_screen_create(int monitor_index, int w, int h)
 {
-    static char    title[128];
+    vnc_screen_t  *screen;
     rfbPixelFormat rpf = {
         /*
          * Screen format:
@@ -213,39 +242,135 @@ vnc_init(UNUSED(void *arg))
         32, 32, 0, 1, 255, 255, 255, 16, 8, 0, 0, 0
     };
 
-    plat_pause(1);
-    cgapal_rebuild_monitor(0);
+    screen = (vnc_screen_t *) calloc(1, sizeof(vnc_screen_t));
+    if (screen == NULL)
+        return NULL;
+
+    wcstombs(screen->title, ui_window_title(NULL), sizeof(screen->title));
+    if (monitor_index > 0) {
+        snprintf(screen->title + strlen(screen->title), sizeof(screen->title) - strlen(screen->title),
+                 " (monitor %d)", monitor_index + 1);
+    }
+    screen->monitor_index = monitor_index;
+    screen->fullUpdate    = 1;
+    screen->allowedX      = w;
+    screen->allowedY      = h;
+
+    /* Encodings (hextile, ZRLE, tight...) are negotiated with every client
+       by the library, and each client gets its own modified region. */
+    screen->rfb              = rfbGetScreen(0, NULL, w, h, 8, 3, 4);
+    screen->rfb->desktopName = screen->title;
+    screen->rfb->frameBuffer = (char *) malloc((size_t) w * h * 4);
+    screen->rfb->screenData  = screen;
+    screen->rfb->port        = VNC_PORT + monitor_index;
+    screen->rfb->ipv6port    = VNC_PORT + monitor_index;
+
+    screen->rfb->serverFormat  = rpf;
+    screen->rfb->alwaysShared  = TRUE;
+    screen->rfb->displayHook   = vnc_display;
+    screen->rfb->ptrAddEvent   = vnc_ptrevent;
+    screen->rfb->kbdAddEvent   = vnc_kbdevent;
+    screen->rfb->newClientHook = vnc_newclient;
+
+    rfbInitServer(screen->rfb);
+
+    /* Serve it from a thread of its own. */
+    rfbRunEventLoop(screen->rfb, -1, TRUE);
+
+    vnc_log("VNC: monitor %d on port %d\n", monitor_index + 1, VNC_PORT + monitor_index);
+
+    return screen;
+}
+
+static void
+vnc_screen_close(vnc_screen_t *screen)
+{
+    free(screen->rfb->frameBuffer);
+    free(screen->retiredFrameBuffer);
+
+    rfbScreenCleanup(screen->rfb);
+
+    free(screen);
+}
+
+static void
+vnc_blit(int x, int y, int w, int h, int monitor_index)
+{
+    vnc_screen_t    *screen = vnc_screens[monitor_index];
+    const bitmap_t  *target = monitors[monitor_index].target_buffer;
+    rfbScreenInfoPtr rfb;
+    int              dx;
+    int              dy;
+    int              dw;
+    int              dh;
+
+    if ((x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (target == NULL)) {
+        if (screen != NULL)
+            screen->fullUpdate = 1;
+        video_blit_complete_monitor(monitor_index);
+        return;
+    }
+
+    /* The other monitors get their screen once they show something. */
+    if (screen == NULL) {
+        screen = vnc_screens[monitor_index] = vnc_screen_create(monitor_index, w, h);
+        if (screen == NULL) {
+            video_blit_complete_monitor(monitor_index);
+            return;
+        }
+    }
+    rfb = screen->rfb;
 
-    if (rfb == NULL) {
-        wcstombs(title, ui_window_title(NULL), sizeof(title));
-        updatingSize = 0;
-        allowedX     = scrnsz_x;
-        allowedY     = scrnsz_y;
+    if ((w != rfb->width) || (h != rfb->height))
+        vnc_resize_framebuffer(screen, w, h);
 
-        rfb              = rfbGetScreen(0, NULL, VNC_MAX_X, VNC_MAX_Y, 8, 3, 4);
-        rfb->desktopName = title;
-        rfb->frameBuffer = (char *) malloc(VNC_MAX_X * VNC_MAX_Y * 4);
+    if (screen->fullUpdate) {
+        dx = x;
+        dy = y;
+        dw = w;
+        dh = h;
+    } else if (!video_blit_get_dirty_monitor(monitor_index, &dx, &dy, &dw, &dh))
+        dw = dh = 0;
 
-        rfb->serverFormat  = rpf;
-        rfb->alwaysShared  = TRUE;
-        rfb->displayHook   = vnc_display;
-        rfb->ptrAddEvent   = vnc_ptrevent;
-        rfb->kbdAddEvent   = vnc_kbdevent;
-        rfb->newClientHook = vnc_newclient;
+    /* Only the lines that changed are copied; the rest of the framebuffer
+       still holds the previous frame. */
+    for (int row = dy - y; row < (dy - y + dh); ++row)
+        video_copy(&(((uint8_t *) rfb->frameBuffer)[(row * rfb->paddedWidthInBytes) + ((dx - x) * sizeof(uint32_t))]), &(target->line[y + row][dx]), dw * sizeof(uint32_t));
 
-        /* Set up our current resolution. */
-        rfb->width  = allowedX;
-        rfb->height = allowedY;
+    if (monitors[monitor_index].mon_screenshots)
+        video_screenshot_monitor((uint32_t *) rfb->frameBuffer, 0, 0, rfb->paddedWidthInBytes / sizeof(uint32_t), monitor_index);
 
-        rfbInitServer(rfb);
+    video_blit_complete_monitor(monitor_index);
+
+    /* Marking adds to the modified region of every client of the screen,
+       so each gets what changed since its own last update. */
+    if (screen->updatingSize)
+        screen->fullUpdate = 1;
+    else if (screen->fullUpdate) {
+        rfbMarkRectAsModified(rfb, 0, 0, screen->allowedX, screen->allowedY);
+        screen->fullUpdate = 0;
+    } else if (dw && dh && ((dx - x) < screen->allowedX) && ((dy - y) < screen->allowedY))
+        rfbMarkRectAsModified(rfb, dx - x, dy - y, MIN(dx - x + dw, screen->allowedX), MIN(dy - y + dh, screen->allowedY));
+}
 
-        rfbRunEventLoop(rfb, -1, TRUE);
+/* Initialize VNC for operation. */
+int
+vnc_init(UNUSED(void *arg))
+{
+    plat_pause(1);
+    cgapal_rebuild_monitor(0);
+
+    if (vnc_screens[0] == NULL) {
+        vnc_screens[0] = vnc_screen_create(0, scrnsz_x, scrnsz_y);
+        if (vnc_screens[0] == NULL)
+            return 0;
     }
 
     /* Set up our BLIT handlers. */
+    vnc_screens[0]->fullUpdate = 1;
     video_setblit(vnc_blit);
 
-    clients = 0;
+    atomic_store(&clients, 0);
 
     vnc_log("VNC: init complete.\n");
 
@@ -257,22 +382,18 @@ vnc_close(void)
 {
     video_setblit(NULL);
 
-    if (rfb != NULL) {
-        free(rfb->frameBuffer);
-
-        rfbScreenCleanup(rfb);
-
-        rfb = NULL;
+    for (int i = 0; i < MONITORS_NUM; i++) {
+        if (vnc_screens[i] != NULL) {
+            vnc_screen_close(vnc_screens[i]);
+            vnc_screens[i] = NULL;
+        }
     }
 }
 
 void
 vnc_resize(int x, int y)
 {
-    rfbClientIteratorPtr iterator;
-    rfbClientPtr         cl;
-
-    if (rfb == NULL)
+    if (vnc_screens[0] == NULL)
         return;
 
     /* TightVNC doesn't like certain sizes.. */
@@ -281,22 +402,8 @@ vnc_resize(int x, int y)
         return;
     }
 
-    if ((x != rfb->width || y != rfb->height) && x > 160 && y > 0) {
-        vnc_log("VNC: updating resolution: %dx%d\n", x, y);
-
-        allowedX = (rfb->width < x) ? rfb->width : x;
-        allowedY = (rfb->width < y) ? rfb->width : y;
-
-        rfb->width  = x;
-        rfb->height = y;
-
-        iterator = rfbGetClientIterator(rfb);
-        while ((cl = rfbClientIteratorNext(iterator)) != NULL) {
-            LOCK(cl->updateMutex);
-            cl->newFBSizePending = 1;
-            UNLOCK(cl->updateMutex);
-        }
-    }
+    /* The framebuffer itself follows the next blit. */
+    vnc_screens[0]->fullUpdate = 1;
 }
 
 /* Tell them to pause if we have no clients. */
@@ -310,4 +417,8 @@ void
 vnc_take_screenshot(UNUSED(wchar_t *fn))
 {
     vnc_log("VNC: take_screenshot\n");
+
+    /* Taken and written out by the blit path, like the other renderers. */
+    atomic_fetch_add(&monitors[0].mon_screenshots, 1);
+    device_force_redraw();
 }